@@ -0,0 +1,51 @@
+#ifndef BINNED_MATRIX_HPP
+#define BINNED_MATRIX_HPP
+
+#include "matrix.hpp"
+#include "dense_matrix.hpp"
+#include <cstdint>
+#include <vector>
+
+// BinnedMatrix is a quantized copy of a dataset, used for approximate
+// (histogram based) split finding in decision trees.
+// Every column of the dataset is divided into at most 256 bins, such that
+// each bin holds roughly the same number of rows (quantile bins). A value
+// is then represented by the ID of its bin, which fits in a single byte.
+// The bins of a column are separated by thresholds, which are values
+// taken from the column itself. For a value x of column j:
+//   bin(x) <= b  if and only if  x < threshold[j][b]
+// Hence, a split of the bins of a column into (0..b) and (b+1..) is the
+// same as the split "x[j] < threshold[j][b]" of a regular decision tree.
+
+class BinnedMatrix
+{
+    size_t m_numRows;
+    size_t m_numColumns;
+    // Bin IDs, stored row after row.
+    std::vector<uint8_t> m_bins;
+    // m_thresholds[j] holds the (ascending) thresholds of column j.
+    std::vector<std::vector<double> > m_thresholds;
+    // m_binOffsets[j] is the position of the first bin of column j among
+    // the bins of all columns; used for laying out histograms.
+    std::vector<size_t> m_binOffsets;
+    template<typename T>
+    void build(const BasicMatrixView<T>& X, size_t maxNumBins);
+public:
+    static const size_t MAX_NUM_BINS = 256;
+
+    BinnedMatrix();
+    BinnedMatrix(const Matrix& X, size_t maxNumBins=MAX_NUM_BINS);
+    BinnedMatrix(const MatrixView& X, size_t maxNumBins=MAX_NUM_BINS);
+    // The thresholds of single precision values are exact in double.
+    BinnedMatrix(const FloatMatrixView& X, size_t maxNumBins=MAX_NUM_BINS);
+    size_t getNumRows() const;
+    size_t getNumColumns() const;
+    size_t getNumBins(size_t column) const;
+    size_t getTotalNumBins() const;
+    size_t getBinOffset(size_t column) const;
+    uint8_t getBin(size_t row, size_t column) const;
+    const uint8_t* getRow(size_t row) const;
+    double getThreshold(size_t column, size_t bin) const;
+};
+
+#endif
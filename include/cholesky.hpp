@@ -0,0 +1,20 @@
+#ifndef CHOLESKY_HPP
+#define CHOLESKY_HPP
+
+#include <cstddef>
+
+// Cholesky factorization A = L * L-transpose of a symmetric positive
+// definite n x n matrix, stored row-major, and the solution of A x = b from
+// the factor. This is the way to solve the normal equations of least-squares
+// problems: it takes half the work of an LU factorization, is numerically
+// stable for positive definite matrices, and never forms the inverse.
+
+// Only the lower triangle of A is read; it is overwritten by L (the upper
+// triangle is left as is). Returns false if A is not (numerically) positive
+// definite, in which case A is left partly overwritten.
+bool choleskyDecompose(double* A, size_t n);
+
+// Solves (L * L-transpose) x = b in place: b receives x.
+void choleskySolve(const double* L, size_t n, double* b);
+
+#endif
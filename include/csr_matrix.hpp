@@ -0,0 +1,69 @@
+#ifndef CSR_MATRIX_HPP
+#define CSR_MATRIX_HPP
+
+#include "matrix.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CsrMatrix is a sparse matrix in compressed sparse row (CSR) format: only
+// the nonzero values are stored, row after row, each with its column.
+// Row i holds the values [rowOffsets[i], rowOffsets[i + 1]) of the values
+// and columns arrays, with ascending columns. For data that is mostly
+// zeros (text, one-hot encoded categories), passes over the rows cost in
+// proportion to the number of nonzeros, not to the number of columns, and
+// millions of columns fit in memory.
+// Columns are stored as 32 bit integers, which halves their memory.
+
+class CsrMatrix
+{
+    size_t m_numColumns;
+    std::vector<size_t> m_rowOffsets;
+    std::vector<uint32_t> m_columns;
+    std::vector<double> m_values;
+public:
+    // An empty matrix of numColumns columns, to be filled by addRow.
+    explicit CsrMatrix(size_t numColumns=0);
+    // Keeps the nonzero values of X.
+    explicit CsrMatrix(const Matrix& X);
+    // Appends a row of numValues nonzero values, with ascending columns.
+    void addRow(const uint32_t* columns, const double* values, size_t numValues);
+    size_t getNumRows() const
+    {
+        return m_rowOffsets.size() - 1;
+    }
+    size_t getNumColumns() const
+    {
+        return m_numColumns;
+    }
+    size_t getNumNonZeros() const
+    {
+        return m_values.size();
+    }
+    size_t getRowSize(size_t row) const
+    {
+        return m_rowOffsets[row + 1] - m_rowOffsets[row];
+    }
+    const uint32_t* getRowColumns(size_t row) const
+    {
+        return m_columns.data() + m_rowOffsets[row];
+    }
+    const double* getRowValues(size_t row) const
+    {
+        return m_values.data() + m_rowOffsets[row];
+    }
+    // bias + row . weights
+    double getScore(size_t row, const double* weights, double bias) const
+    {
+        const uint32_t* columns = getRowColumns(row);
+        const double* values = getRowValues(row);
+        double z = bias;
+        for(size_t k = 0; k < getRowSize(row); k++)
+        {
+            z += values[k] * weights[columns[k]];
+        }
+        return z;
+    }
+};
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef DATA_SOURCE_HPP
+#define DATA_SOURCE_HPP
+
+#include "matrix.hpp"
+#include "vectr.hpp"
+#include "dense_matrix.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A DataChunk is a block of consecutive rows of a dataset: the features,
+// row-major, and the targets.
+
+struct DataChunk
+{
+    std::vector<double> features;
+    Vector targets;
+    size_t numRows;
+    size_t numColumns;
+
+    DataChunk();
+    MatrixView getView() const;
+};
+
+// A DataSource yields the rows of a dataset, chunk after chunk, without
+// holding the whole dataset in memory; it is read again from the start for
+// every epoch of training.
+
+class DataSource
+{
+public:
+    virtual ~DataSource() {}
+    virtual size_t getNumColumns() const = 0;
+    // Goes back to the first row.
+    virtual void rewind() = 0;
+    // Reads the next (at most) maxNumRows rows into chunk, reusing its
+    // memory (the targets are only reallocated when the number of rows
+    // changes, as for the last chunk of a pass). Returns false, with an
+    // empty chunk, once all rows were read.
+    virtual bool readChunk(size_t maxNumRows, DataChunk& chunk) = 0;
+};
+
+// CsvDataSource reads comma-separated lines of numColumns features followed
+// by the target, as written by writeXYData. The number of columns is taken
+// from the first line; lines with another number of values, or with values
+// that are not numbers (like a header line), are skipped.
+
+class CsvDataSource: public DataSource
+{
+    std::ifstream m_file;
+    std::string m_line;
+    size_t m_numColumns;
+    size_t m_numSkippedLines;
+    std::vector<double> m_values;
+    std::vector<double> m_targets;
+    bool parseLine();
+public:
+    explicit CsvDataSource(const std::string& fileName);
+    bool isOpen() const;
+    // Lines skipped so far, for having the wrong number of values.
+    size_t getNumSkippedLines() const;
+    virtual size_t getNumColumns() const;
+    virtual void rewind();
+    virtual bool readChunk(size_t maxNumRows, DataChunk& chunk);
+};
+
+// BinaryDataSource reads the binary format written by writeBinaryData: a
+// header (the 8 bytes "MLROWS01", then the number of columns as a uint64),
+// followed by the rows, each of them numColumns features and the target, as
+// doubles in the byte order of the machine. Rows are read in large blocks,
+// with no parsing, which is much faster than CSV.
+
+class BinaryDataSource: public DataSource
+{
+    FILE* m_file;
+    size_t m_numColumns;
+    std::vector<double> m_buffer;
+    std::vector<double> m_targets;
+public:
+    static const size_t HEADER_SIZE = 16;
+
+    explicit BinaryDataSource(const std::string& fileName);
+    ~BinaryDataSource();
+    BinaryDataSource(const BinaryDataSource&) = delete;
+    BinaryDataSource& operator=(const BinaryDataSource&) = delete;
+    bool isOpen() const;
+    virtual size_t getNumColumns() const;
+    virtual void rewind();
+    virtual bool readChunk(size_t maxNumRows, DataChunk& chunk);
+};
+
+// Writes X and y in the format of BinaryDataSource; returns false if the
+// file could not be written.
+bool writeBinaryData(const MatrixView& X, const Vector& y, const std::string& fileName);
+
+// ChunkPrefetcher reads the chunks of a DataSource ahead of their use, in a
+// thread of its own, with double buffering: while the caller works on chunk
+// k, chunk k + 1 is read into the other buffer. Reading from disk (and
+// parsing) thus overlaps with training, instead of adding to it.
+// During a pass, the source belongs to the prefetcher's thread: it must not
+// be read otherwise until the pass is over (or the prefetcher is restarted
+// or destroyed).
+
+class ChunkPrefetcher
+{
+    DataSource& m_source;
+    size_t m_chunkSize;
+    DataChunk m_chunks[2];
+    // Chunks read by the thread, taken by the caller, and released by the
+    // caller (given back for reading), since the start of the pass.
+    size_t m_numReadChunks;
+    size_t m_numTakenChunks;
+    size_t m_numReleasedChunks;
+    bool m_isEndReached;
+    bool m_stop;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    void readLoop();
+    void stop();
+public:
+    ChunkPrefetcher(DataSource& source, size_t chunkSize);
+    ~ChunkPrefetcher();
+    ChunkPrefetcher(const ChunkPrefetcher&) = delete;
+    ChunkPrefetcher& operator=(const ChunkPrefetcher&) = delete;
+    // Starts a pass over the source, from its first row.
+    void start();
+    // The next chunk of the pass, valid until the next call; nullptr once
+    // all the chunks were returned.
+    const DataChunk* next();
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef DECISION_TREE_HPP
+#define DECISION_TREE_HPP
+
+#include "vectr.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// DecisionTree is a tree data structure and the forms the core
+// of the decision tree solution process. Unlike weights and bias terms
+// in other machine learning models, the decision tree solver constructs
+// a tree data structure from the training data.
+// A node of a DecisionTree will either be:
+//   - an internal node which will branch into left and right nodes; or
+//   - a leaf node which will NOT branch into left and right nodes.
+// An internal node is associated with a condition based on:
+//   - a particular column of input vector; and
+//   - a split-value.
+// Basically the internal node's condition is as follows:
+// if input-vector[column] < split-value, follow left node, otherwise right.
+// A leaf node is a terminal node and is associated with a value, which is
+// used as the target for the input-vector.
+//
+// Layout:
+// Rather than allocating every node separately and linking them through
+// pointers, all the nodes are stored in a few flat arrays (a structure of
+// arrays), indexed by node ID. The root is node 0. A node takes 16 bytes:
+//   - column (4 bytes): the column of the condition of an internal node;
+//   - child (4 bytes): ID of the left child of an internal node. The two
+//     children of a node are always stored next to each other, so the
+//     right child is (child + 1). As the root is nobody's child, a child
+//     ID of 0 marks a leaf node.
+//   - value (8 bytes): the split-value of an internal node, or the target
+//     value of a leaf node.
+// Walking the tree is then a simple loop over array lookups, and the whole
+// tree is released at once, without any recursion.
+//
+// Batched prediction:
+// getValues advances a batch of rows through the tree together, one level
+// at a time. Rows are independent, so the memory accesses of the rows of
+// a batch overlap rather than waiting on each other. The child of a node is
+// selected without branching on the data (a row that reached a leaf just
+// stays there), and the nodes of the next level are prefetched.
+
+class DecisionTree
+{
+    std::vector<uint32_t> m_columns;
+    std::vector<uint32_t> m_children;
+    std::vector<double> m_values;
+    template<typename T>
+    double getRowValue(const T* x) const;
+    template<typename T>
+    void getBatchValues(const T* const* rows, size_t numRows, double* values) const;
+public:
+    // Number of rows advanced through the tree together by getValues.
+    static const size_t BATCH_SIZE = 16;
+
+    DecisionTree();
+    // Removes all nodes and adds a root node, which is a leaf to begin with.
+    void reset(size_t expectedNumNodes=1);
+    size_t getNumNodes() const;
+    bool isLeaf(size_t node) const;
+    size_t getColumn(size_t node) const;
+    size_t getLeftChild(size_t node) const;
+    size_t getRightChild(size_t node) const;
+    // Split-value of an internal node, or target value of a leaf node.
+    double getNodeValue(size_t node) const;
+    void setLeaf(size_t node, double value);
+    // Turns a leaf node into an internal node, by appending its two
+    // children (as leaf nodes). Returns the ID of the left child.
+    size_t setSplit(size_t node, size_t column, double splitValue);
+    // Replaces a leaf node by a copy of another tree, whose nodes (other
+    // than its root) are appended to this tree.
+    void setSubtree(size_t node, const DecisionTree& subtree);
+    double getValue(const double* x) const;
+    double getValue(const Vector& x) const;
+    // A single precision row is compared with the (double) split-values as
+    // is, as if it had been converted to double.
+    double getValue(const float* x) const;
+    // values[k] = getValue(rows[k]), for k < numRows.
+    void getValues(const double* const* rows, size_t numRows, double* values) const;
+    void getValues(const float* const* rows, size_t numRows, double* values) const;
+    std::string getText(size_t node) const;
+    void describe() const;
+    // C++ source of a standalone function, extern "C" double
+    // functionName(const double* x), which evaluates the tree as nested
+    // comparisons against inlined constants (printed with 17 significant
+    // digits, so that they are read back exactly).
+    std::string getSource(const std::string& functionName) const;
+};
+
+#endif
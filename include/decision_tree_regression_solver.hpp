@@ -2,37 +2,16 @@
 #define DECISION_TREE_REGRESSION_SOLVER_HPP
 
 #include "base_solver.hpp"
-
-// DecisionTree is a tree data structure and the forms the core
-// of the decision tree solution process. Unlike weights and bias terms
-// in other machine learning models, the decision tree solver constructs
-// a tree data structure from the training data.
-// A DecisionTree object will either be:
-//   - an internal node which will branch into left and right nodes; or
-//   - a leaf node which will NOT branch into left and right nodes.
-// An internal node is associated with a condition based on:
-//   - a particular column of input vector; and
-//   - a split-value.
-// Basically the internal node's condition is as follows:
-// if input-vector[column] < split-value, follow left node, otherwise right.
-// A leaf node is a terminal node and is associated with a value, which is
-// used as the target for the input-vector.
-
-struct DecisionTree
-{
-    size_t column;
-    double splitValue;
-    double value;
-    bool isLeaf;
-    DecisionTree* left;
-    DecisionTree* right;
-
-    DecisionTree();
-    ~DecisionTree();
-    double getValue(const Vector& x) const;
-    std::string getText() const;
-    void describe(std::string indent="") const;
-};
+#include "decision_tree.hpp"
+#include "binned_matrix.hpp"
+#include "dense_matrix.hpp"
+#include "feature_histogram.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 // DecisionTreeRegressionSolver is the class that can be used
 // to create a decision tree for a regression problem. Basically
@@ -48,24 +27,190 @@ struct DecisionTree
 // subset is greater than the maximum leaf size, the node gets to have
 // left and right branching. Otherwise, it is associated with a target
 // value equal to the mean of the target values associated with subset. 
+// By default, splits are searched exactly, over all the distinct values of
+// every column. In histogram mode, the dataset is quantized once into a
+// BinnedMatrix and splits are only searched at bin boundaries, using the
+// per-bin sums of the target values; this is much cheaper for large datasets.
+// The tree can be built by several threads: the split search of a large node
+// is spread over its columns, and large subtrees are built as separate tasks
+// (into trees of their own, which are then attached to their parents). Which
+// subtrees become separate tasks only depends on their sizes, so the same
+// tree, node for node, is obtained with any number of threads.
+// For ensembles (like random forests), a tree can be built from a sample of
+// the rows (with repetitions, as in bootstrap samples), reusing the sorted
+// columns or the binned matrix of the whole dataset, and each node can be
+// made to search a random subset of the columns only.
+// Trees are grown depth-first by default. With level-wise growth, all the
+// nodes of a depth (the frontier) are split together, from a single pass
+// over the data: every training row is mapped to its frontier node, and the
+// statistics of all frontier nodes are accumulated while sweeping the rows
+// (in histogram mode) or the presorted column lists (in exact mode) in
+// order. The data is then read sequentially, depth after depth, rather than
+// through the shuffled index lists of every node. Level-wise growth also
+// honours a budget on the number of leaves, by splitting the frontier nodes
+// with the largest gains first.
 
 class DecisionTreeRegressionSolver: virtual public BaseSolver
 {
     // Leaf nodes should not have more elements than this number.
     size_t m_maxLeafSize;
-    DecisionTree* m_tree;
-    size_t m_nodeCount;
+    DecisionTree m_tree;
+    std::atomic<size_t> m_nodeCount;
     bool m_verbose;
+    std::mutex m_logMutex;
+    // Workspace, allocated once per solve, so that building a node does not
+    // allocate memory:
+    // - Two buffers of row index lists. A node owns the same [begin, end)
+    //   range of every list. A node at depth d reads its lists from buffer
+    //   (d % 2), and partitions them into buffer ((d + 1) % 2), where its
+    //   children find them. In exact mode, there is one list per column,
+    //   sorted by that column; in histogram mode, a single list.
+    // - Flags marking the rows that go to the left child of a node. Bytes
+    //   rather than bits, as different threads set the flags of (different)
+    //   rows at the same time.
+    std::vector<size_t> m_indexBuffers[2];
+    size_t m_numSampleRows;
+    std::vector<char> m_goesLeft;
+    // Level-wise growth: frontier node of every row (or NO_NODE).
+    std::vector<uint32_t> m_rowNodes;
+    std::shared_ptr<ThreadPool> m_threadPool;
 
-    void buildDecisionTree(const Matrix& X, const Vector& y, const std::vector<size_t>& indicesToInspect, DecisionTree* tree);
+    // Number of columns searched at each node; 0 implies all columns.
+    size_t m_numFeaturesPerSplit;
+    uint64_t m_seed;
+    // Further stopping criteria: nodes at depth maxDepth (if not 0) become
+    // leaves, and so do nodes whose best split decreases the RSS by less
+    // than minGain (if greater than 0).
+    size_t m_maxDepth;
+    double m_minGain;
+    // Value of the leaf reached by each training row, during the last solve.
+    std::vector<double> m_trainingPredictions;
+
+    void log(const std::string& message);
+    void beginSolve(size_t numRows, size_t numDatasetRows);
+    bool canSplit(size_t numRows, size_t depth) const;
+    bool isGainSufficient(double minRSSVal, double ysum, size_t numRows) const;
+    void setLeaf(DecisionTree& tree, size_t node, const size_t* rows, size_t numRows, double ysum);
+    void allocateIndexBuffers(size_t numLists, size_t numSampleRows, size_t numDatasetRows);
+    void releaseIndexBuffers();
+    size_t* getIndices(size_t depth, size_t list, size_t begin);
+    // The columns whose splits are searched at a node. The nodeSeed of a
+    // node is derived from its parent's, so the choice does not depend on
+    // the order in which the nodes are built.
+    const std::vector<size_t>& getSplitCandidateColumns(size_t numColumns, uint64_t nodeSeed) const;
+
+    // begin, end: the range of the node in the index lists
+    void buildDecisionTree(const MatrixView& X, const Vector& y, size_t begin, size_t end, DecisionTree& tree, size_t node, size_t depth, uint64_t nodeSeed);
+
+    bool m_useHistograms;
+    size_t m_maxNumBins;
+    // Depth-first histogram mode: nodes with fewer rows than this find their
+    // splits from their rows, without histograms.
+    size_t m_histogramMinRows;
+    // pHistogram: the histogram of the node's rows, or null for the nodes of
+    // fewer than m_histogramMinRows rows
+    void buildHistogramDecisionTree(const BinnedMatrix& Xb, const Vector& y, size_t begin, size_t end, const FeatureHistogram* pHistogram, DecisionTree& tree, size_t node, size_t depth, uint64_t nodeSeed);
+
+    bool m_levelWise;
+    // 0 implies no limit on the number of leaves.
+    size_t m_maxNumLeaves;
+    // A node of the frontier of level-wise growth, and its best split.
+    struct LevelNode
+    {
+        size_t node;
+        uint64_t seed;
+        double ysum;
+        size_t count;
+        size_t column;
+        double splitValue;
+        double rss;
+        // Histogram mode: rows whose bin is below numLeftBins go left.
+        size_t numLeftBins;
+        // Statistics of the left child; numLeft is 0 if the node is not split.
+        double leftSum;
+        size_t numLeft;
+    };
+    // Level-wise growth in exact mode: workspace of the column sweeps, sized
+    // once per solve for the largest possible frontier. Each sweep task (one
+    // per thread) keeps the best split of every frontier node over its
+    // columns, and the running sums of the column it sweeps.
+    struct LevelSweepState
+    {
+        double leftSum;
+        size_t leftCount;
+        double lastValue;
+        bool isCandidate;
+    };
+    std::vector<LevelNode> m_levelSplits;
+    std::vector<LevelSweepState> m_levelSweepStates;
+    // Sorted candidate columns of every frontier node, with feature
+    // subsampling.
+    std::vector<size_t> m_levelCandidates;
+    size_t getMaxFrontierSize(size_t numSampleRows) const;
+    std::vector<LevelNode> getLevelRoot(const Vector& y, const std::vector<size_t>& sampleCounts);
+    void selectLevelSplits(std::vector<LevelNode>& frontier, size_t& numLeaves) const;
+    // Splits the tree nodes of the frontier as selected, turns the others into
+    // leaves, and returns the next frontier. firstChildren receives the
+    // position of every node's left child in the next frontier (or NO_NODE).
+    std::vector<LevelNode> growLevel(const std::vector<LevelNode>& frontier, std::vector<uint32_t>& firstChildren);
+    // sampleCounts[i]: the number of times row i is in the sample
+    void buildLevelWiseDecisionTree(const MatrixView& X, const Vector& y, const std::vector<size_t>& sampleCounts, const std::vector<std::vector<size_t> >& columnSortedIndices);
+    void buildLevelWiseHistogramDecisionTree(const BinnedMatrix& Xb, const Vector& y, const std::vector<size_t>& sampleCounts);
+    template<typename T>
+    Vector predictView(const BasicMatrixView<T>& X) const;
 public:
+    // Nodes with at least this many rows search their columns in parallel.
+    static const size_t PARALLEL_SPLIT_SEARCH_MIN_ROWS = 20000;
+    // Subtrees with at least this many rows are built as separate tasks.
+    static const size_t PARALLEL_SUBTREE_MIN_ROWS = 2000;
+    static const uint32_t NO_NODE = UINT32_MAX;
+    // Default of setHistogramMinRows: below about this many rows, sorting
+    // the bins of the rows of a node is faster than building and scanning its
+    // histogram (see testHistogramSmallNodes).
+    static const size_t HISTOGRAM_MIN_ROWS = 32;
+
     DecisionTreeRegressionSolver(size_t maxLeafSize=5, bool verbose=false);
     ~DecisionTreeRegressionSolver();
     size_t getNodeCount() const;
+    void setHistogramMode(bool useHistograms, size_t maxNumBins=BinnedMatrix::MAX_NUM_BINS);
+    // In depth-first histogram mode, the nodes with fewer rows than
+    // histogramMinRows search their splits by sorting the bins of their rows
+    // instead: the cost of a histogram grows with the number of bins of the
+    // dataset, whatever the size of the node. Both find the same splits.
+    void setHistogramMinRows(size_t histogramMinRows);
+    void setNumThreads(size_t numThreads);
+    void setFeatureSubsampling(size_t numFeaturesPerSplit, uint64_t seed);
+    void setMaxDepth(size_t maxDepth);
+    void setMinGain(double minGain);
+    // Switches between depth-first (default) and level-wise growth;
+    // maxNumLeaves (if not 0) only applies to level-wise growth.
+    void setLevelWiseGrowth(bool levelWise, size_t maxNumLeaves=0);
+    // Prediction of the tree for every row of the dataset that was used in
+    // the last solve, indexed by row (0 for the rows not in the sample);
+    // this avoids running the training rows through the tree again.
+    const std::vector<double>& getTrainingPredictions() const;
+    const DecisionTree& getTree() const;
     void describeTree() const;
+    // Writes the tree as a standalone C++ function (see DecisionTree::getSource),
+    // which the "tree" make target compiles into a shared object. Returns false
+    // if the file could not be written.
+    bool exportSource(const std::string& fileName, const std::string& functionName="predict_tree") const;
+    // X is converted into a DenseMatrix once; the tree is built from a view.
     virtual void solve(const Matrix& X, const Vector& y);
+    void solve(const MatrixView& X, const Vector& y);
+    // Exact mode: builds the tree from the given rows of X, which may
+    // repeat. columnSortedIndices[j] must hold all the row indices of X,
+    // sorted by column j (see getColumnSortedIndices).
+    void solve(const Matrix& X, const Vector& y, const std::vector<size_t>& rows, const std::vector<std::vector<size_t> >& columnSortedIndices);
+    void solve(const MatrixView& X, const Vector& y, const std::vector<size_t>& rows, const std::vector<std::vector<size_t> >& columnSortedIndices);
+    // Histogram mode: builds the tree from the given rows of the binned X,
+    // which may repeat.
+    void solve(const BinnedMatrix& Xb, const Vector& y, const std::vector<size_t>& rows);
     virtual Vector predict(const Matrix& X) const;
     virtual double predict(const Vector& xrow) const;
+    // Predicts from views of either precision, which are not copied.
+    Vector predict(const MatrixView& X) const;
+    Vector predict(const FloatMatrixView& X) const;
 };
 
 #endif
\ No newline at end of file
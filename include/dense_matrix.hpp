@@ -0,0 +1,82 @@
+#ifndef DENSE_MATRIX_HPP
+#define DENSE_MATRIX_HPP
+
+#include "matrix.hpp"
+#include <vector>
+
+// BasicMatrixView is a non-owning, read-only view of a row-major block of
+// values: element (i, j) is found at data[i * stride + j]. A stride larger
+// than the number of columns views the leading columns of a wider block.
+// Unlike Matrix, whose rows are allocated separately, consecutive rows are
+// adjacent in memory; the hot loops of the solvers fetch a row pointer once
+// per row and then read the row sequentially.
+// The values are doubles (MatrixView) or floats (FloatMatrixView): single
+// precision halves the memory traffic of a pass over the data, and doubles
+// the number of values per SIMD register.
+// The viewed data must outlive the view.
+
+template<typename T>
+class BasicMatrixView
+{
+    const T* m_data;
+    size_t m_numRows;
+    size_t m_numColumns;
+    size_t m_stride;
+public:
+    BasicMatrixView();
+    BasicMatrixView(const T* data, size_t numRows, size_t numColumns, size_t stride);
+    size_t getNumRows() const
+    {
+        return m_numRows;
+    }
+    size_t getNumColumns() const
+    {
+        return m_numColumns;
+    }
+    size_t getStride() const
+    {
+        return m_stride;
+    }
+    const T* getRow(size_t row) const
+    {
+        return m_data + row * m_stride;
+    }
+    T operator()(size_t row, size_t column) const
+    {
+        return m_data[row * m_stride + column];
+    }
+    // The rows [beginRow, endRow) as a view of their own.
+    BasicMatrixView getRows(size_t beginRow, size_t endRow) const;
+};
+
+typedef BasicMatrixView<double> MatrixView;
+typedef BasicMatrixView<float> FloatMatrixView;
+
+// BasicDenseMatrix is a contiguous, row-major matrix which owns its values.
+// Solvers convert a Matrix into a DenseMatrix (or, for single precision, a
+// FloatDenseMatrix) once, when solving starts, and iterate over views of it
+// from then on.
+
+template<typename T>
+class BasicDenseMatrix
+{
+    std::vector<T> m_data;
+    size_t m_numRows;
+    size_t m_numColumns;
+public:
+    BasicDenseMatrix();
+    BasicDenseMatrix(size_t numRows, size_t numColumns);
+    // The values are converted to T.
+    explicit BasicDenseMatrix(const Matrix& X);
+    explicit BasicDenseMatrix(const MatrixView& X);
+    size_t getNumRows() const;
+    size_t getNumColumns() const;
+    T* getRow(size_t row);
+    const T* getRow(size_t row) const;
+    BasicMatrixView<T> getView() const;
+};
+
+typedef BasicDenseMatrix<double> DenseMatrix;
+typedef BasicDenseMatrix<float> FloatDenseMatrix;
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef FEATURE_HISTOGRAM_HPP
+#define FEATURE_HISTOGRAM_HPP
+
+#include "binned_matrix.hpp"
+#include "vectr.hpp"
+#include <vector>
+
+// FeatureHistogram holds, for every bin of every column of a BinnedMatrix,
+// the sum and the count of the target values of a subset of the rows
+// (typically the rows belonging to a decision tree node).
+// These are all that are needed for finding the split of the node which
+// minimizes the residual sum of squares, without ever sorting the rows.
+
+struct HistogramBin
+{
+    double sum;
+    size_t count;
+};
+
+class FeatureHistogram
+{
+    std::vector<HistogramBin> m_bins;
+public:
+    FeatureHistogram();
+    // Accumulates the histogram of the given rows from scratch.
+    void build(const BinnedMatrix& Xb, const Vector& y, const size_t* rows, size_t numRows);
+    // Empties all the bins, so that rows can be added one at a time.
+    void clear(const BinnedMatrix& Xb);
+    // Adds a row of the binned matrix, with target value yi, weight times.
+    void addRow(const BinnedMatrix& Xb, size_t row, double yi, size_t weight=1);
+    // Sets this histogram to parent minus sibling. As the histograms of two
+    // sibling nodes add up to the histogram of their parent, this gives the
+    // histogram of a node without visiting any of its rows.
+    void setDifference(const FeatureHistogram& parent, const FeatureHistogram& sibling);
+    const HistogramBin* getColumnBins(const BinnedMatrix& Xb, size_t column) const;
+};
+
+#endif
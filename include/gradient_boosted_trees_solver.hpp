@@ -0,0 +1,79 @@
+#ifndef GRADIENT_BOOSTED_TREES_SOLVER_HPP
+#define GRADIENT_BOOSTED_TREES_SOLVER_HPP
+
+#include "base_solver.hpp"
+#include "decision_tree.hpp"
+#include "dense_matrix.hpp"
+#include "vectr.hpp"
+#include <cstdint>
+#include <vector>
+
+// GradientBoostedTreesSolver builds an additive model of shallow regression
+// trees, for the squared error loss:
+//   prediction(x) = initialValue + learningRate * SUM(tree_k(x))
+// where tree_k is fitted (with DecisionTreeRegressionSolver, in histogram
+// mode) to the residuals y - prediction of the model made of the k earlier
+// trees. The learning rate shrinks the contribution of every tree, which
+// makes the model generalize better at the expense of more rounds.
+// Further details:
+//   - The dataset is binned only once; every round reuses the binned matrix.
+//   - The current predictions of the training rows are kept and updated
+//     after every round. For the rows the tree was trained on, the update
+//     is read from the leaves they ended up in; the other rows are run
+//     through the new tree only.
+//   - Every tree may be trained on a random fraction of the training rows
+//     (subsampleRatio < 1), which adds some randomness to the model.
+//   - Training stops early once the mean square error on a held-out set
+//     has not improved for earlyStoppingRounds rounds; the model is then cut
+//     back to the round with the lowest held-out error.
+//   - Trees are limited by depth (maxDepth), leaf size (maxLeafSize) and by
+//     the minimum decrease in RSS that a split must bring (minGain).
+
+class GradientBoostedTreesSolver: virtual public BaseSolver
+{
+    size_t m_maxNumRounds;
+    double m_learningRate;
+    size_t m_maxDepth;
+    double m_subsampleRatio;
+    size_t m_earlyStoppingRounds;
+    size_t m_maxLeafSize;
+    double m_minGain;
+    // Fraction of the rows that solve(X, y) holds out for early stopping.
+    double m_validationFraction;
+    size_t m_numThreads;
+    uint64_t m_seed;
+    double m_initialValue;
+    std::vector<DecisionTree> m_trees;
+    std::vector<double> m_validationErrors;
+    // Targets of the tree of the current round, updated in place every
+    // round (only the entries of the training rows are used).
+    Vector m_residuals;
+
+    void solve(const Matrix& X, const Vector& y, const std::vector<size_t>& trainRows, const Matrix* pXValid, const Vector* pyValid, const std::vector<size_t>& validRows);
+    // Predictions of the model for the given rows (of either precision).
+    template<typename T>
+    Vector predictRows(const T* const* rows, size_t numRows) const;
+public:
+    // Rows are predicted in blocks of this size, by all trees at once.
+    static const size_t PREDICTION_BLOCK_SIZE = 256;
+
+    GradientBoostedTreesSolver(size_t maxNumRounds=100, double learningRate=0.1, size_t maxDepth=3, double subsampleRatio=1.0, size_t earlyStoppingRounds=10);
+    void setMaxLeafSize(size_t maxLeafSize);
+    void setMinGain(double minGain);
+    void setValidationFraction(double validationFraction);
+    void setNumThreads(size_t numThreads);
+    void setSeed(uint64_t seed);
+    size_t getNumTrees() const;
+    // Held-out mean square error after every round.
+    const std::vector<double>& getValidationErrors() const;
+    virtual void solve(const Matrix& X, const Vector& y);
+    // Trains on (X, y) and stops early based on the held-out (XValid, yValid).
+    void solve(const Matrix& X, const Vector& y, const Matrix& XValid, const Vector& yValid);
+    virtual Vector predict(const Matrix& X) const;
+    virtual double predict(const Vector& xrow) const;
+    // Predicts from views of either precision, which are not copied.
+    Vector predict(const MatrixView& X) const;
+    Vector predict(const FloatMatrixView& X) const;
+};
+
+#endif
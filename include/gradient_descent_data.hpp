@@ -2,23 +2,234 @@
 #define GRADIENT_DESCENT_DATA_HPP
 
 #include "matrix.hpp"
+#include "dense_matrix.hpp"
+#include "csr_matrix.hpp"
 #include "vectr.hpp"
 #include "index_shuffler.hpp"
+#include "random_generator.hpp"
+#include "gradient_kernels.hpp"
+#include "gradient_optimizer.hpp"
+#include "thread_pool.hpp"
+#include "hogwild_parameters.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// GradientDescentData holds the training data of a gradient descent solver.
+// The features are read through a contiguous, row-major MatrixView. A
+// Matrix is converted into a DenseMatrix (owned here) once, in setData;
+// a MatrixView is used as is, without copying.
+// With single precision set, the features are converted to floats instead
+// (a FloatMatrixView is used as is): the passes over the data then move
+// half the bytes, while the weights, the targets and the gradient stay in
+// double precision.
+// Sparse features are given as a CsrMatrix (not copied either). Gradient
+// descent steps then only go through the nonzero values of the batch, and
+// only update the weights of their columns, so that their cost does not
+// depend on the number of columns (see stepSparse).
+// An optional L2 penalty (l2Penalty / 2) * |weights|^2 (not applied to the
+// bias) is added to the cost.
+// The gradient is evaluated over fixed chunks of the sampled rows, which are
+// processed in parallel by a persistent thread pool. The partial gradients
+// of the chunks are then combined by a pairwise (tree) reduction in a fixed
+// order. As the chunks do not depend on the number of threads, the result
+// is the same, bit for bit, whatever the number of threads.
+// The increments of the weights and bias are computed from the gradient by
+// a GradientOptimizer, with the learning rate given by a LearningRateSchedule;
+// without either, by plain gradient descent with a constant learning rate.
+// For datasets that do not fit in memory, the data can also be streamed, as
+// successive chunks of rows (see GradientDescentSolver::iterateStream): the
+// chunks are set in turn, and the state of the optimizer persists across
+// them. Partial fits (online training) set their rows the same way.
+// In asynchronous (Hogwild) training, several workers run concurrently,
+// each sampling mini-batches of its own and updating shared parameters
+// without locks (see runHogwildWorker).
 
 class GradientDescentData
 {
 protected:
-    const Matrix* m_pX;
+    DenseMatrix m_denseX;
+    MatrixView m_X;
+    // The features in single precision; m_X is then empty.
+    FloatDenseMatrix m_floatDenseX;
+    FloatMatrixView m_floatX;
+    bool m_isSinglePrecision;
+    bool m_isFloatData;
+    // The weights in single precision, for the dot products with m_floatX.
+    std::vector<float> m_floatWeights;
+    size_t m_numDataRows;
+    // The features in CSR format; m_X is then empty.
+    const CsrMatrix* m_pCsrX;
+    bool m_isSparseData;
+    double m_l2Penalty;
+    // Sparse steps: the weights are m_weightScale times the stored weights,
+    // so that the L2 decay of all of them is a single multiplication.
+    double m_weightScale;
+    // Sparse steps: the errors of the rows of the batch, and the increments
+    // of the columns of the batch (0 elsewhere), with their list.
+    std::vector<double> m_batchErrors;
+    std::vector<double> m_sparseIncrements;
+    std::vector<uint32_t> m_touchedColumns;
     const Vector* m_py;
     double m_learningRate;
     size_t m_numRows;
     size_t m_numColumns;
     size_t m_numStochasticSamples;
     IndexShuffler m_indexer;
+    // Seed of the mini-batch sampling; drawn from rand() if not set.
+    bool m_isSeedSet;
+    uint64_t m_seed;
+    // Seed of the current sampling, from which the workers of asynchronous
+    // training derive their own.
+    uint64_t m_batchSeed;
     double m_constMult;
+    std::shared_ptr<ThreadPool> m_threadPool;
+    // Output of evaluateGradient: SUM(err[i] * Xsam[i]).
+    std::vector<double> m_gradient;
+    // Partial gradients (numColumns values each) and error sums of the chunks.
+    std::vector<double> m_chunkGradients;
+    std::vector<double> m_chunkErrSums;
+    std::shared_ptr<GradientOptimizer> m_optimizer;
+    std::shared_ptr<LearningRateSchedule> m_schedule;
+    // The optimizer counts its iterations from its last reset: the
+    // iteration of the solver at the first increments since then.
+    size_t m_optimizerIterationBase;
+    bool m_isOptimizerIterationBaseSet;
+    // Gradient and increments of the optimizer's parameters: the weights,
+    // followed by the bias.
+    std::vector<double> m_parameterGradient;
+    std::vector<double> m_parameterIncrements;
+    // Mini-batch seeds of the successive chunks of a stream.
+    RandomGenerator m_streamGenerator;
+    // batchSize: 0 implies all the rows in every batch
+    void setRows(const MatrixView& X, const Vector& y, size_t batchSize, uint64_t seed);
+    void setRows(const FloatMatrixView& X, const Vector& y, size_t batchSize, uint64_t seed);
+    void setSampling(size_t numRows, size_t numColumns, const Vector& y, size_t batchSize, uint64_t seed);
+    // Forgets the targets and the features given to the last setData (or
+    // chunk, or partial fit), which the caller may free afterwards; a Matrix
+    // converted once is kept.
+    void clearDataReferences();
+    // Clears the state of the optimizer, for m_numColumns + 1 parameters.
+    void resetOptimizer();
+    // Streaming: prepares for chunks of numColumns columns, and sets the
+    // next chunk, returning the number of mini-batches in a pass over it.
+    void beginStream(size_t numColumns);
+    size_t setChunkData(const MatrixView& X, const Vector& y);
+    // Online training: sets the rows of a partial fit (a Matrix is copied,
+    // a MatrixView is not; neither is converted to single precision), and
+    // returns the number of mini-batches in a pass over them. The state of
+    // the optimizer is kept, unless it was for another number of columns.
+    // With a seed set, the mini-batch seeds of the successive partial fits
+    // are drawn from it.
+    size_t setPartialData(const Matrix& X, const Vector& y);
+    size_t setPartialData(const MatrixView& X, const Vector& y);
+    // Evaluates the gradient over the current sample of rows into
+    // m_gradient, and returns SUM(err[i]).
+    double evaluateGradient(const double* weights, double bias, GradientLoss loss);
+    template<typename T>
+    double evaluateGradient(const BasicMatrixView<T>& X, const T* weights, double bias, GradientLoss loss);
+    // Evaluates a sum over the current sample of rows, in numChunks chunks
+    // of GRADIENT_CHUNK_SIZE rows (in parallel, with several threads):
+    // evaluateChunk(c, begin, numChunkRows, values) writes the partial sums
+    // of chunk c into values, and returns its partial scalar sum. The chunks
+    // write at stride values apart in chunkValues, and their scalar sums in
+    // chunkSums, if not null; these are then reduced pairwise, in an order
+    // that does not depend on the number of threads, and the numValues
+    // total sums are copied into result. A single chunk writes into result
+    // directly. Returns the total scalar sum (0 without chunkSums).
+    template<typename ChunkFunction>
+    double reduceChunks(size_t numChunks, size_t stride, const ChunkFunction& evaluateChunk, double* chunkValues, double* chunkSums, double* result);
+    // Turns the output of evaluateGradient into the increments of the
+    // weights (numColumns values), and returns the increment of the bias.
+    double computeIncrements(double errSum, size_t iteration, double* weightIncrements);
+    double evaluateLoss(const double* weights, double bias, GradientLoss loss) const;
+    // Mean cost over the sampled rows and its gradient, at the given
+    // parameters: numColumns weights, followed by the bias. gradient
+    // receives (numColumns + 1) values.
+    double evaluateLossAndGradient(const double* parameters, GradientLoss loss, double* gradient);
+    // Asynchronous training: the loop of a worker, which draws mini-batches
+    // from a random stream of its own, evaluates the gradient at a copy of
+    // the shared parameters and adds the increments (from plain gradient
+    // descent, with the learning rate schedule, if any) to them, until no
+    // update is left. Workers only read the data, concurrently.
+    void runHogwildWorker(HogwildParameters& parameters, size_t worker, GradientLoss loss) const;
+    // Sparse data: runs a step of (mini-)batch gradient descent on weights
+    // and bias in place, and returns the largest increment of the bias and
+    // of the weights of the columns of the batch. The cost is in proportion
+    // to the nonzeros of the batch: the L2 decay of all the weights only
+    // changes m_weightScale.
+    double stepSparse(double* weights, double& bias, size_t iteration, GradientLoss loss);
+    // Multiplies the weights by m_weightScale, which is reset to 1. Must be
+    // called after sparse steps, before the weights are used otherwise.
+    void applyWeightScale(double* weights);
 public:
-    GradientDescentData(size_t numStochasticSamples, double learningRate);
+    // Rows are processed in chunks of (at most) this many rows.
+    static const size_t GRADIENT_CHUNK_SIZE = 4096;
+    // Rows per chunk when streaming data.
+    static const size_t DEFAULT_STREAM_CHUNK_SIZE = 65536;
+
+    GradientDescentData(size_t numStochasticSamples, double learningRate, size_t numThreads=1);
+    void setNumThreads(size_t numThreads);
+    void setSeed(uint64_t seed);
+    // Whether setData converts the features to single precision (streamed
+    // chunks are not converted).
+    void setSinglePrecision(bool isSinglePrecision);
+    void setL2Penalty(double l2Penalty);
+    // nullptr restores plain gradient descent.
+    void setOptimizer(const std::shared_ptr<GradientOptimizer>& optimizer);
+    // nullptr restores the constant learning rate.
+    void setLearningRateSchedule(const std::shared_ptr<LearningRateSchedule>& schedule);
     virtual void setData(const Matrix& X, const Vector& y);
+    virtual void setData(const MatrixView& X, const Vector& y);
+    virtual void setData(const FloatMatrixView& X, const Vector& y);
+    // The CsrMatrix is used as is, and must outlive the training.
+    virtual void setData(const CsrMatrix& X, const Vector& y);
 };
 
+template<typename ChunkFunction>
+double GradientDescentData::reduceChunks(size_t numChunks, size_t stride, const ChunkFunction& evaluateChunk, double* chunkValues, double* chunkSums, double* result)
+{
+    if(numChunks == 1)
+    {
+        return evaluateChunk(0, 0, m_numRows, result);
+    }
+    auto evaluateStoredChunk = [&](size_t c)
+    {
+        size_t begin = c * GRADIENT_CHUNK_SIZE;
+        size_t end = std::min(m_numRows, begin + GRADIENT_CHUNK_SIZE);
+        double sum = evaluateChunk(c, begin, end - begin, chunkValues + c * stride);
+        if(chunkSums != nullptr)
+        {
+            chunkSums[c] = sum;
+        }
+    };
+    if(m_threadPool->getNumThreads() == 1)
+    {
+        // Same chunks, without the (allocating) task submission.
+        for(size_t c = 0; c < numChunks; c++)
+        {
+            evaluateStoredChunk(c);
+        }
+    }
+    else
+    {
+        m_threadPool->parallelFor(numChunks, evaluateStoredChunk);
+    }
+    // Pairwise reduction: chunk c absorbs chunk (c + step) for c multiple
+    // of (2 * step), with the step doubling, until chunk 0 holds the total.
+    for(size_t step = 1; step < numChunks; step *= 2)
+    {
+        for(size_t c = 0; c + step < numChunks; c += 2 * step)
+        {
+            axpy(stride, 1, chunkValues + (c + step) * stride, chunkValues + c * stride);
+            if(chunkSums != nullptr)
+            {
+                chunkSums[c] += chunkSums[c + step];
+            }
+        }
+    }
+    std::copy(chunkValues, chunkValues + stride, result);
+    return (chunkSums != nullptr) ? chunkSums[0] : 0;
+}
+
 #endif
\ No newline at end of file
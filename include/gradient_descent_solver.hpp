@@ -3,6 +3,36 @@
 
 #include "vectr.hpp"
 #include "base_solver.hpp"
+#include "data_source.hpp"
+#include "hogwild_parameters.hpp"
+
+// GradientDescentSolver runs the gradient descent iterations. The weights
+// and their increments are sized once, before iterating, and updated in
+// place, so that iterations do not allocate memory.
+// The iterations stop when the largest increment falls below the tolerance,
+// after the maximum number of iterations or, if a target loss is set, as soon
+// as the training loss reaches it (which costs a pass over the data per
+// iteration).
+// Training can also stream the data from disk, chunk by chunk, over several
+// epochs, for datasets that do not fit in memory.
+// With asynchronous workers set, in-memory training is Hogwild-style: the
+// workers update shared weights and bias without locks nor any reduction
+// between them, which scales with the number of cores where synchronous
+// steps do not. The calling thread monitors them: it periodically samples
+// the latest increments of the workers (and the training loss, if a target
+// is set), and applies the stopping criteria to them; the iteration count
+// is then the number of updates. The GradientOptimizer, if any, is not
+// used: its state cannot be shared without locks.
+// Training on sparse (CSR) data runs steps whose cost is in proportion to
+// the nonzeros of the batch; the largest increment then only covers the
+// bias and the weights of the columns of the batch (not the L2 decay), and
+// the optimizer is not used either.
+// Training normally starts from random weights. With warm start set, it
+// starts from the current weights and bias instead, when they have the right
+// number of columns (e.g. after an earlier solve). Online training goes
+// further: every partial fit runs a single pass over the rows it is given,
+// continuing the current training, optimizer state and iteration count
+// included (see iteratePartial).
 
 class GradientDescentSolver: virtual public BaseSolver
 {
@@ -13,12 +43,87 @@ protected:
     size_t m_maxIterations;
     double m_tolerance;
     double m_maxIncrement;
+    bool m_isTargetLossSet;
+    double m_targetLoss;
+    size_t m_numAsyncWorkers;
+    bool m_isWarmStart;
+    // Training loss at the end of the last solve (or partial fit), recorded
+    // before the solver forgets the training data.
+    double m_trainingLoss;
+    // Cost over the training data that is set, with the current weights and
+    // bias; only valid during training.
+    virtual double evaluateTrainingLoss() const = 0;
+    // Forgets the training data, which the caller may free once training
+    // returns.
+    virtual void releaseTrainingData() = 0;
+    // Ends training: records the training loss and forgets the data.
+    void finishTraining();
+    // Whether there are weights (and a bias) of numColumns columns to
+    // continue from.
+    bool hasParameters(size_t numColumns) const;
+    // Sets up the weights (random ones, or the current ones on a warm
+    // start), the increments and the iteration count.
+    void initializeParameters(size_t numColumns);
+    // Applies the increments of one iteration to the weights and bias.
+    void update(size_t numColumns);
+    // Runs one iteration; returns false if the iterations should stop.
+    bool step(size_t numColumns);
+    // Runs the iterations from random initial weights (and bias).
+    void iterate(size_t numColumns);
+    // Asynchronous training: runs the workers and monitors them.
+    void iterateAsync(size_t numColumns);
+    // The loop of an asynchronous worker.
+    virtual void runAsyncWorker(HogwildParameters& parameters, size_t worker) = 0;
+    // Sparse training: runs a step, updating the weights and bias in place,
+    // and returns the largest increment.
+    virtual double runSparseStep() = 0;
+    // Brings the weights up to date after sparse steps.
+    virtual void finishSparseSteps() = 0;
+    // Runs the iterations on sparse data, from random initial weights (and
+    // bias).
+    void iterateSparse(size_t numColumns);
+    // Streaming: hands a chunk of rows over to the data, and returns the
+    // number of (mini-)batches in a pass over it.
+    virtual size_t setChunk(const DataChunk& chunk) = 0;
+    // Runs the iterations over numEpochs passes of the chunks of source,
+    // from random initial weights (and bias). The chunks are read ahead by
+    // a ChunkPrefetcher, and each is gone through once per pass, in
+    // mini-batches. The stopping criteria still apply; the tolerance and
+    // target loss then concern the current chunk. The training loss is
+    // that of the chunks of the last pass, each right after its own
+    // iterations (or that of the chunk on which the iterations stopped).
+    void iterateStream(DataSource& source, size_t numEpochs, size_t chunkSize);
+    // Online training: runs numBatches iterations over the rows that were
+    // set, from the current weights, bias and iteration count (or from
+    // random weights, if there are none of numColumns columns). The
+    // stopping criteria do not apply: all the iterations are run. The
+    // training loss is then that over these rows.
+    void iteratePartial(size_t numColumns, size_t numBatches);
 public:
+    // Period of the monitoring of asynchronous workers.
+    static const size_t ASYNC_MONITOR_PERIOD_MICROSECONDS = 200;
+
     GradientDescentSolver(size_t numIterations, double tolerance);
+    // Number of asynchronous workers; 0 (the default) restores synchronous
+    // iterations. Only solves on in-memory dense data use the workers:
+    // streamed, sparse (CSR) and online (partialFit) training are always
+    // synchronous.
+    void setAsyncWorkers(size_t numWorkers);
+    // Whether solve starts from the current weights and bias, when they
+    // have the right number of columns; the optimizer still starts afresh.
+    void setWarmStart(bool isWarmStart);
     virtual void evaluateIncrements() = 0;
+    // Cost over the whole training data, with the weights and bias at the
+    // end of the last solve (or partial fit).
+    double getTrainingLoss() const;
+    void setTargetLoss(double targetLoss);
+    void clearTargetLoss();
     virtual bool shouldContinueIterating();
     virtual void log() const;
     virtual void solve(const Matrix& X, const Vector& y);
+    // Number of iterations run by the last solve (or since the start of
+    // online training).
+    size_t getIterationCount() const;
 };
 
 #endif
\ No newline at end of file
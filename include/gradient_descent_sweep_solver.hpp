@@ -0,0 +1,107 @@
+#ifndef GRADIENT_DESCENT_SWEEP_SOLVER_HPP
+#define GRADIENT_DESCENT_SWEEP_SOLVER_HPP
+
+#include "matrix.hpp"
+#include "vectr.hpp"
+#include "dense_matrix.hpp"
+#include "gradient_descent_data.hpp"
+#include "gradient_kernels.hpp"
+#include <vector>
+
+// The hyperparameters of one model of a sweep.
+struct SweepConfiguration
+{
+    double learningRate;
+    double tolerance;
+    double l2Penalty;
+};
+
+enum class SweepStatus
+{
+    // Still iterating (before solve).
+    ACTIVE,
+    // The largest increment fell below the tolerance.
+    CONVERGED,
+    // The increments became too large, or not finite.
+    DIVERGED,
+    MAX_ITERATIONS
+};
+
+// GradientDescentSweepSolver trains one linear or logistic regression model
+// per configuration (learning rate, tolerance and L2 penalty) at once, by
+// the plain gradient descent of LinearRegressionGDSolver and
+// LogisticRegressionSolver, from the same random initial weights and on the
+// same (mini-)batches.
+// The weights of the M models are a numColumns x M matrix, so that every
+// iteration goes through the sampled rows once for all the models, with
+// block matrix products (see computeSweepGradient), instead of once per
+// model. The rows are processed in chunks, in parallel, and the partial
+// gradients reduced pairwise, as for the other solvers.
+// Models leave the active set as soon as they converge (the largest
+// increment of their weights and bias falls below their tolerance, as for
+// MulticlassLogisticRegressionSolver), diverge (their
+// largest increment exceeds MAX_INCREMENT, or is not finite) or reach the
+// maximum number of iterations: their columns are then removed from the
+// matrix, so that the remaining iterations only cost the active models.
+// The LearningRateSchedule, if any, applies to the learning rate of every
+// model; the GradientOptimizer is not used.
+
+class GradientDescentSweepSolver: virtual public GradientDescentData
+{
+    GradientLoss m_loss;
+    std::vector<SweepConfiguration> m_configurations;
+    size_t m_maxIterations;
+    // The models: weights (numModels x numColumns, row-major), biases,
+    // statuses, iteration counts and training losses.
+    std::vector<double> m_modelWeights;
+    std::vector<double> m_modelBiases;
+    std::vector<SweepStatus> m_statuses;
+    std::vector<size_t> m_iterationCounts;
+    std::vector<double> m_trainingLosses;
+    // The active models: their indices, weights (numColumns x
+    // numActiveModels, row-major) and biases.
+    std::vector<size_t> m_activeModels;
+    std::vector<double> m_activeWeights;
+    std::vector<double> m_activeBiases;
+    // Per active model: the largest increment of the last iteration, the
+    // factor of the gradient in the increments, and the factor of the
+    // weights in the gradient of the L2 penalty.
+    std::vector<double> m_maxIncrements;
+    std::vector<double> m_constMults;
+    std::vector<double> m_l2Terms;
+    // Positions in the active set of the models kept by the last removal.
+    std::vector<size_t> m_keptPositions;
+    // Gradient (numColumns x numActiveModels, then the biases) and the
+    // partial gradients and scratch space of the chunks.
+    std::vector<double> m_sweepGradient;
+    std::vector<double> m_chunkSweepGradients;
+    std::vector<double> m_chunkScores;
+
+    // Evaluates the gradient of the active models over the current sample
+    // of rows into m_sweepGradient.
+    void evaluateSweepGradient();
+    // Moves the models that stopped out of the active set.
+    void removeStoppedModels(size_t numColumns);
+    double evaluateTrainingLoss(size_t model) const;
+    void iterate(size_t numColumns);
+public:
+    // Increments larger than this mean that a model diverges.
+    static const double MAX_INCREMENT;
+
+    GradientDescentSweepSolver(GradientLoss loss, const std::vector<SweepConfiguration>& configurations, size_t numStochasticSamples=0, size_t maxNumIterations=100000, size_t numThreads=1);
+    void solve(const Matrix& X, const Vector& y);
+    // Trains on a view of contiguous data, which is not copied.
+    void solve(const MatrixView& X, const Vector& y);
+    size_t getNumModels() const;
+    const SweepConfiguration& getConfiguration(size_t model) const;
+    std::vector<double> getWeights(size_t model) const;
+    double getBias(size_t model) const;
+    SweepStatus getStatus(size_t model) const;
+    size_t getIterationCount(size_t model) const;
+    // Cost of a model over the training data, with its L2 penalty, at the
+    // end of the last solve. (The training data is not referred to after
+    // solve returns.)
+    double getTrainingLoss(size_t model) const;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef GRADIENT_KERNELS_HPP
+#define GRADIENT_KERNELS_HPP
+
+#include "dense_matrix.hpp"
+#include "csr_matrix.hpp"
+#include <cstddef>
+
+// Gradient kernels compute, in a single pass over the sampled rows, the
+// gradient of the cost function of linear or logistic regression.
+// For each row x_i (with target y_i), the row is streamed once:
+//   z_i   = bias + x_i . weights
+//   err_i = z_i - y_i            (squared error, linear regression)
+//   err_i = sigmoid(z_i) - y_i   (logistic loss, logistic regression)
+//   gradient += err_i * x_i
+// and the sum of err_i, the gradient w.r.t. the bias, is returned.
+// Neither err nor X-transpose are ever materialized.
+// With single precision features (FloatMatrixView), the dot products are
+// computed in single precision, with the weights converted to floats by the
+// caller, while err, the gradient and the sums over rows are accumulated in
+// double precision, for stability over many rows.
+// With sparse (CSR) rows, the cost is in proportion to the nonzero values of
+// the rows, plus the zeroing of the gradient.
+// The kernel is vectorized with AVX-512 or AVX2 (with FMA) when the CPU
+// supports them, which is detected at runtime; otherwise, or on other
+// architectures, a scalar kernel is used. The variants sum in different
+// orders, so their results may differ by rounding.
+
+enum class GradientLoss
+{
+    SQUARED_ERROR,
+    LOGISTIC
+};
+
+enum class GradientKernel
+{
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+bool isGradientKernelSupported(GradientKernel kernel);
+// The fastest kernel supported by this CPU.
+GradientKernel getBestGradientKernel();
+const char* getGradientKernelName(GradientKernel kernel);
+
+// rows: the indices of the numRows rows of X (and y) to go through
+// gradient: numColumns entries, overwritten
+double computeGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double bias, GradientLoss loss, double* gradient);
+double computeGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double bias, GradientLoss loss, double* gradient, GradientKernel kernel);
+double computeGradient(const FloatMatrixView& X, const double* y, const size_t* rows, size_t numRows, const float* weights, double bias, GradientLoss loss, double* gradient);
+double computeGradient(const FloatMatrixView& X, const double* y, const size_t* rows, size_t numRows, const float* weights, double bias, GradientLoss loss, double* gradient, GradientKernel kernel);
+double computeGradient(const CsrMatrix& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double bias, GradientLoss loss, double* gradient);
+
+// The errors err_i of the given rows of X, for the weights weightScale *
+// weights; returns their sum. Costs in proportion to the nonzeros of the
+// rows only, so that sparse gradient descent steps need not go through
+// all the columns.
+double computeErrors(const CsrMatrix& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double weightScale, double bias, GradientLoss loss, double* errors);
+
+// Mean cost over all the rows of X, which gradient descent minimizes:
+//   SUM(err_i^2) / (2 * numRows)                             (squared error)
+//   SUM(log(1 + exp(z_i)) - y_i * z_i) / numRows  (logistic loss, i.e. cross-entropy)
+double computeLoss(const MatrixView& X, const double* y, const double* weights, double bias, GradientLoss loss);
+double computeLoss(const FloatMatrixView& X, const double* y, const double* weights, double bias, GradientLoss loss);
+double computeLoss(const CsrMatrix& X, const double* y, const double* weights, double bias, GradientLoss loss);
+
+// Linear scores bias + x_i . weights of all the rows of X, into scores.
+void computeScores(const MatrixView& X, const double* weights, double bias, double* scores);
+void computeScores(const FloatMatrixView& X, const double* weights, double bias, double* scores);
+void computeScores(const CsrMatrix& X, const double* weights, double bias, double* scores);
+
+// Multi-class kernels, for numClasses classes. The weights are a
+// numColumns x numClasses matrix, row-major (the weights of a feature for
+// all the classes are adjacent), with numClasses biases; y holds class
+// indices. The logits of row i are z_i = biases + x_i * weights, and:
+//   SOFTMAX:     p_i = softmax(z_i), loss_i = -log(p_i[y_i])
+//   ONE_VS_REST: p_i = sigmoid(z_i), loss_i = SUM over the classes of the
+//                binary cross-entropy of class k against (y_i == k)
+//   err_i = p_i - onehot(y_i)
+//   gradient += x_i-transpose * err_i,  biasGradient += err_i
+// The softmax subtracts the largest logit before exponentiating, so that
+// it does not overflow.
+// Rows are processed in blocks of MULTICLASS_BLOCK_SIZE rows: the logits of
+// a block are a single matrix-matrix product, so that every row of X is
+// read once for all the classes, and the errors of the block then update
+// the gradient by another one, while the rows are still in cache. The
+// products are vectorized over the classes (with AVX-512 or AVX2, when
+// supported, as above).
+const size_t MULTICLASS_BLOCK_SIZE = 32;
+
+enum class MulticlassLoss
+{
+    SOFTMAX,
+    ONE_VS_REST
+};
+
+// logits: scratch space of MULTICLASS_BLOCK_SIZE * numClasses values
+// gradient: numColumns * numClasses entries, and biasGradient: numClasses
+// entries, overwritten
+// Returns the sum of loss_i over the rows.
+double computeMulticlassGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, size_t numClasses, const double* weights, const double* biases, MulticlassLoss loss, double* logits, double* gradient, double* biasGradient);
+double computeMulticlassGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, size_t numClasses, const double* weights, const double* biases, MulticlassLoss loss, double* logits, double* gradient, double* biasGradient, GradientKernel kernel);
+// Mean of loss_i over all the rows of X.
+double computeMulticlassLoss(const MatrixView& X, const double* y, size_t numClasses, const double* weights, const double* biases, MulticlassLoss loss);
+// Logits of all the rows of X, into logits (numRows x numClasses).
+void computeLogits(const MatrixView& X, size_t numClasses, const double* weights, const double* biases, double* logits);
+
+// Sweep kernel, for numModels models of linear or logistic regression (with
+// the same loss) trained on the same rows: their weights are a numColumns x
+// numModels matrix, row-major, with numModels biases, as for the multi-class
+// kernels, whose block products it shares. For model m, err_im is computed
+// from z_im = biases[m] + x_i . weights[, m] as by computeGradient, and
+//   gradient[, m] += err_im * x_i,  biasGradient[m] += err_im
+// scores: scratch space of MULTICLASS_BLOCK_SIZE * numModels values
+// gradient: numColumns * numModels entries, and biasGradient: numModels
+// entries, overwritten
+void computeSweepGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, size_t numModels, const double* weights, const double* biases, GradientLoss loss, double* scores, double* gradient, double* biasGradient);
+
+// In-place update y += a * x, for vectors of n values.
+void axpy(size_t n, double a, const double* x, double* y);
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef GRADIENT_OPTIMIZER_HPP
+#define GRADIENT_OPTIMIZER_HPP
+
+#include <cstddef>
+#include <vector>
+
+// A LearningRateSchedule gives the learning rate of every iteration of
+// gradient descent, from the initial learning rate of the solver.
+// Iterations are counted from 0.
+
+class LearningRateSchedule
+{
+public:
+    virtual ~LearningRateSchedule() {}
+    virtual double getLearningRate(double initialRate, size_t iteration) const = 0;
+};
+
+// The rate is multiplied by factor every stepSize iterations.
+class StepDecaySchedule: public LearningRateSchedule
+{
+    size_t m_stepSize;
+    double m_factor;
+public:
+    StepDecaySchedule(size_t stepSize, double factor=0.5);
+    virtual double getLearningRate(double initialRate, size_t iteration) const;
+};
+
+// The rate follows half a cosine wave from initialRate down to
+// (minFraction * initialRate) over period iterations, and then stays there.
+class CosineSchedule: public LearningRateSchedule
+{
+    size_t m_period;
+    double m_minFraction;
+public:
+    CosineSchedule(size_t period, double minFraction=0);
+    virtual double getLearningRate(double initialRate, size_t iteration) const;
+};
+
+// rate = initialRate / (1 + decay * iteration)
+class InverseTimeSchedule: public LearningRateSchedule
+{
+    double m_decay;
+public:
+    InverseTimeSchedule(double decay);
+    virtual double getLearningRate(double initialRate, size_t iteration) const;
+};
+
+// A GradientOptimizer turns the gradient of the cost function into the
+// increments of the parameters (the weights, followed by the bias), i.e. it
+// is the update rule of gradient descent. Optimizers with memory keep one
+// state value (or two) per parameter. The state is sized and cleared by
+// reset, at the start of every solve, so that computing the increments does
+// not allocate memory; an optimizer must not be shared by solvers that run
+// at the same time.
+
+class GradientOptimizer
+{
+public:
+    virtual ~GradientOptimizer() {}
+    virtual const char* getName() const = 0;
+    virtual void reset(size_t numParameters) = 0;
+    // gradient: the gradient of the cost (averaged over the sampled rows)
+    // iteration: counted from 0 since the last reset
+    virtual void computeIncrements(const double* gradient, double learningRate, size_t iteration, double* increments) = 0;
+};
+
+// Plain gradient descent: increment = -rate * gradient
+class SGDOptimizer: public GradientOptimizer
+{
+    size_t m_numParameters;
+public:
+    SGDOptimizer();
+    virtual const char* getName() const;
+    virtual void reset(size_t numParameters);
+    virtual void computeIncrements(const double* gradient, double learningRate, size_t iteration, double* increments);
+};
+
+// Heavy-ball momentum:
+//   velocity = momentum * velocity - rate * gradient
+//   increment = velocity
+// With Nesterov momentum, the gradient is (in effect) taken at the point
+// the velocity leads to, which is reformulated as:
+//   increment = momentum * velocity - rate * gradient
+class MomentumOptimizer: public GradientOptimizer
+{
+    double m_momentum;
+    bool m_nesterov;
+    std::vector<double> m_velocity;
+public:
+    MomentumOptimizer(double momentum=0.9, bool nesterov=false);
+    virtual const char* getName() const;
+    virtual void reset(size_t numParameters);
+    virtual void computeIncrements(const double* gradient, double learningRate, size_t iteration, double* increments);
+};
+
+// Adam: the step of every parameter is the (bias corrected) moving average
+// of its gradient, divided by the square root of the moving average of its
+// squared gradient.
+class AdamOptimizer: public GradientOptimizer
+{
+    double m_beta1;
+    double m_beta2;
+    double m_epsilon;
+    std::vector<double> m_firstMoment;
+    std::vector<double> m_secondMoment;
+public:
+    AdamOptimizer(double beta1=0.9, double beta2=0.999, double epsilon=1e-8);
+    virtual const char* getName() const;
+    virtual void reset(size_t numParameters);
+    virtual void computeIncrements(const double* gradient, double learningRate, size_t iteration, double* increments);
+};
+
+// AdaGrad: the step of every parameter is divided by the square root of the
+// sum of all its squared gradients so far.
+class AdaGradOptimizer: public GradientOptimizer
+{
+    double m_epsilon;
+    std::vector<double> m_squaredGradientSums;
+public:
+    AdaGradOptimizer(double epsilon=1e-8);
+    virtual const char* getName() const;
+    virtual void reset(size_t numParameters);
+    virtual void computeIncrements(const double* gradient, double learningRate, size_t iteration, double* increments);
+};
+
+#endif
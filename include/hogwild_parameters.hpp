@@ -0,0 +1,57 @@
+#ifndef HOGWILD_PARAMETERS_HPP
+#define HOGWILD_PARAMETERS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// HogwildParameters holds the parameters (the weights, followed by the bias)
+// shared by the workers of an asynchronous, Hogwild-style, gradient descent,
+// and what the workers and the monitoring thread tell each other.
+// Workers read and update the parameters without any lock: every value is
+// an atomic accessed with relaxed ordering, which rules out torn values but
+// adds no synchronization (on x86-64 these are plain loads and stores). An
+// update is a load followed by a store, not an atomic read-modify-write, so
+// concurrent updates of the same parameter may overwrite each other; with
+// small increments and many parameters this is rare, and SGD tolerates it.
+// Every worker also publishes the largest increment of its latest update,
+// on a cache line of its own, for the monitoring thread to sample.
+
+class HogwildParameters
+{
+    struct alignas(64) WorkerIncrement
+    {
+        std::atomic<double> value;
+    };
+    size_t m_numParameters;
+    size_t m_numWorkers;
+    size_t m_maxNumUpdates;
+    std::unique_ptr<std::atomic<double>[]> m_parameters;
+    std::unique_ptr<WorkerIncrement[]> m_latestIncrements;
+    alignas(64) std::atomic<size_t> m_numClaimedUpdates;
+    alignas(64) std::atomic<bool> m_isStopped;
+public:
+    // Starts from the given weights (numColumns values) and bias.
+    HogwildParameters(const double* weights, double bias, size_t numColumns, size_t numWorkers, size_t maxNumUpdates);
+    HogwildParameters(const HogwildParameters&) = delete;
+    HogwildParameters& operator=(const HogwildParameters&) = delete;
+    size_t getNumParameters() const;
+    size_t getNumWorkers() const;
+    // Copies the current parameters (possibly while they are being updated).
+    void read(double* parameters) const;
+    // Adds the increments to the parameters, and publishes the largest of
+    // them as the latest increment of the worker.
+    void add(const double* increments, size_t worker);
+    // Reserves the next update; returns false once the maximum number of
+    // updates was reserved, or the training was stopped.
+    bool claimUpdate(size_t& update);
+    // Number of updates reserved so far (at most the maximum).
+    size_t getNumUpdates() const;
+    // The largest of the latest increments of the workers; infinite until
+    // every worker made an update.
+    double getMaxLatestIncrement() const;
+    void stop();
+    bool isStopped() const;
+};
+
+#endif
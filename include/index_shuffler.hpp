@@ -1,17 +1,42 @@
 #ifndef INDEX_SHUFFLER_HPP
 #define INDEX_SHUFFLER_HPP
 
+#include "random_generator.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+// IndexShuffler provides the row indices of the successive (mini-)batches
+// of a gradient descent.
+// Without a batch size, every batch holds all the rows, in order.
+// With a batch size k, batches are drawn without replacement within an
+// epoch: they are consecutive blocks of k positions of a random permutation
+// of the rows. The permutation is produced lazily, by an incremental
+// Fisher-Yates shuffle: a batch only draws its own k positions (k swaps),
+// so an update costs O(k) rather than O(number of rows). Once fewer than k
+// positions remain, a new epoch starts over at the first position (the
+// remaining rows are not lost, but take part in the next epoch's draws).
+
 class IndexShuffler
 {
     std::vector<size_t> m_indices;
-    bool m_doShuffle;
+    size_t m_batchSize;
+    // Position of the current batch in m_indices.
+    size_t m_position;
+    size_t m_epoch;
+    RandomGenerator m_generator;
 public:
     IndexShuffler();
-    IndexShuffler(size_t size, bool doShuffle);
+    // batchSize: 0 implies all the rows in every batch
+    IndexShuffler(size_t size, size_t batchSize, uint64_t seed);
+    // Moves to the next batch; must be called before the first batch too.
     void update();
     size_t getIndex(size_t i);
+    // The indices of the current batch.
+    const size_t* getIndices() const;
+    size_t getBatchSize() const;
+    // Number of epochs started so far.
+    size_t getEpoch() const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,7 @@
 #define INDEXING_UTILS_HPP
 
 #include "matrix.hpp"
+#include "dense_matrix.hpp"
 
 // Rationale:
 // For producing decision trees, subsets of the training dataset needs
@@ -37,5 +38,6 @@ public:
 // indicesToInspect: the indices of the dataset to look into
 
 std::vector<size_t> getColumnSortedIndices(const Matrix& X, size_t column, const std::vector<size_t>& indicesToInspect);
+std::vector<size_t> getColumnSortedIndices(const MatrixView& X, size_t column, const std::vector<size_t>& indicesToInspect);
 
 #endif
\ No newline at end of file
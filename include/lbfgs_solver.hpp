@@ -0,0 +1,81 @@
+#ifndef LBFGS_SOLVER_HPP
+#define LBFGS_SOLVER_HPP
+
+#include "vectr.hpp"
+#include "base_solver.hpp"
+#include <vector>
+
+// LBFGSSolver minimizes a smooth cost function of the weights and bias with
+// the L-BFGS quasi-Newton method, as an alternative to GradientDescentSolver.
+// The parameters are the weights, followed by the bias, starting from 0.
+// Every iteration:
+//   - the search direction is the gradient multiplied by an approximation
+//     of the inverse Hessian, built (by the two-loop recursion) from the
+//     last historySize pairs of parameter changes s and gradient changes y;
+//   - a line search along the direction finds a step satisfying the strong
+//     Wolfe conditions (sufficient decrease of the cost, and small enough
+//     slope), which keeps the approximation positive definite.
+// On smooth, moderately conditioned problems this converges in tens of
+// iterations, where gradient descent needs thousands. The iterations stop
+// when the largest component of the gradient falls below the tolerance,
+// after the maximum number of iterations, or when the line search finds no
+// acceptable step (at the limit of numerical precision).
+// All the vectors are sized before the first iteration, so that iterations
+// do not allocate memory.
+
+class LBFGSSolver: virtual public BaseSolver
+{
+    size_t m_numParameters;
+    // The current point, its gradient and the search direction.
+    std::vector<double> m_point;
+    std::vector<double> m_pointGradient;
+    std::vector<double> m_direction;
+    // The point being evaluated by the line search, and its gradient.
+    std::vector<double> m_trialPoint;
+    std::vector<double> m_trialGradient;
+    // History of (s, y) pairs: historySize vectors of numParameters values
+    // each, used as a circular buffer, and rho = 1 / (s . y) of every pair.
+    std::vector<double> m_steps;
+    std::vector<double> m_gradientChanges;
+    std::vector<double> m_rhos;
+    std::vector<double> m_alphas;
+    size_t m_numPairs;
+    size_t m_newestPair;
+    size_t m_numLineSearchEvaluations;
+
+    double evaluateTrialPoint(double step, double& slope);
+    void computeDirection();
+    // From the current point (loss, slope along the direction) and a first
+    // step to try, finds a step satisfying the strong Wolfe conditions; on
+    // success, the trial point, its gradient and trialLoss are those of the
+    // step.
+    bool searchLine(double loss, double slope, double step, double& trialLoss);
+    bool zoom(double loss, double slope, double lowStep, double lowLoss, double lowSlope, double highStep, double highLoss, double highSlope, double& trialLoss);
+protected:
+    size_t m_historySize;
+    size_t m_maxIterations;
+    double m_tolerance;
+    size_t m_iterationCount;
+    size_t m_numEvaluations;
+    double m_loss;
+    // Cost at the given parameters; gradient receives its gradient.
+    virtual double evaluateObjective(const double* parameters, double* gradient) = 0;
+    // Forgets the training data, which the caller may free once training
+    // returns (the cost at the minimum is kept in m_loss).
+    virtual void releaseTrainingData() = 0;
+    // Runs the iterations, and sets the weights and bias to the minimum
+    // found; then releases the training data.
+    void minimize(size_t numColumns);
+public:
+    static const size_t MAX_LINE_SEARCH_EVALUATIONS = 20;
+
+    LBFGSSolver(size_t historySize, size_t maxNumIterations, double tolerance);
+    // Number of iterations run by the last solve.
+    size_t getIterationCount() const;
+    // Number of evaluations of the cost and gradient in the last solve.
+    size_t getNumEvaluations() const;
+    // Cost at the weights and bias found by the last solve.
+    double getTrainingLoss() const;
+};
+
+#endif
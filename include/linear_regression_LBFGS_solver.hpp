@@ -0,0 +1,29 @@
+#ifndef LINEAR_REGRESSION_LBFGS_SOLVER_HPP
+#define LINEAR_REGRESSION_LBFGS_SOLVER_HPP
+
+#include "gradient_descent_data.hpp"
+#include "lbfgs_solver.hpp"
+
+// LinearRegressionLBFGSSolver fits linear regression (least squares) with
+// L-BFGS. The cost and its gradient are evaluated over all the rows, by the
+// same (chunked, parallel) gradient code as LinearRegressionGDSolver.
+
+class LinearRegressionLBFGSSolver:
+    virtual public LBFGSSolver,
+    virtual public GradientDescentData
+{
+protected:
+    virtual double evaluateObjective(const double* parameters, double* gradient);
+    virtual void releaseTrainingData();
+public:
+    LinearRegressionLBFGSSolver(size_t historySize=10, size_t maxNumIterations=1000, double tolerance=1e-8, size_t numThreads=1);
+    virtual void solve(const Matrix& X, const Vector& y);
+    // Trains on a view of contiguous data, which is not copied.
+    void solve(const MatrixView& X, const Vector& y);
+    // Trains on single precision data, which is not copied either.
+    void solve(const FloatMatrixView& X, const Vector& y);
+    // Trains on sparse data, which is not copied either.
+    void solve(const CsrMatrix& X, const Vector& y);
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef LOGISTIC_REGRESSION_IRLS_SOLVER_HPP
+#define LOGISTIC_REGRESSION_IRLS_SOLVER_HPP
+
+#include "gradient_descent_data.hpp"
+#include "logistic_regression_model.hpp"
+#include <vector>
+
+// LogisticRegressionIRLSSolver fits logistic regression by Newton's method,
+// i.e. iteratively reweighted least squares (IRLS), which converges
+// quadratically: typically in fewer than 15 iterations. It suits datasets
+// with many rows and at most a few hundred features.
+// With p the number of parameters (the weights and the bias), every
+// iteration:
+//   - forms the cost, its gradient and its Hessian, the weighted Gram matrix
+//     X-transpose * W * X / numRows with W = diag(prob_i * (1 - prob_i)),
+//     in a single pass over the rows. The rows are processed in blocks,
+//     copied column by column (each column scaled by W for one factor), so
+//     that every Hessian entry is accumulated by a contiguous dot product;
+//   - solves the p x p Newton system by Cholesky factorization, in O(p^3);
+//   - halves the Newton step until the cost decreases sufficiently, which
+//     is rarely needed.
+// The iterations stop when the decrease of the cost expected from the next
+// Newton step (half the squared Newton decrement) is below the tolerance,
+// which, close to the minimum, also bounds the distance to the minimum cost.
+// An optional ridge term (ridge / 2) * |weights|^2 (not applied to the bias)
+// is added to the cost. It makes the minimum exist, and the Hessian positive
+// definite, for linearly separable classes; without it, the iterations stop
+// once the Hessian becomes singular.
+
+class LogisticRegressionIRLSSolver:
+    virtual public GradientDescentData,
+    virtual public LogisticRegressionModel
+{
+    double m_ridge;
+    size_t m_maxIterations;
+    double m_tolerance;
+    size_t m_iterationCount;
+    double m_loss;
+    // Parameters (weights, then bias), their gradient and the Newton step.
+    std::vector<double> m_parameters;
+    std::vector<double> m_newtonGradient;
+    std::vector<double> m_newtonStep;
+    std::vector<double> m_trialParameters;
+    // Hessian (p x p, row-major; lower triangle), then its Cholesky factor.
+    std::vector<double> m_hessian;
+    // A block of rows, column after column: the values (with a column of
+    // ones for the bias) and the values scaled by the weights of W.
+    std::vector<double> m_blockColumns;
+    std::vector<double> m_weightedBlockColumns;
+
+    // Cost at the current parameters, with its gradient and Hessian (which
+    // are accumulated in double precision, whatever the precision of X).
+    double evaluateNewtonSystem();
+    template<typename T>
+    double evaluateNewtonSystem(const BasicMatrixView<T>& X);
+    double evaluateCost(const double* parameters) const;
+    void iterate(size_t numColumns);
+public:
+    static const size_t GRAM_BLOCK_SIZE = 64;
+
+    LogisticRegressionIRLSSolver(double ridge=0, size_t maxNumIterations=50, double tolerance=1e-12);
+    using LogisticRegressionModel::solve;
+    virtual void solve(const Matrix& X, const Vector& y);
+    // Trains on a view of contiguous data, which is not copied.
+    void solve(const MatrixView& X, const Vector& y);
+    // Trains on single precision data, which is not copied either.
+    void solve(const FloatMatrixView& X, const Vector& y);
+    // Number of Newton iterations run by the last solve.
+    size_t getIterationCount() const;
+    // Cost (including the ridge term) at the weights and bias found.
+    double getTrainingLoss() const;
+};
+
+#endif
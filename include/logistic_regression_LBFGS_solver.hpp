@@ -0,0 +1,35 @@
+#ifndef LOGISTIC_REGRESSION_LBFGS_SOLVER_HPP
+#define LOGISTIC_REGRESSION_LBFGS_SOLVER_HPP
+
+#include "gradient_descent_data.hpp"
+#include "lbfgs_solver.hpp"
+#include "logistic_regression_model.hpp"
+
+// LogisticRegressionLBFGSSolver fits logistic regression (minimizing the
+// cross-entropy) with L-BFGS. The cost and its gradient are evaluated over
+// all the rows, by the same (chunked, parallel) gradient code as
+// LogisticRegressionSolver, and predictions are made the same way.
+// The minimum only exists if the classes are not linearly separable;
+// otherwise the weights keep growing until the iteration limit.
+
+class LogisticRegressionLBFGSSolver:
+    virtual public LBFGSSolver,
+    virtual public GradientDescentData,
+    virtual public LogisticRegressionModel
+{
+protected:
+    virtual double evaluateObjective(const double* parameters, double* gradient);
+    virtual void releaseTrainingData();
+public:
+    using LogisticRegressionModel::solve;
+    LogisticRegressionLBFGSSolver(size_t historySize=10, size_t maxNumIterations=1000, double tolerance=1e-8, size_t numThreads=1);
+    virtual void solve(const Matrix& X, const Vector& y);
+    // Trains on a view of contiguous data, which is not copied.
+    void solve(const MatrixView& X, const Vector& y);
+    // Trains on single precision data, which is not copied either.
+    void solve(const FloatMatrixView& X, const Vector& y);
+    // Trains on sparse data, which is not copied either.
+    void solve(const CsrMatrix& X, const Vector& y);
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef LOGISTIC_REGRESSION_MODEL_HPP
+#define LOGISTIC_REGRESSION_MODEL_HPP
+
+#include "vectr.hpp"
+#include "matrix.hpp"
+#include "base_solver.hpp"
+#include "dense_matrix.hpp"
+#include "csr_matrix.hpp"
+#include <vector>
+
+// LogisticRegressionModel holds the predictions of logistic regression,
+// i.e. probability = sigmoid(bias + x . weights), for any solver that
+// finds the weights and bias of the model.
+
+class LogisticRegressionModel: virtual public BaseSolver
+{
+public:
+    virtual void solve(const Matrix& X, const Vector& y) = 0;
+    virtual void solve(const Matrix& X, const std::vector<bool>& yB);
+    Vector getProbability(const Matrix& X) const;
+    double getProbability(const Vector& xrow) const;
+    virtual Vector predict(const Matrix& X) const;
+    virtual double predict(const Vector& xrow) const;
+    virtual bool predictB(const Vector& xrow) const;
+    virtual std::vector<bool> predictB(const Matrix& X) const;
+    // Predictions for contiguous rows, in double or single precision (the
+    // scores are accumulated in double precision), or for sparse rows.
+    std::vector<double> getProbability(const MatrixView& X) const;
+    std::vector<double> getProbability(const FloatMatrixView& X) const;
+    std::vector<double> getProbability(const CsrMatrix& X) const;
+    std::vector<bool> predictB(const MatrixView& X) const;
+    std::vector<bool> predictB(const FloatMatrixView& X) const;
+    std::vector<bool> predictB(const CsrMatrix& X) const;
+};
+
+#endif
@@ -4,22 +4,42 @@
 #include "vectr.hpp"
 #include "gradient_descent_solver.hpp"
 #include "gradient_descent_data.hpp"
+#include "logistic_regression_model.hpp"
 
 class LogisticRegressionSolver:
     virtual public GradientDescentSolver,
-    virtual public GradientDescentData
+    virtual public GradientDescentData,
+    virtual public LogisticRegressionModel
 {
 public:
-    LogisticRegressionSolver(double learningRate=1e-4, size_t numStochasticSamples=0, size_t maxNumIterations=100000, double tolerance=1e-8);
+    using LogisticRegressionModel::solve;
+    LogisticRegressionSolver(double learningRate=1e-4, size_t numStochasticSamples=0, size_t maxNumIterations=100000, double tolerance=1e-8, size_t numThreads=1);
     virtual void evaluateIncrements();
+    virtual size_t setChunk(const DataChunk& chunk);
+    virtual void runAsyncWorker(HogwildParameters& parameters, size_t worker);
+    virtual double runSparseStep();
+    virtual void finishSparseSteps();
+    virtual double evaluateTrainingLoss() const;
+    virtual void releaseTrainingData();
     virtual void solve(const Matrix& X, const Vector& y);
-    virtual void solve(const Matrix& X, const std::vector<bool>& yB);
-    Vector getProbability(const Matrix& X) const;
-    double getProbability(const Vector& xrow) const;
-    virtual Vector predict(const Matrix& X) const;
-    virtual double predict(const Vector& xrow) const;
-    virtual bool predictB(const Vector& xrow) const;
-    virtual std::vector<bool> predictB(const Matrix& X) const;
+    // Trains on a view of contiguous data, which is not copied.
+    void solve(const MatrixView& X, const Vector& y);
+    // Trains on single precision data, which is not copied either.
+    void solve(const FloatMatrixView& X, const Vector& y);
+    // Trains on sparse data, which is not copied either; the steps only
+    // go through the nonzero values of their batch.
+    void solve(const CsrMatrix& X, const Vector& y);
+    // Trains over numEpochs passes of a stream of chunks, with mini-batches
+    // of numStochasticSamples rows (or whole chunks, if 0).
+    void solve(DataSource& source, size_t numEpochs, size_t chunkSize=DEFAULT_STREAM_CHUNK_SIZE);
+    // Online training: runs a pass over the rows, in mini-batches of
+    // numStochasticSamples rows (or all of them, if 0 or more than the
+    // rows), continuing from the current weights, bias, optimizer state and
+    // iteration count (those of the last solve or partial fit, if they have
+    // as many columns). y is not copied.
+    void partialFit(const Matrix& X, const Vector& y);
+    // Same, without copying the rows.
+    void partialFit(const MatrixView& X, const Vector& y);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef MULTICLASS_LOGISTIC_REGRESSION_SOLVER_HPP
+#define MULTICLASS_LOGISTIC_REGRESSION_SOLVER_HPP
+
+#include "matrix.hpp"
+#include "vectr.hpp"
+#include "dense_matrix.hpp"
+#include "gradient_descent_data.hpp"
+#include "gradient_kernels.hpp"
+#include <vector>
+
+// MulticlassLogisticRegressionSolver fits a classifier of K classes by
+// gradient descent, with a numColumns x K weight matrix and K biases: either
+// multinomial (softmax) logistic regression, or K one-vs-rest binary
+// logistic regressions trained together.
+// Every iteration computes the logits of all the classes, and the gradient
+// of all of them, in a single pass over the sampled rows (see
+// computeMulticlassGradient), where K binary solvers would read the rows K
+// times. The rows are processed in chunks, in parallel, and the partial
+// gradients of the chunks are reduced pairwise, as for the binary solvers,
+// so that the result does not depend on the number of threads.
+// The targets y are class indices, 0 to K - 1, stored as doubles; K is
+// taken from the largest of them. The features are used in double
+// precision, without sparse nor streamed data.
+// The increments are computed as by the binary solvers: by the
+// GradientOptimizer, if any (with K * (numColumns + 1) parameters), with the
+// learning rate of the LearningRateSchedule, if any, and with the L2
+// penalty applied to the weights. The iterations stop when the largest
+// increment falls below the tolerance, or after the maximum number of
+// iterations.
+
+class MulticlassLogisticRegressionSolver: virtual public GradientDescentData
+{
+    MulticlassLoss m_loss;
+    size_t m_maxIterations;
+    double m_tolerance;
+    size_t m_iterationCount;
+    size_t m_numClasses;
+    // Parameters: the weights (numColumns x numClasses, row-major), followed
+    // by the biases; their gradient (times the number of rows, then
+    // averaged) and their increments.
+    std::vector<double> m_parameters;
+    std::vector<double> m_multiclassGradient;
+    std::vector<double> m_increments;
+    // Partial gradients and loss sums of the chunks, and the scratch space
+    // of their logits.
+    std::vector<double> m_chunkParameterGradients;
+    std::vector<double> m_chunkLosses;
+    std::vector<double> m_chunkLogits;
+    double m_trainingLoss;
+
+    // Evaluates the gradient over the current sample of rows into
+    // m_multiclassGradient, and returns the sum of the losses of the rows.
+    double evaluateMulticlassGradient();
+    double evaluateTrainingLoss() const;
+    void iterate(size_t numColumns);
+public:
+    MulticlassLogisticRegressionSolver(double learningRate=1e-4, size_t numStochasticSamples=0, size_t maxNumIterations=100000, double tolerance=1e-8, size_t numThreads=1);
+    // SOFTMAX (the default) or ONE_VS_REST.
+    void setMulticlassLoss(MulticlassLoss loss);
+    void solve(const Matrix& X, const Vector& y);
+    // Trains on a view of contiguous data, which is not copied.
+    void solve(const MatrixView& X, const Vector& y);
+    size_t getNumClasses() const;
+    // Number of iterations run by the last solve.
+    size_t getIterationCount() const;
+    // The weights of feature j for class k are at j * numClasses + k.
+    std::vector<double> getWeights() const;
+    std::vector<double> getBiases() const;
+    // Mean loss over the training data (with the L2 penalty, if any), at
+    // the end of the last solve. (The training data is not referred to
+    // after solve returns.)
+    double getTrainingLoss() const;
+    // Probabilities of the classes (numRows x numClasses): the softmax of
+    // the logits or, one-vs-rest, their sigmoids (which need not sum to 1).
+    std::vector<double> getProbabilities(const MatrixView& X) const;
+    // The class of largest logit (i.e. of largest probability) of every
+    // row: the multi-class counterpart of LogisticRegressionModel::predictB.
+    std::vector<size_t> predictClass(const MatrixView& X) const;
+    std::vector<size_t> predictClass(const Matrix& X) const;
+};
+
+#endif
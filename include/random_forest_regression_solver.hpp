@@ -0,0 +1,53 @@
+#ifndef RANDOM_FOREST_REGRESSION_SOLVER_HPP
+#define RANDOM_FOREST_REGRESSION_SOLVER_HPP
+
+#include "base_solver.hpp"
+#include "decision_tree.hpp"
+#include "dense_matrix.hpp"
+#include "thread_pool.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// RandomForestRegressionSolver averages the predictions of several
+// regression trees, which lowers the variance of a single decision tree.
+// The trees differ from each other in two ways:
+//   - each tree is trained on a bootstrap sample of the training data, i.e.
+//     as many rows as in the dataset, drawn with replacement; and
+//   - each node of a tree searches a random subset of the columns only.
+// The columns of the dataset are sorted (or binned, in histogram mode) only
+// once, and every tree is trained from lists of row indices: the dataset is
+// never copied. The trees are trained concurrently, on a thread pool.
+
+class RandomForestRegressionSolver: virtual public BaseSolver
+{
+    size_t m_numTrees;
+    size_t m_maxLeafSize;
+    // Number of columns searched at each node; 0 implies a third of the
+    // columns (the usual choice for regression).
+    size_t m_numFeaturesPerSplit;
+    bool m_useHistograms;
+    uint64_t m_seed;
+    std::vector<DecisionTree> m_trees;
+    std::shared_ptr<ThreadPool> m_threadPool;
+    // Average of the trees over the given rows (of either precision).
+    template<typename T>
+    Vector predictRows(const T* const* rows, size_t numRows) const;
+public:
+    // Rows are predicted in blocks of this size, by all trees at once.
+    static const size_t PREDICTION_BLOCK_SIZE = 256;
+
+    RandomForestRegressionSolver(size_t numTrees=100, size_t maxLeafSize=5, size_t numFeaturesPerSplit=0, size_t numThreads=ThreadPool::getDefaultNumThreads());
+    void setHistogramMode(bool useHistograms);
+    void setSeed(uint64_t seed);
+    size_t getNumTrees() const;
+    const DecisionTree& getTree(size_t t) const;
+    virtual void solve(const Matrix& X, const Vector& y);
+    virtual Vector predict(const Matrix& X) const;
+    virtual double predict(const Vector& xrow) const;
+    // Predicts from views of either precision, which are not copied.
+    Vector predict(const MatrixView& X) const;
+    Vector predict(const FloatMatrixView& X) const;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef RANDOM_GENERATOR_HPP
+#define RANDOM_GENERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// RandomGenerator is a small, fast and seedable pseudo-random number
+// generator (xoshiro256**), for sampling rows in the solvers' loops. Unlike
+// rand(), it has no global state, so every user (e.g. every thread) can own
+// a generator of its own.
+// Independent streams: jump() advances the generator by 2^128 steps, so
+// the generators obtained by getStream(0), getStream(1), ... from the same
+// seed produce non-overlapping sequences (for any practical length).
+
+class RandomGenerator
+{
+    uint64_t m_state[4];
+public:
+    explicit RandomGenerator(uint64_t seed=0);
+    uint64_t next();
+    // Uniform in [0, 1).
+    double getUniform();
+    // Uniform in [0, n), without the bias of next() % n.
+    size_t getBounded(size_t n);
+    void jump();
+    // A copy of this generator, jumped streamIndex times.
+    RandomGenerator getStream(size_t streamIndex) const;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// TaskGroup keeps count of the unfinished tasks that were submitted to a
+// ThreadPool under it, so that they can be waited for together.
+
+class TaskGroup
+{
+    std::atomic<size_t> m_numPendingTasks;
+    friend class ThreadPool;
+public:
+    TaskGroup();
+};
+
+// ThreadPool is a persistent pool of worker threads with work stealing.
+// Every worker owns a queue of tasks. A worker runs the most recently
+// submitted task of its own queue first (which keeps the data it works on
+// in cache) and, when its queue is empty, steals the oldest task from
+// another queue (which tends to be the largest piece of work left).
+// Tasks may submit further tasks, e.g. for recursive divide and conquer.
+// The number of threads includes the thread that waits for a TaskGroup:
+// it does not sit idle but runs queued tasks until its group is finished.
+// Hence a pool with a single thread runs everything serially, in the
+// calling thread, and starts no thread at all.
+
+class ThreadPool
+{
+    struct Task
+    {
+        std::function<void()> function;
+        TaskGroup* group;
+    };
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    size_t m_numThreads;
+    std::vector<std::thread> m_workers;
+    // Queue 0 receives tasks from threads outside the pool; queue k > 0
+    // belongs to worker k.
+    std::vector<std::unique_ptr<TaskQueue> > m_queues;
+    std::atomic<size_t> m_numQueuedTasks;
+    bool m_stop;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCondition;
+
+    size_t getCurrentQueue() const;
+    bool popTask(size_t queue, Task& task);
+    bool stealTask(size_t thiefQueue, Task& task);
+    bool runPendingTask();
+    void workerLoop(size_t queue);
+public:
+    explicit ThreadPool(size_t numThreads=getDefaultNumThreads());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    size_t getNumThreads() const;
+    void submit(TaskGroup& group, const std::function<void()>& task);
+    void wait(TaskGroup& group);
+    // Runs task(0), ..., task(numTasks - 1) in parallel and waits for them.
+    void parallelFor(size_t numTasks, const std::function<void(size_t)>& task);
+    static size_t getDefaultNumThreads();
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "binned_matrix.hpp"
+#include <algorithm>
+#include <iterator>
+#include <cassert>
+
+BinnedMatrix::BinnedMatrix()
+{
+    m_numRows = 0;
+    m_numColumns = 0;
+}
+
+BinnedMatrix::BinnedMatrix(const Matrix& X, size_t maxNumBins)
+:BinnedMatrix(DenseMatrix(X).getView(), maxNumBins)
+{
+}
+
+BinnedMatrix::BinnedMatrix(const MatrixView& X, size_t maxNumBins)
+{
+    build(X, maxNumBins);
+}
+
+BinnedMatrix::BinnedMatrix(const FloatMatrixView& X, size_t maxNumBins)
+{
+    build(X, maxNumBins);
+}
+
+template<typename T>
+void BinnedMatrix::build(const BasicMatrixView<T>& X, size_t maxNumBins)
+{
+    assert((maxNumBins > 1) && (maxNumBins <= MAX_NUM_BINS));
+    m_numRows = X.getNumRows();
+    m_numColumns = X.getNumColumns();
+    m_bins.resize(m_numRows * m_numColumns);
+    m_thresholds.resize(m_numColumns);
+    m_binOffsets.resize(m_numColumns + 1);
+    m_binOffsets[0] = 0;
+    std::vector<double> values(m_numRows);
+    for(size_t j = 0; j < m_numColumns; j++)
+    {
+        for(size_t i = 0; i < m_numRows; i++)
+        {
+            values[i] = X(i, j);
+        }
+        std::sort(values.begin(), values.end());
+        std::vector<double>& thresholds = m_thresholds[j];
+        std::vector<double> distinctValues = {};
+        std::unique_copy(values.begin(), values.end(), std::back_inserter(distinctValues));
+        if(distinctValues.size() <= maxNumBins)
+        {
+            // Every distinct value gets a bin of its own; splits are then exact.
+            thresholds.assign(distinctValues.begin() + 1, distinctValues.end());
+        }
+        else
+        {
+            // Thresholds are picked at equally spaced quantiles, so that
+            // the bins hold roughly the same number of rows. Repeated
+            // values may merge some of the bins.
+            for(size_t b = 1; b < maxNumBins; b++)
+            {
+                double threshold = values[(b * m_numRows) / maxNumBins];
+                double lastThreshold = thresholds.empty() ? values[0] : thresholds.back();
+                if(lastThreshold < threshold)
+                {
+                    thresholds.push_back(threshold);
+                }
+            }
+        }
+        for(size_t i = 0; i < m_numRows; i++)
+        {
+            // Number of thresholds not greater than the value.
+            size_t bin = std::upper_bound(thresholds.begin(), thresholds.end(), X(i, j)) - thresholds.begin();
+            m_bins[i * m_numColumns + j] = uint8_t(bin);
+        }
+        m_binOffsets[j + 1] = m_binOffsets[j] + thresholds.size() + 1;
+    }
+}
+
+size_t BinnedMatrix::getNumRows() const
+{
+    return m_numRows;
+}
+
+size_t BinnedMatrix::getNumColumns() const
+{
+    return m_numColumns;
+}
+
+size_t BinnedMatrix::getNumBins(size_t column) const
+{
+    return m_thresholds[column].size() + 1;
+}
+
+size_t BinnedMatrix::getTotalNumBins() const
+{
+    return m_binOffsets.empty() ? 0 : m_binOffsets[m_numColumns];
+}
+
+size_t BinnedMatrix::getBinOffset(size_t column) const
+{
+    return m_binOffsets[column];
+}
+
+uint8_t BinnedMatrix::getBin(size_t row, size_t column) const
+{
+    return m_bins[row * m_numColumns + column];
+}
+
+const uint8_t* BinnedMatrix::getRow(size_t row) const
+{
+    return m_bins.data() + row * m_numColumns;
+}
+
+double BinnedMatrix::getThreshold(size_t column, size_t bin) const
+{
+    return m_thresholds[column][bin];
+}
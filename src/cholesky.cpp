@@ -0,0 +1,58 @@
+#include "cholesky.hpp"
+#include <cmath>
+
+bool choleskyDecompose(double* A, size_t n)
+{
+    for(size_t j = 0; j < n; j++)
+    {
+        // Rows of L are read along their (contiguous) leading entries.
+        double* rowJ = A + j * n;
+        double diagonal = rowJ[j];
+        for(size_t k = 0; k < j; k++)
+        {
+            diagonal -= rowJ[k] * rowJ[k];
+        }
+        if(!(diagonal > 0))
+        {
+            return false;
+        }
+        rowJ[j] = sqrt(diagonal);
+        for(size_t i = j + 1; i < n; i++)
+        {
+            double* rowI = A + i * n;
+            double value = rowI[j];
+            for(size_t k = 0; k < j; k++)
+            {
+                value -= rowI[k] * rowJ[k];
+            }
+            rowI[j] = value / rowJ[j];
+        }
+    }
+    return true;
+}
+
+void choleskySolve(const double* L, size_t n, double* b)
+{
+    // Forward substitution: L z = b
+    for(size_t i = 0; i < n; i++)
+    {
+        const double* rowI = L + i * n;
+        double value = b[i];
+        for(size_t k = 0; k < i; k++)
+        {
+            value -= rowI[k] * b[k];
+        }
+        b[i] = value / rowI[i];
+    }
+    // Back substitution: L-transpose x = z
+    for(size_t i = n; i > 0; i--)
+    {
+        size_t row = i - 1;
+        double value = b[row];
+        for(size_t k = row + 1; k < n; k++)
+        {
+            value -= L[k * n + row] * b[k];
+        }
+        b[row] = value / L[row * n + row];
+    }
+}
@@ -0,0 +1,41 @@
+#include "csr_matrix.hpp"
+#include <cassert>
+#include <limits>
+
+CsrMatrix::CsrMatrix(size_t numColumns)
+{
+    assert(numColumns <= std::numeric_limits<uint32_t>::max());
+    m_numColumns = numColumns;
+    m_rowOffsets.assign(1, 0);
+}
+
+CsrMatrix::CsrMatrix(const Matrix& X)
+:CsrMatrix(X.getNumColumns())
+{
+    const std::vector<std::vector<double> >& data = X.getData();
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        assert(data[i].size() == m_numColumns);
+        for(size_t j = 0; j < m_numColumns; j++)
+        {
+            if(data[i][j] != 0)
+            {
+                m_columns.push_back(uint32_t(j));
+                m_values.push_back(data[i][j]);
+            }
+        }
+        m_rowOffsets.push_back(m_values.size());
+    }
+}
+
+void CsrMatrix::addRow(const uint32_t* columns, const double* values, size_t numValues)
+{
+    for(size_t k = 0; k < numValues; k++)
+    {
+        assert(columns[k] < m_numColumns);
+        assert(k == 0 || columns[k - 1] < columns[k]);
+        m_columns.push_back(columns[k]);
+        m_values.push_back(values[k]);
+    }
+    m_rowOffsets.push_back(m_values.size());
+}
@@ -0,0 +1,315 @@
+#include "data_source.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+static const char BINARY_DATA_MAGIC[8] = {'M', 'L', 'R', 'O', 'W', 'S', '0', '1'};
+
+const size_t BinaryDataSource::HEADER_SIZE;
+
+DataChunk::DataChunk()
+{
+    numRows = 0;
+    numColumns = 0;
+}
+
+MatrixView DataChunk::getView() const
+{
+    return MatrixView(features.data(), numRows, numColumns, numColumns);
+}
+
+// Sets the targets of a chunk to the first numRows values of targets, in
+// place if the chunk already has numRows targets.
+static void setChunkTargets(const std::vector<double>& targets, size_t numRows, DataChunk& chunk)
+{
+    if(chunk.targets.size() != numRows)
+    {
+        chunk.targets = Vector(std::vector<double>(targets.begin(), targets.begin() + numRows));
+        return;
+    }
+    for(size_t i = 0; i < numRows; i++)
+    {
+        chunk.targets[i] = targets[i];
+    }
+}
+
+CsvDataSource::CsvDataSource(const std::string& fileName)
+:m_file(fileName)
+{
+    m_numColumns = 0;
+    m_numSkippedLines = 0;
+    // The first line made of numbers only (after a header, if any).
+    while(m_file.is_open() && std::getline(m_file, m_line))
+    {
+        if(parseLine() && m_values.size() > 0)
+        {
+            m_numColumns = m_values.size() - 1;
+            break;
+        }
+    }
+    rewind();
+}
+
+bool CsvDataSource::isOpen() const
+{
+    return m_file.is_open();
+}
+
+size_t CsvDataSource::getNumSkippedLines() const
+{
+    return m_numSkippedLines;
+}
+
+size_t CsvDataSource::getNumColumns() const
+{
+    return m_numColumns;
+}
+
+void CsvDataSource::rewind()
+{
+    m_file.clear();
+    m_file.seekg(0);
+    m_numSkippedLines = 0;
+}
+
+bool CsvDataSource::parseLine()
+{
+    // Reads the values of m_line into m_values; false if any of them is not
+    // a number.
+    m_values.clear();
+    const char* p = m_line.c_str();
+    while(*p != '\0')
+    {
+        char* end;
+        double value = strtod(p, &end);
+        if(end == p)
+        {
+            return false;
+        }
+        m_values.push_back(value);
+        p = end;
+        while(*p == ' ' || *p == '\r')
+        {
+            p++;
+        }
+        if(*p == ',')
+        {
+            p++;
+        }
+        else if(*p != '\0')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CsvDataSource::readChunk(size_t maxNumRows, DataChunk& chunk)
+{
+    chunk.numColumns = m_numColumns;
+    chunk.numRows = 0;
+    chunk.features.resize(maxNumRows * m_numColumns);
+    m_targets.resize(maxNumRows);
+    while(chunk.numRows < maxNumRows && std::getline(m_file, m_line))
+    {
+        if(m_line.empty())
+        {
+            continue;
+        }
+        if(!parseLine() || m_values.size() != m_numColumns + 1)
+        {
+            m_numSkippedLines++;
+            continue;
+        }
+        std::copy(m_values.begin(), m_values.begin() + m_numColumns, chunk.features.begin() + chunk.numRows * m_numColumns);
+        m_targets[chunk.numRows] = m_values[m_numColumns];
+        chunk.numRows++;
+    }
+    chunk.features.resize(chunk.numRows * m_numColumns);
+    setChunkTargets(m_targets, chunk.numRows, chunk);
+    return chunk.numRows > 0;
+}
+
+BinaryDataSource::BinaryDataSource(const std::string& fileName)
+{
+    m_numColumns = 0;
+    m_file = fopen(fileName.c_str(), "rb");
+    char magic[8];
+    uint64_t numColumns;
+    if(m_file != nullptr && (fread(magic, 1, 8, m_file) != 8 || memcmp(magic, BINARY_DATA_MAGIC, 8) != 0 || fread(&numColumns, sizeof(numColumns), 1, m_file) != 1))
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    if(m_file != nullptr)
+    {
+        m_numColumns = size_t(numColumns);
+    }
+}
+
+BinaryDataSource::~BinaryDataSource()
+{
+    if(m_file != nullptr)
+    {
+        fclose(m_file);
+    }
+}
+
+bool BinaryDataSource::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+size_t BinaryDataSource::getNumColumns() const
+{
+    return m_numColumns;
+}
+
+void BinaryDataSource::rewind()
+{
+    if(m_file != nullptr)
+    {
+        fseek(m_file, long(HEADER_SIZE), SEEK_SET);
+    }
+}
+
+bool BinaryDataSource::readChunk(size_t maxNumRows, DataChunk& chunk)
+{
+    size_t rowSize = m_numColumns + 1;
+    chunk.numColumns = m_numColumns;
+    chunk.numRows = 0;
+    if(m_file != nullptr)
+    {
+        m_buffer.resize(maxNumRows * rowSize);
+        // A partial row at the end of the file is ignored.
+        chunk.numRows = fread(m_buffer.data(), sizeof(double) * rowSize, maxNumRows, m_file);
+    }
+    chunk.features.resize(chunk.numRows * m_numColumns);
+    m_targets.resize(chunk.numRows);
+    for(size_t i = 0; i < chunk.numRows; i++)
+    {
+        const double* row = &m_buffer[i * rowSize];
+        std::copy(row, row + m_numColumns, chunk.features.begin() + i * m_numColumns);
+        m_targets[i] = row[m_numColumns];
+    }
+    setChunkTargets(m_targets, chunk.numRows, chunk);
+    return chunk.numRows > 0;
+}
+
+bool writeBinaryData(const MatrixView& X, const Vector& y, const std::string& fileName)
+{
+    assert(X.getNumRows() == y.size());
+    FILE* file = fopen(fileName.c_str(), "wb");
+    if(file == nullptr)
+    {
+        return false;
+    }
+    uint64_t numColumns = X.getNumColumns();
+    bool isWritten = (fwrite(BINARY_DATA_MAGIC, 1, 8, file) == 8) && (fwrite(&numColumns, sizeof(numColumns), 1, file) == 1);
+    std::vector<double> row(X.getNumColumns() + 1);
+    for(size_t i = 0; i < X.getNumRows() && isWritten; i++)
+    {
+        std::copy(X.getRow(i), X.getRow(i) + X.getNumColumns(), row.begin());
+        row[X.getNumColumns()] = y[i];
+        isWritten = (fwrite(row.data(), sizeof(double), row.size(), file) == row.size());
+    }
+    return (fclose(file) == 0) && isWritten;
+}
+
+ChunkPrefetcher::ChunkPrefetcher(DataSource& source, size_t chunkSize)
+:m_source(source)
+{
+    assert(chunkSize > 0);
+    m_chunkSize = chunkSize;
+    m_numReadChunks = 0;
+    m_numTakenChunks = 0;
+    m_numReleasedChunks = 0;
+    m_isEndReached = true;
+    m_stop = false;
+}
+
+ChunkPrefetcher::~ChunkPrefetcher()
+{
+    stop();
+}
+
+void ChunkPrefetcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    if(m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void ChunkPrefetcher::start()
+{
+    stop();
+    m_numReadChunks = 0;
+    m_numTakenChunks = 0;
+    m_numReleasedChunks = 0;
+    m_isEndReached = false;
+    m_stop = false;
+    m_thread = std::thread(&ChunkPrefetcher::readLoop, this);
+}
+
+void ChunkPrefetcher::readLoop()
+{
+    m_source.rewind();
+    while(true)
+    {
+        size_t chunk;
+        {
+            // Wait for a buffer that the caller no longer uses.
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this](){ return m_stop || m_numReadChunks < m_numReleasedChunks + 2; });
+            if(m_stop)
+            {
+                return;
+            }
+            chunk = m_numReadChunks % 2;
+        }
+        // The buffer is read without the lock: the caller does not touch it.
+        bool isRead = m_source.readChunk(m_chunkSize, m_chunks[chunk]);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(isRead)
+            {
+                m_numReadChunks++;
+            }
+            else
+            {
+                m_isEndReached = true;
+            }
+        }
+        m_condition.notify_all();
+        if(!isRead)
+        {
+            return;
+        }
+    }
+}
+
+const DataChunk* ChunkPrefetcher::next()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // The chunk returned by the previous call is given back for reading.
+    if(m_numReleasedChunks < m_numTakenChunks)
+    {
+        m_numReleasedChunks++;
+        m_condition.notify_all();
+    }
+    m_condition.wait(lock, [this](){ return m_numTakenChunks < m_numReadChunks || m_isEndReached; });
+    if(m_numTakenChunks == m_numReadChunks)
+    {
+        return nullptr;
+    }
+    const DataChunk* chunk = &m_chunks[m_numTakenChunks % 2];
+    m_numTakenChunks++;
+    return chunk;
+}
@@ -0,0 +1,266 @@
+#include "decision_tree.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+const size_t DecisionTree::BATCH_SIZE;
+
+DecisionTree::DecisionTree()
+{
+    m_columns = {};
+    m_children = {};
+    m_values = {};
+}
+
+void DecisionTree::reset(size_t expectedNumNodes)
+{
+    m_columns.clear();
+    m_children.clear();
+    m_values.clear();
+    m_columns.reserve(expectedNumNodes);
+    m_children.reserve(expectedNumNodes);
+    m_values.reserve(expectedNumNodes);
+    m_columns.push_back(0);
+    m_children.push_back(0);
+    m_values.push_back(0);
+}
+
+size_t DecisionTree::getNumNodes() const
+{
+    return m_values.size();
+}
+
+bool DecisionTree::isLeaf(size_t node) const
+{
+    return m_children[node] == 0;
+}
+
+size_t DecisionTree::getColumn(size_t node) const
+{
+    return m_columns[node];
+}
+
+size_t DecisionTree::getLeftChild(size_t node) const
+{
+    return m_children[node];
+}
+
+size_t DecisionTree::getRightChild(size_t node) const
+{
+    return m_children[node] + 1;
+}
+
+double DecisionTree::getNodeValue(size_t node) const
+{
+    return m_values[node];
+}
+
+void DecisionTree::setLeaf(size_t node, double value)
+{
+    m_columns[node] = 0;
+    m_children[node] = 0;
+    m_values[node] = value;
+}
+
+size_t DecisionTree::setSplit(size_t node, size_t column, double splitValue)
+{
+    size_t left = m_values.size();
+    assert(left + 2 <= UINT32_MAX);
+    assert(column <= UINT32_MAX);
+    m_columns[node] = uint32_t(column);
+    m_children[node] = uint32_t(left);
+    m_values[node] = splitValue;
+    for(size_t k = 0; k < 2; k++)
+    {
+        m_columns.push_back(0);
+        m_children.push_back(0);
+        m_values.push_back(0);
+    }
+    return left;
+}
+
+void DecisionTree::setSubtree(size_t node, const DecisionTree& subtree)
+{
+    assert(isLeaf(node));
+    // Node k > 0 of the subtree becomes node (offset + k) of this tree.
+    size_t offset = m_values.size() - 1;
+    assert(offset + subtree.getNumNodes() <= UINT32_MAX);
+    m_columns[node] = subtree.m_columns[0];
+    m_children[node] = subtree.isLeaf(0) ? 0 : uint32_t(subtree.m_children[0] + offset);
+    m_values[node] = subtree.m_values[0];
+    for(size_t k = 1; k < subtree.getNumNodes(); k++)
+    {
+        m_columns.push_back(subtree.m_columns[k]);
+        m_children.push_back(subtree.isLeaf(k) ? 0 : uint32_t(subtree.m_children[k] + offset));
+        m_values.push_back(subtree.m_values[k]);
+    }
+}
+
+template<typename T>
+double DecisionTree::getRowValue(const T* x) const
+{
+    size_t node = 0;
+    while(m_children[node] != 0)
+    {
+        // The right child is next to the left one.
+        node = m_children[node] + ((x[m_columns[node]] < m_values[node]) ? 0 : 1);
+    }
+    return m_values[node];
+}
+
+double DecisionTree::getValue(const double* x) const
+{
+    return getRowValue(x);
+}
+
+double DecisionTree::getValue(const Vector& x) const
+{
+    return getValue(x.getData().data());
+}
+
+double DecisionTree::getValue(const float* x) const
+{
+    return getRowValue(x);
+}
+
+template<typename T>
+void DecisionTree::getBatchValues(const T* const* rows, size_t numRows, double* values) const
+{
+    const uint32_t* columns = m_columns.data();
+    const uint32_t* children = m_children.data();
+    const double* nodeValues = m_values.data();
+    for(size_t begin = 0; begin < numRows; begin += BATCH_SIZE)
+    {
+        size_t batchSize = std::min(BATCH_SIZE, numRows - begin);
+        const T* const* batchRows = rows + begin;
+        uint32_t nodes[BATCH_SIZE] = {};
+        // The loop runs as many times as the depth of the deepest leaf
+        // reached by the batch.
+        bool isActive = (children[0] != 0);
+        while(isActive)
+        {
+            isActive = false;
+            for(size_t k = 0; k < batchSize; k++)
+            {
+                uint32_t node = nodes[k];
+                uint32_t child = children[node];
+                // Leaves have column 0, which every row has.
+                uint32_t next = child + uint32_t(!(batchRows[k][columns[node]] < nodeValues[node]));
+                node = (child != 0) ? next : node;
+                nodes[k] = node;
+                // The nodes of the next level are fetched while the other
+                // rows of the batch are advanced.
+                uint32_t nextChild = children[node];
+#if defined(__GNUC__)
+                __builtin_prefetch(columns + nextChild);
+                __builtin_prefetch(nodeValues + nextChild);
+                __builtin_prefetch(children + nextChild);
+#endif
+                isActive |= (nextChild != 0);
+            }
+        }
+        for(size_t k = 0; k < batchSize; k++)
+        {
+            values[begin + k] = nodeValues[nodes[k]];
+        }
+    }
+}
+
+void DecisionTree::getValues(const double* const* rows, size_t numRows, double* values) const
+{
+    getBatchValues(rows, numRows, values);
+}
+
+void DecisionTree::getValues(const float* const* rows, size_t numRows, double* values) const
+{
+    getBatchValues(rows, numRows, values);
+}
+
+std::string DecisionTree::getText(size_t node) const
+{
+    std::ostringstream ss;
+    if(isLeaf(node))
+    {
+        ss << "LNODE: " << m_values[node];
+    }
+    else
+    {
+        ss << "INODE: x[" << m_columns[node] << "] < " << m_values[node];
+    }
+    return ss.str();
+}
+
+void DecisionTree::describe() const
+{
+    if(m_values.empty())
+    {
+        return;
+    }
+    // Depth first, left before right; an explicit stack is used so that
+    // deep trees cannot overflow the call stack.
+    std::vector<std::pair<size_t, size_t> > nodesAndDepths = {std::make_pair(0, 0)};
+    while(!nodesAndDepths.empty())
+    {
+        size_t node = nodesAndDepths.back().first;
+        size_t depth = nodesAndDepths.back().second;
+        nodesAndDepths.pop_back();
+        std::cout << std::string(3 * depth, ' ') << getText(node) << std::endl;
+        if(!isLeaf(node))
+        {
+            nodesAndDepths.push_back(std::make_pair(getRightChild(node), depth + 1));
+            nodesAndDepths.push_back(std::make_pair(getLeftChild(node), depth + 1));
+        }
+    }
+}
+
+std::string DecisionTree::getSource(const std::string& functionName) const
+{
+    std::ostringstream ss;
+    ss.precision(17);
+    ss << "// Generated from a decision tree of " << getNumNodes() << " nodes." << std::endl;
+    ss << "extern \"C\" double " << functionName << "(const double* x)" << std::endl;
+    ss << "{" << std::endl;
+    // Depth first, with an explicit stack, as in describe. An internal node
+    // is visited three times: to open its left branch, to open its right
+    // branch, and to close it.
+    struct SourceStep
+    {
+        size_t node;
+        size_t depth;
+        size_t visit;
+    };
+    std::vector<SourceStep> steps = {{0, 1, 0}};
+    while(!steps.empty())
+    {
+        SourceStep step = steps.back();
+        steps.pop_back();
+        std::string indent(4 * step.depth, ' ');
+        if(isLeaf(step.node))
+        {
+            ss << indent << "return " << m_values[step.node] << ";" << std::endl;
+            continue;
+        }
+        if(step.visit == 0)
+        {
+            ss << indent << "if(x[" << m_columns[step.node] << "] < " << m_values[step.node] << ")" << std::endl;
+            ss << indent << "{" << std::endl;
+            steps.push_back({step.node, step.depth, 1});
+            steps.push_back({getLeftChild(step.node), step.depth + 1, 0});
+        }
+        else if(step.visit == 1)
+        {
+            ss << indent << "}" << std::endl;
+            ss << indent << "else" << std::endl;
+            ss << indent << "{" << std::endl;
+            steps.push_back({step.node, step.depth, 2});
+            steps.push_back({getRightChild(step.node), step.depth + 1, 0});
+        }
+        else
+        {
+            ss << indent << "}" << std::endl;
+        }
+    }
+    ss << "}" << std::endl;
+    return ss.str();
+}
@@ -1,172 +1,978 @@
 #include "decision_tree_regression_solver.hpp"
 #include "indexing_utils.hpp"
+#include <algorithm>
 #include <cassert>
+#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <random>
 
-DecisionTree::DecisionTree()
-{
-    isLeaf = true;
-    left = 0;
-    right = 0;
-}
+const uint32_t DecisionTreeRegressionSolver::NO_NODE;
 
-DecisionTree::~DecisionTree()
+DecisionTreeRegressionSolver::DecisionTreeRegressionSolver(size_t maxLeafSize, bool verbose)
 {
-    delete left;
-    delete right;
+    m_nodeCount = 0;
+    m_maxLeafSize = maxLeafSize;
+    m_verbose = verbose;
+    m_useHistograms = false;
+    m_maxNumBins = BinnedMatrix::MAX_NUM_BINS;
+    m_histogramMinRows = HISTOGRAM_MIN_ROWS;
+    m_threadPool = std::make_shared<ThreadPool>(1);
+    m_numFeaturesPerSplit = 0;
+    m_seed = 0;
+    m_maxDepth = 0;
+    m_minGain = 0;
+    m_numSampleRows = 0;
+    m_levelWise = false;
+    m_maxNumLeaves = 0;
 }
 
-double DecisionTree::getValue(const Vector& x) const
+DecisionTreeRegressionSolver::~DecisionTreeRegressionSolver()
 {
-    if(isLeaf)
+    if(m_verbose)
     {
-        return value;
+        std::cout << "Deleting tree" << std::endl;
     }
-    return (x.getData()[column] < splitValue) ? left->getValue(x) : right->getValue(x);
 }
 
-std::string DecisionTree::getText() const
+size_t DecisionTreeRegressionSolver::getNodeCount() const
+{
+    return m_nodeCount;
+}
+
+void DecisionTreeRegressionSolver::setHistogramMode(bool useHistograms, size_t maxNumBins)
+{
+    m_useHistograms = useHistograms;
+    m_maxNumBins = maxNumBins;
+}
+
+void DecisionTreeRegressionSolver::setHistogramMinRows(size_t histogramMinRows)
+{
+    m_histogramMinRows = histogramMinRows;
+}
+
+void DecisionTreeRegressionSolver::setNumThreads(size_t numThreads)
+{
+    m_threadPool = std::make_shared<ThreadPool>(numThreads);
+}
+
+void DecisionTreeRegressionSolver::setFeatureSubsampling(size_t numFeaturesPerSplit, uint64_t seed)
+{
+    m_numFeaturesPerSplit = numFeaturesPerSplit;
+    m_seed = seed;
+}
+
+void DecisionTreeRegressionSolver::setMaxDepth(size_t maxDepth)
+{
+    m_maxDepth = maxDepth;
+}
+
+void DecisionTreeRegressionSolver::setMinGain(double minGain)
+{
+    m_minGain = minGain;
+}
+
+void DecisionTreeRegressionSolver::setLevelWiseGrowth(bool levelWise, size_t maxNumLeaves)
+{
+    m_levelWise = levelWise;
+    m_maxNumLeaves = maxNumLeaves;
+}
+
+const std::vector<double>& DecisionTreeRegressionSolver::getTrainingPredictions() const
+{
+    return m_trainingPredictions;
+}
+
+const DecisionTree& DecisionTreeRegressionSolver::getTree() const
+{
+    return m_tree;
+}
+
+void DecisionTreeRegressionSolver::log(const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(m_logMutex);
+    std::cout << message << std::endl;
+}
+
+void DecisionTreeRegressionSolver::describeTree() const
+{
+    m_tree.describe();
+}
+
+bool DecisionTreeRegressionSolver::exportSource(const std::string& fileName, const std::string& functionName) const
 {
-    std::ostringstream ss;
-    if(isLeaf)
+    std::ofstream outFile(fileName, std::ios::out);
+    outFile << m_tree.getSource(functionName);
+    outFile.close();
+    return !outFile.fail();
+}
+
+std::pair<size_t, double> getOptimalSplit(const MatrixView& X, const Vector& y, size_t column, const size_t* sortedIndices, size_t numIndices, double ysum)
+{
+    // An index of 0 is returned when no split is possible, i.e. when all
+    // the values of the column are identical.
+    double minRSSVal = 0;
+    size_t index = 0;
+    double xa = 0;
+    for(size_t i = 1; i < numIndices; i++)
     {
-        ss << "LNODE: " << value;
+        size_t lastIndex = sortedIndices[i - 1];
+        xa = (xa * (i - 1) + y[lastIndex]) / i;
+        double xb = (ysum - i * xa) / (numIndices - i);
+        double curRSSVal = -(i * xa * xa + (numIndices - i) * xb * xb);
+        bool isLastValueDifferent = X(lastIndex, column) != X(sortedIndices[i], column);
+        if(isLastValueDifferent && (curRSSVal < minRSSVal))
+        {
+            minRSSVal = curRSSVal;
+            index = i;
+        }
     }
-    else
+    return std::make_pair(index, minRSSVal);
+}
+
+// partitionIndices copies a node's index list into the lists of its
+// children, which are laid out next to each other: the numLeft indices
+// going left first, then the ones going right. The partition is stable,
+// so sorted lists remain sorted and never need to be sorted again.
+void partitionIndices(const size_t* indices, size_t numIndices, const std::vector<char>& goesLeft, size_t* partitionedIndices, size_t numLeft)
+{
+    size_t* leftIndices = partitionedIndices;
+    size_t* rightIndices = partitionedIndices + numLeft;
+    for(size_t k = 0; k < numIndices; k++)
     {
-        ss << "INODE: x[" << column << "] < " << splitValue;
+        size_t i = indices[k];
+        if(goesLeft[i])
+        {
+            *(leftIndices++) = i;
+        }
+        else
+        {
+            *(rightIndices++) = i;
+        }
     }
-    return ss.str();
 }
 
-void DecisionTree::describe(std::string indent) const
+// getChildSeed derives the seed of a child node (childNumber 0 for left,
+// 1 for right) from the seed of its parent, using the splitmix64 mixer.
+uint64_t getChildSeed(uint64_t nodeSeed, uint64_t childNumber)
 {
-    std::cout << indent << getText() << std::endl;
-    if(left)
+    uint64_t z = nodeSeed + 0x9e3779b97f4a7c15ULL * (childNumber + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+const std::vector<size_t>& DecisionTreeRegressionSolver::getSplitCandidateColumns(size_t numColumns, uint64_t nodeSeed) const
+{
+    // Per thread scratch list, so that no node allocates memory of its own.
+    static thread_local std::vector<size_t> columns;
+    columns.resize(numColumns);
+    for(size_t j = 0; j < numColumns; j++)
+    {
+        columns[j] = j;
+    }
+    if((m_numFeaturesPerSplit == 0) || (m_numFeaturesPerSplit >= numColumns))
     {
-        left->describe(indent + "   ");
+        return columns;
     }
-    if(right)
+    // Partial Fisher-Yates shuffle: only the first numFeaturesPerSplit
+    // positions are drawn.
+    std::mt19937_64 generator(nodeSeed);
+    for(size_t k = 0; k < m_numFeaturesPerSplit; k++)
     {
-        right->describe(indent + "   ");
+        std::uniform_int_distribution<size_t> distribution(k, numColumns - 1);
+        std::swap(columns[k], columns[distribution(generator)]);
     }
+    columns.resize(m_numFeaturesPerSplit);
+    // Sorted, so that ties between columns are resolved as usual.
+    std::sort(columns.begin(), columns.end());
+    return columns;
 }
 
-DecisionTreeRegressionSolver::DecisionTreeRegressionSolver(size_t maxLeafSize, bool verbose)
+// updateOptimalSplit keeps the better of the current optimal split and the
+// split found for another column. Columns must be offered in ascending
+// order, whichever thread searched them, so that ties are always resolved
+// the same way (in favor of the first column).
+void updateOptimalSplit(const std::pair<size_t, double>& split, size_t column, size_t& optimalColumn, size_t& optimalIndex, double& minRSSVal)
 {
-    m_tree = 0;
-    m_nodeCount = 0;
-    m_maxLeafSize = maxLeafSize;
-    m_verbose = verbose;
+    if((split.first > 0) && (split.second < minRSSVal))
+    {
+        minRSSVal = split.second;
+        optimalIndex = split.first;
+        optimalColumn = column;
+    }
 }
 
-DecisionTreeRegressionSolver::~DecisionTreeRegressionSolver()
+bool DecisionTreeRegressionSolver::canSplit(size_t numRows, size_t depth) const
 {
-    if(m_verbose)
+    return (numRows > m_maxLeafSize) && ((m_maxDepth == 0) || (depth < m_maxDepth));
+}
+
+bool DecisionTreeRegressionSolver::isGainSufficient(double minRSSVal, double ysum, size_t numRows) const
+{
+    // The RSS of a node is SUM(y * y) - ysum * ysum / n, and the split
+    // criterion is -(na * xa * xa + nb * xb * xb); hence the decrease in
+    // RSS brought by the split is (-minRSSVal - ysum * ysum / n).
+    return (m_minGain <= 0) || (-minRSSVal - ysum * ysum / numRows >= m_minGain);
+}
+
+void DecisionTreeRegressionSolver::setLeaf(DecisionTree& tree, size_t node, const size_t* rows, size_t numRows, double ysum)
+{
+    double value = ysum / numRows;
+    tree.setLeaf(node, value);
+    for(size_t k = 0; k < numRows; k++)
     {
-        std::cout << "Deleting tree" << std::endl;
+        m_trainingPredictions[rows[k]] = value;
     }
-    delete m_tree;
 }
 
-size_t DecisionTreeRegressionSolver::getNodeCount() const
+size_t* DecisionTreeRegressionSolver::getIndices(size_t depth, size_t list, size_t begin)
 {
-    return m_nodeCount;
+    return m_indexBuffers[depth % 2].data() + list * m_numSampleRows + begin;
 }
 
-void DecisionTreeRegressionSolver::describeTree() const
+void DecisionTreeRegressionSolver::allocateIndexBuffers(size_t numLists, size_t numSampleRows, size_t numDatasetRows)
+{
+    m_numSampleRows = numSampleRows;
+    m_indexBuffers[0].resize(numLists * numSampleRows);
+    m_indexBuffers[1].resize(numLists * numSampleRows);
+    m_goesLeft.assign(numDatasetRows, 0);
+}
+
+void DecisionTreeRegressionSolver::releaseIndexBuffers()
+{
+    std::vector<size_t>().swap(m_indexBuffers[0]);
+    std::vector<size_t>().swap(m_indexBuffers[1]);
+    std::vector<char>().swap(m_goesLeft);
+    std::vector<uint32_t>().swap(m_rowNodes);
+}
+
+void DecisionTreeRegressionSolver::buildDecisionTree(const MatrixView& X, const Vector& y, size_t begin, size_t end, DecisionTree& tree, size_t node, size_t depth, uint64_t nodeSeed)
+{
+    size_t curNodeId = m_nodeCount++;
+    if(m_verbose)
+    {
+        log("Building tree node: " + std::to_string(curNodeId));
+    }
+    // Every column's list holds the same indices (the ones belonging to
+    // this node), only in a different order.
+    const size_t* indicesToInspect = getIndices(depth, 0, begin);
+    size_t numRows = end - begin;
+    size_t numColumns = X.getNumColumns();
+    double ysum = 0;
+    for(size_t k = 0; k < numRows; k++)
+    {
+        ysum += y[indicesToInspect[k]];
+    }
+    bool isParallel = (numRows >= PARALLEL_SPLIT_SEARCH_MIN_ROWS);
+    size_t optimalColumn = 0;
+    size_t optimalIndex = 0;
+    double minRSSVal = 0;
+    if(canSplit(numRows, depth))
+    {
+        if(isParallel)
+        {
+            // A copy: while waiting, this thread may run other nodes, which
+            // overwrite the scratch list of getSplitCandidateColumns.
+            std::vector<size_t> candidateColumns = getSplitCandidateColumns(numColumns, nodeSeed);
+            std::vector<std::pair<size_t, double> > columnSplits(candidateColumns.size());
+            m_threadPool->parallelFor(candidateColumns.size(), [&](size_t k)
+            {
+                columnSplits[k] = getOptimalSplit(X, y, candidateColumns[k], getIndices(depth, candidateColumns[k], begin), numRows, ysum);
+            });
+            for(size_t k = 0; k < candidateColumns.size(); k++)
+            {
+                updateOptimalSplit(columnSplits[k], candidateColumns[k], optimalColumn, optimalIndex, minRSSVal);
+            }
+        }
+        else
+        {
+            for(const auto& j: getSplitCandidateColumns(numColumns, nodeSeed))
+            {
+                updateOptimalSplit(getOptimalSplit(X, y, j, getIndices(depth, j, begin), numRows, ysum), j, optimalColumn, optimalIndex, minRSSVal);
+            }
+        }
+        if((optimalIndex > 0) && !isGainSufficient(minRSSVal, ysum, numRows))
+        {
+            optimalIndex = 0;
+        }
+    }
+    // A node becomes a leaf if it is small enough or deep enough, if it
+    // cannot be split at all (all its rows have identical feature values),
+    // or if no split decreases the RSS enough.
+    if(optimalIndex == 0)
+    {
+        setLeaf(tree, node, indicesToInspect, numRows, ysum);
+        if(m_verbose)
+        {
+            log("\tNode[" + std::to_string(curNodeId) + "]: " + tree.getText(node));
+        }
+        return;
+    }
+    const size_t* optimalIndices = getIndices(depth, optimalColumn, begin);
+    for(size_t k = 0; k < numRows; k++)
+    {
+        m_goesLeft[optimalIndices[k]] = (k < optimalIndex);
+    }
+    size_t left = tree.setSplit(node, optimalColumn, X(optimalIndices[optimalIndex], optimalColumn));
+    if(m_verbose)
+    {
+        log("\tNode[" + std::to_string(curNodeId) + "]: " + tree.getText(node));
+    }
+    // The children find their lists in the other buffer, at the same
+    // positions: [begin, begin + optimalIndex) and [begin + optimalIndex, end).
+    auto partitionColumn = [&](size_t j)
+    {
+        partitionIndices(getIndices(depth, j, begin), numRows, m_goesLeft, getIndices(depth + 1, j, begin), optimalIndex);
+    };
+    if(isParallel)
+    {
+        m_threadPool->parallelFor(numColumns, partitionColumn);
+    }
+    else
+    {
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            partitionColumn(j);
+        }
+    }
+    size_t middle = begin + optimalIndex;
+    // Large subtrees are built as separate tasks, into trees of their own,
+    // and attached once done. Small ones are built right here.
+    bool isLeftTask = (optimalIndex >= PARALLEL_SUBTREE_MIN_ROWS);
+    bool isRightTask = (numRows - optimalIndex >= PARALLEL_SUBTREE_MIN_ROWS);
+    if(!isLeftTask && !isRightTask)
+    {
+        buildDecisionTree(X, y, begin, middle, tree, left, depth + 1, getChildSeed(nodeSeed, 0));
+        buildDecisionTree(X, y, middle, end, tree, left + 1, depth + 1, getChildSeed(nodeSeed, 1));
+        return;
+    }
+    DecisionTree leftSubtree;
+    DecisionTree rightSubtree;
+    TaskGroup subtreeTasks;
+    if(isLeftTask)
+    {
+        m_threadPool->submit(subtreeTasks, [&]()
+        {
+            leftSubtree.reset();
+            buildDecisionTree(X, y, begin, middle, leftSubtree, 0, depth + 1, getChildSeed(nodeSeed, 0));
+        });
+    }
+    if(isRightTask)
+    {
+        m_threadPool->submit(subtreeTasks, [&]()
+        {
+            rightSubtree.reset();
+            buildDecisionTree(X, y, middle, end, rightSubtree, 0, depth + 1, getChildSeed(nodeSeed, 1));
+        });
+    }
+    if(!isLeftTask)
+    {
+        buildDecisionTree(X, y, begin, middle, tree, left, depth + 1, getChildSeed(nodeSeed, 0));
+    }
+    if(!isRightTask)
+    {
+        buildDecisionTree(X, y, middle, end, tree, left + 1, depth + 1, getChildSeed(nodeSeed, 1));
+    }
+    m_threadPool->wait(subtreeTasks);
+    if(isLeftTask)
+    {
+        tree.setSubtree(left, leftSubtree);
+    }
+    if(isRightTask)
+    {
+        tree.setSubtree(left + 1, rightSubtree);
+    }
+}
+
+// getHistogramOptimalSplit finds the best split of a column from the
+// histogram of a node. The returned pair holds the number of bins that go
+// to the left (0 if the column cannot be split) and the RSS value.
+std::pair<size_t, double> getHistogramOptimalSplit(const BinnedMatrix& Xb, const FeatureHistogram& histogram, size_t column, double ysum, size_t count)
 {
-    if(m_tree)
+    const HistogramBin* bins = histogram.getColumnBins(Xb, column);
+    double minRSSVal = 0;
+    size_t numLeftBins = 0;
+    double leftSum = 0;
+    size_t leftCount = 0;
+    for(size_t b = 0; b + 1 < Xb.getNumBins(column); b++)
     {
-        m_tree->describe();
+        leftSum += bins[b].sum;
+        leftCount += bins[b].count;
+        size_t rightCount = count - leftCount;
+        if((leftCount == 0) || (rightCount == 0))
+        {
+            continue;
+        }
+        // Same criterion as in getOptimalSplit: -(na * xa * xa + nb * xb * xb)
+        double rightSum = ysum - leftSum;
+        double curRSSVal = -(leftSum * leftSum / leftCount + rightSum * rightSum / rightCount);
+        if(curRSSVal < minRSSVal)
+        {
+            minRSSVal = curRSSVal;
+            numLeftBins = b + 1;
+        }
     }
+    return std::make_pair(numLeftBins, minRSSVal);
 }
 
-std::pair<size_t, double> getOptimalSplit(const Matrix& X, const Vector& y, size_t column, const std::vector<size_t>& sortedIndices, double ysum)
+// Scratch space of getBinnedRowsOptimalSplit, kept by every thread.
+static thread_local std::vector<std::pair<uint8_t, double> > t_binValues;
+
+// getBinnedRowsOptimalSplit finds the same split as getHistogramOptimalSplit,
+// from the rows of a node rather than from its histogram: the (bin, target)
+// pairs of the rows are sorted, and only the boundaries between the bins
+// that hold rows are evaluated. For nodes with few rows, this is cheaper
+// than clearing, filling and scanning all the bins of every column.
+std::pair<size_t, double> getBinnedRowsOptimalSplit(const BinnedMatrix& Xb, const Vector& y, const size_t* rows, size_t numRows, size_t column, double ysum)
 {
+    std::vector<std::pair<uint8_t, double> >& binValues = t_binValues;
+    binValues.resize(numRows);
+    for(size_t k = 0; k < numRows; k++)
+    {
+        binValues[k] = std::make_pair(Xb.getBin(rows[k], column), y[rows[k]]);
+    }
+    std::sort(binValues.begin(), binValues.end(), [](const std::pair<uint8_t, double>& a, const std::pair<uint8_t, double>& b)
+    {
+        return a.first < b.first;
+    });
     double minRSSVal = 0;
-    size_t index;
-    double xa = 0;
-    for(size_t i = 1; i < sortedIndices.size(); i++)
+    size_t numLeftBins = 0;
+    double leftSum = 0;
+    for(size_t k = 0; k + 1 < numRows; k++)
     {
-        size_t lastIndex = sortedIndices[i - 1];
-        xa = (xa * (i - 1) + y[lastIndex]) / i;
-        double xb = (ysum - i * xa) / (sortedIndices.size() - i);
-        double curRSSVal = -(i * xa * xa + (sortedIndices.size() - i) * xb * xb);
-        bool isLastValueDifferent = X.getData()[lastIndex][column] != X.getData()[sortedIndices[i]][column];
-        if(isLastValueDifferent && (curRSSVal < minRSSVal))
+        leftSum += binValues[k].second;
+        if(binValues[k + 1].first == binValues[k].first)
+        {
+            continue;
+        }
+        size_t leftCount = k + 1;
+        // Same criterion as in getOptimalSplit: -(na * xa * xa + nb * xb * xb)
+        double rightSum = ysum - leftSum;
+        double curRSSVal = -(leftSum * leftSum / leftCount + rightSum * rightSum / (numRows - leftCount));
+        if(curRSSVal < minRSSVal)
         {
             minRSSVal = curRSSVal;
-            index = i;
+            numLeftBins = binValues[k].first + 1;
         }
     }
-    return std::make_pair(index, minRSSVal);
+    return std::make_pair(numLeftBins, minRSSVal);
+}
+
+// Histograms of finished nodes are kept for reuse by later nodes (of the
+// same thread), so that building a node does not allocate memory.
+static thread_local std::vector<FeatureHistogram> t_spareHistograms;
+
+FeatureHistogram acquireHistogram()
+{
+    if(t_spareHistograms.empty())
+    {
+        return FeatureHistogram();
+    }
+    FeatureHistogram histogram = std::move(t_spareHistograms.back());
+    t_spareHistograms.pop_back();
+    return histogram;
 }
 
-void DecisionTreeRegressionSolver::buildDecisionTree(const Matrix& X, const Vector& y, const std::vector<size_t>& indicesToInspect, DecisionTree *tree)
+void releaseHistogram(FeatureHistogram& histogram)
 {
-    size_t curNodeId = m_nodeCount;
+    t_spareHistograms.push_back(std::move(histogram));
+}
+
+void DecisionTreeRegressionSolver::buildHistogramDecisionTree(const BinnedMatrix& Xb, const Vector& y, size_t begin, size_t end, const FeatureHistogram* pHistogram, DecisionTree& tree, size_t node, size_t depth, uint64_t nodeSeed)
+{
+    size_t curNodeId = m_nodeCount++;
     if(m_verbose)
     {
-        std::cout << "Building tree node: " << curNodeId << std::endl;
+        log("Building tree node: " + std::to_string(curNodeId));
     }
-    m_nodeCount++;
-    assert(tree != 0);
+    const size_t* rows = getIndices(depth, 0, begin);
+    size_t numRows = end - begin;
+    size_t numColumns = Xb.getNumColumns();
     double ysum = 0;
-    for(const auto& i: indicesToInspect)
+    for(size_t k = 0; k < numRows; k++)
     {
-        ysum += y[i];
+        ysum += y[rows[k]];
+    }
+    size_t optimalColumn = 0;
+    size_t optimalNumLeftBins = 0;
+    double minRSSVal = 0;
+    if(canSplit(numRows, depth))
+    {
+        for(const auto& j: getSplitCandidateColumns(numColumns, nodeSeed))
+        {
+            std::pair<size_t, double> split = pHistogram ? getHistogramOptimalSplit(Xb, *pHistogram, j, ysum, numRows) : getBinnedRowsOptimalSplit(Xb, y, rows, numRows, j, ysum);
+            updateOptimalSplit(split, j, optimalColumn, optimalNumLeftBins, minRSSVal);
+        }
+        if((optimalNumLeftBins > 0) && !isGainSufficient(minRSSVal, ysum, numRows))
+        {
+            optimalNumLeftBins = 0;
+        }
     }
-    if(indicesToInspect.size() <= m_maxLeafSize)
+    if(optimalNumLeftBins == 0)
     {
-        tree->value = ysum / indicesToInspect.size();
-        tree->isLeaf = true;
+        setLeaf(tree, node, rows, numRows, ysum);
         if(m_verbose)
         {
-            std::cout << "\tNode[" << curNodeId << "]: " << tree->getText() << std::endl;
+            log("\tNode[" + std::to_string(curNodeId) + "]: " + tree.getText(node));
         }
         return;
     }
-    double minRSSVal = 0;
-    size_t optimalColumn;
-    size_t optimalIndex;
-    std::vector<size_t> optimalIndices;
-    for(size_t j = 0; j < X.getNumColumns(); j++)
+    size_t numLeft = 0;
+    for(size_t k = 0; k < numRows; k++)
     {
-        std::vector<size_t> sortedIndices = getColumnSortedIndices(X, j, indicesToInspect);
-        std::pair<size_t, double> split = getOptimalSplit(X, y, j, sortedIndices, ysum);
-        if(split.second < minRSSVal)
+        bool goesLeft = (Xb.getBin(rows[k], optimalColumn) < optimalNumLeftBins);
+        m_goesLeft[rows[k]] = goesLeft;
+        numLeft += goesLeft;
+    }
+    size_t middle = begin + numLeft;
+    partitionIndices(rows, numRows, m_goesLeft, getIndices(depth + 1, 0, begin), numLeft);
+    size_t left = tree.setSplit(node, optimalColumn, Xb.getThreshold(optimalColumn, optimalNumLeftBins - 1));
+    if(m_verbose)
+    {
+        log("\tNode[" + std::to_string(curNodeId) + "]: " + tree.getText(node));
+    }
+    // Only the smaller child's histogram is accumulated from its rows; the
+    // larger child's histogram is obtained by subtraction from the parent's.
+    // Children with few rows do without histograms.
+    bool isLeftSmaller = (numLeft < numRows - numLeft);
+    FeatureHistogram leftHistogram = acquireHistogram();
+    FeatureHistogram rightHistogram = acquireHistogram();
+    const FeatureHistogram* pLeftHistogram = (numLeft >= m_histogramMinRows) ? &leftHistogram : nullptr;
+    const FeatureHistogram* pRightHistogram = (numRows - numLeft >= m_histogramMinRows) ? &rightHistogram : nullptr;
+    if(pLeftHistogram || pRightHistogram)
+    {
+        FeatureHistogram& smallerHistogram = isLeftSmaller ? leftHistogram : rightHistogram;
+        FeatureHistogram& largerHistogram = isLeftSmaller ? rightHistogram : leftHistogram;
+        if(isLeftSmaller)
         {
-            minRSSVal = split.second;
-            optimalIndex = split.first;
-            optimalColumn = j;
-            optimalIndices = sortedIndices;
+            smallerHistogram.build(Xb, y, getIndices(depth + 1, 0, begin), numLeft);
         }
+        else
+        {
+            smallerHistogram.build(Xb, y, getIndices(depth + 1, 0, middle), numRows - numLeft);
+        }
+        largerHistogram.setDifference(*pHistogram, smallerHistogram);
     }
-    std::vector<size_t> leftIndices = {};
-    std::vector<size_t> rightIndices = {};
-    for(size_t i = 0; i < optimalIndices.size(); i++)
+    bool isLeftTask = (numLeft >= PARALLEL_SUBTREE_MIN_ROWS);
+    bool isRightTask = (numRows - numLeft >= PARALLEL_SUBTREE_MIN_ROWS);
+    if(!isLeftTask && !isRightTask)
     {
-        std::vector<size_t>& leftOrRightIndices = (i < optimalIndex) ? leftIndices : rightIndices;
-        leftOrRightIndices.push_back(optimalIndices[i]);
+        buildHistogramDecisionTree(Xb, y, begin, middle, pLeftHistogram, tree, left, depth + 1, getChildSeed(nodeSeed, 0));
+        buildHistogramDecisionTree(Xb, y, middle, end, pRightHistogram, tree, left + 1, depth + 1, getChildSeed(nodeSeed, 1));
+        releaseHistogram(leftHistogram);
+        releaseHistogram(rightHistogram);
+        return;
     }
-    tree->isLeaf = false;
-    tree->column = optimalColumn;
-    tree->splitValue = X.getData()[optimalIndices[optimalIndex]][optimalColumn];
-    DecisionTree *left = new DecisionTree();
-    DecisionTree *right = new DecisionTree();
-    tree->left = left;
-    tree->right = right;
-    if(m_verbose)
+    DecisionTree leftSubtree;
+    DecisionTree rightSubtree;
+    TaskGroup subtreeTasks;
+    if(isLeftTask)
+    {
+        m_threadPool->submit(subtreeTasks, [&]()
+        {
+            leftSubtree.reset();
+            buildHistogramDecisionTree(Xb, y, begin, middle, pLeftHistogram, leftSubtree, 0, depth + 1, getChildSeed(nodeSeed, 0));
+        });
+    }
+    if(isRightTask)
+    {
+        m_threadPool->submit(subtreeTasks, [&]()
+        {
+            rightSubtree.reset();
+            buildHistogramDecisionTree(Xb, y, middle, end, pRightHistogram, rightSubtree, 0, depth + 1, getChildSeed(nodeSeed, 1));
+        });
+    }
+    if(!isLeftTask)
+    {
+        buildHistogramDecisionTree(Xb, y, begin, middle, pLeftHistogram, tree, left, depth + 1, getChildSeed(nodeSeed, 0));
+    }
+    if(!isRightTask)
+    {
+        buildHistogramDecisionTree(Xb, y, middle, end, pRightHistogram, tree, left + 1, depth + 1, getChildSeed(nodeSeed, 1));
+    }
+    m_threadPool->wait(subtreeTasks);
+    releaseHistogram(leftHistogram);
+    releaseHistogram(rightHistogram);
+    if(isLeftTask)
+    {
+        tree.setSubtree(left, leftSubtree);
+    }
+    if(isRightTask)
+    {
+        tree.setSubtree(left + 1, rightSubtree);
+    }
+}
+
+size_t DecisionTreeRegressionSolver::getMaxFrontierSize(size_t numSampleRows) const
+{
+    // Only nodes of more than maxLeafSize rows are split, and every split
+    // adds two nodes to the next frontier; the depth and the leaf budget
+    // may bound the frontier further.
+    size_t maxSize = std::max(size_t(1), 2 * (numSampleRows / (m_maxLeafSize + 1)));
+    if((m_maxDepth > 0) && (m_maxDepth < 8 * sizeof(size_t) - 1))
+    {
+        maxSize = std::min(maxSize, size_t(1) << m_maxDepth);
+    }
+    if(m_maxNumLeaves > 0)
+    {
+        maxSize = std::min(maxSize, m_maxNumLeaves);
+    }
+    return maxSize;
+}
+
+std::vector<DecisionTreeRegressionSolver::LevelNode> DecisionTreeRegressionSolver::getLevelRoot(const Vector& y, const std::vector<size_t>& sampleCounts)
+{
+    LevelNode root = {};
+    root.node = 0;
+    root.seed = m_seed;
+    m_rowNodes.assign(y.size(), NO_NODE);
+    for(size_t i = 0; i < y.size(); i++)
+    {
+        if(sampleCounts[i] > 0)
+        {
+            m_rowNodes[i] = 0;
+            root.ysum += sampleCounts[i] * y[i];
+            root.count += sampleCounts[i];
+        }
+    }
+    return {root};
+}
+
+void DecisionTreeRegressionSolver::selectLevelSplits(std::vector<LevelNode>& frontier, size_t& numLeaves) const
+{
+    std::vector<size_t> splitNodes = {};
+    for(size_t f = 0; f < frontier.size(); f++)
+    {
+        LevelNode& levelNode = frontier[f];
+        if((levelNode.numLeft > 0) && !isGainSufficient(levelNode.rss, levelNode.ysum, levelNode.count))
+        {
+            levelNode.numLeft = 0;
+        }
+        if(levelNode.numLeft > 0)
+        {
+            splitNodes.push_back(f);
+        }
+    }
+    // Every split adds a leaf. If the budget does not allow splitting all
+    // the nodes, the ones whose splits decrease the RSS the most are split.
+    if((m_maxNumLeaves > 0) && (numLeaves + splitNodes.size() > m_maxNumLeaves))
+    {
+        size_t numSplits = (m_maxNumLeaves > numLeaves) ? (m_maxNumLeaves - numLeaves) : 0;
+        auto getGain = [&](size_t f)
+        {
+            const LevelNode& levelNode = frontier[f];
+            return -levelNode.rss - levelNode.ysum * levelNode.ysum / levelNode.count;
+        };
+        std::stable_sort(splitNodes.begin(), splitNodes.end(), [&](size_t f1, size_t f2)
+        {
+            return getGain(f1) > getGain(f2);
+        });
+        for(size_t k = numSplits; k < splitNodes.size(); k++)
+        {
+            frontier[splitNodes[k]].numLeft = 0;
+        }
+        splitNodes.resize(numSplits);
+    }
+    numLeaves += splitNodes.size();
+}
+
+std::vector<DecisionTreeRegressionSolver::LevelNode> DecisionTreeRegressionSolver::growLevel(const std::vector<LevelNode>& frontier, std::vector<uint32_t>& firstChildren)
+{
+    std::vector<LevelNode> nextFrontier = {};
+    firstChildren.assign(frontier.size(), NO_NODE);
+    for(size_t f = 0; f < frontier.size(); f++)
+    {
+        const LevelNode& levelNode = frontier[f];
+        size_t curNodeId = m_nodeCount++;
+        if(levelNode.numLeft == 0)
+        {
+            m_tree.setLeaf(levelNode.node, levelNode.ysum / levelNode.count);
+        }
+        else
+        {
+            size_t left = m_tree.setSplit(levelNode.node, levelNode.column, levelNode.splitValue);
+            firstChildren[f] = uint32_t(nextFrontier.size());
+            LevelNode child = {};
+            child.node = left;
+            child.seed = getChildSeed(levelNode.seed, 0);
+            child.ysum = levelNode.leftSum;
+            child.count = levelNode.numLeft;
+            nextFrontier.push_back(child);
+            child.node = left + 1;
+            child.seed = getChildSeed(levelNode.seed, 1);
+            child.ysum = levelNode.ysum - levelNode.leftSum;
+            child.count = levelNode.count - levelNode.numLeft;
+            nextFrontier.push_back(child);
+        }
+        if(m_verbose)
+        {
+            log("\tNode[" + std::to_string(curNodeId) + "]: " + m_tree.getText(levelNode.node));
+        }
+    }
+    assert(nextFrontier.size() < NO_NODE);
+    return nextFrontier;
+}
+
+void DecisionTreeRegressionSolver::buildLevelWiseDecisionTree(const MatrixView& X, const Vector& y, const std::vector<size_t>& sampleCounts, const std::vector<std::vector<size_t> >& columnSortedIndices)
+{
+    size_t numColumns = X.getNumColumns();
+    std::vector<LevelNode> frontier = getLevelRoot(y, sampleCounts);
+    size_t numLeaves = 1;
+    std::vector<uint32_t> firstChildren = {};
+    // The workspace of the column sweeps is sized once, for the largest
+    // frontier the tree can have.
+    size_t maxFrontierSize = getMaxFrontierSize(frontier[0].count);
+    size_t numTasks = std::min(m_threadPool->getNumThreads(), numColumns);
+    size_t numCandidates = getSplitCandidateColumns(numColumns, 0).size();
+    m_levelSplits.assign(numTasks * maxFrontierSize, LevelNode());
+    m_levelSweepStates.assign(numTasks * maxFrontierSize, LevelSweepState());
+    m_levelCandidates.assign((numCandidates < numColumns) ? maxFrontierSize * numCandidates : 0, 0);
+    for(size_t depth = 0; !frontier.empty(); depth++)
+    {
+        if(m_verbose)
+        {
+            log("Building tree level: " + std::to_string(depth));
+        }
+        size_t numNodes = frontier.size();
+        assert(numNodes <= maxFrontierSize);
+        // Sorted candidate columns of every frontier node, with feature
+        // subsampling.
+        if(numCandidates < numColumns)
+        {
+            for(size_t f = 0; f < numNodes; f++)
+            {
+                if(canSplit(frontier[f].count, depth))
+                {
+                    const std::vector<size_t>& columns = getSplitCandidateColumns(numColumns, frontier[f].seed);
+                    std::copy(columns.begin(), columns.end(), &m_levelCandidates[f * numCandidates]);
+                }
+            }
+        }
+        // Each task sweeps the sorted lists of its columns, in ascending
+        // order, and keeps the best split of every frontier node over them:
+        // one sweep over a column finds the best split of that column for
+        // all the frontier nodes, as the rows of a node are met in their
+        // sorted order, as in getOptimalSplit.
+        m_threadPool->parallelFor(numTasks, [&](size_t t)
+        {
+            LevelNode* splits = &m_levelSplits[t * maxFrontierSize];
+            LevelSweepState* states = &m_levelSweepStates[t * maxFrontierSize];
+            for(size_t f = 0; f < numNodes; f++)
+            {
+                splits[f].rss = 0;
+                splits[f].numLeft = 0;
+            }
+            for(size_t j = t; j < numColumns; j += numTasks)
+            {
+                for(size_t f = 0; f < numNodes; f++)
+                {
+                    const size_t* candidates = &m_levelCandidates[f * numCandidates];
+                    bool isCandidate = canSplit(frontier[f].count, depth) && ((numCandidates == numColumns) || std::binary_search(candidates, candidates + numCandidates, j));
+                    states[f] = {0, 0, 0, isCandidate};
+                }
+                for(const auto& i: columnSortedIndices[j])
+                {
+                    uint32_t f = m_rowNodes[i];
+                    if((f == NO_NODE) || !states[f].isCandidate)
+                    {
+                        continue;
+                    }
+                    LevelSweepState& state = states[f];
+                    double value = X(i, j);
+                    if((state.leftCount > 0) && (value != state.lastValue))
+                    {
+                        size_t numRight = frontier[f].count - state.leftCount;
+                        double rightSum = frontier[f].ysum - state.leftSum;
+                        double curRSSVal = -(state.leftSum * state.leftSum / state.leftCount + rightSum * rightSum / numRight);
+                        // Columns come in ascending order, so ties are
+                        // resolved as in depth-first growth.
+                        if(curRSSVal < splits[f].rss)
+                        {
+                            splits[f].column = j;
+                            splits[f].rss = curRSSVal;
+                            splits[f].splitValue = value;
+                            splits[f].leftSum = state.leftSum;
+                            splits[f].numLeft = state.leftCount;
+                        }
+                    }
+                    state.leftSum += sampleCounts[i] * y[i];
+                    state.leftCount += sampleCounts[i];
+                    state.lastValue = value;
+                }
+            }
+        });
+        // The best splits of the tasks are reduced, with ties between columns
+        // resolved in favour of the lower one.
+        for(size_t f = 0; f < numNodes; f++)
+        {
+            LevelNode& levelNode = frontier[f];
+            levelNode.rss = 0;
+            levelNode.numLeft = 0;
+            for(size_t t = 0; t < numTasks; t++)
+            {
+                const LevelNode& split = m_levelSplits[t * maxFrontierSize + f];
+                if(split.numLeft == 0)
+                {
+                    continue;
+                }
+                if((levelNode.numLeft == 0) || (split.rss < levelNode.rss) || ((split.rss == levelNode.rss) && (split.column < levelNode.column)))
+                {
+                    levelNode.column = split.column;
+                    levelNode.splitValue = split.splitValue;
+                    levelNode.rss = split.rss;
+                    levelNode.leftSum = split.leftSum;
+                    levelNode.numLeft = split.numLeft;
+                }
+            }
+        }
+        selectLevelSplits(frontier, numLeaves);
+        std::vector<LevelNode> nextFrontier = growLevel(frontier, firstChildren);
+        // A sequential sweep over the rows moves every row to its child in
+        // the next frontier, or settles its prediction if its node is a leaf.
+        for(size_t i = 0; i < y.size(); i++)
+        {
+            uint32_t f = m_rowNodes[i];
+            if(f == NO_NODE)
+            {
+                continue;
+            }
+            const LevelNode& levelNode = frontier[f];
+            if(firstChildren[f] == NO_NODE)
+            {
+                m_trainingPredictions[i] = levelNode.ysum / levelNode.count;
+                m_rowNodes[i] = NO_NODE;
+            }
+            else
+            {
+                bool goesLeft = (X(i, levelNode.column) < levelNode.splitValue);
+                m_rowNodes[i] = goesLeft ? firstChildren[f] : (firstChildren[f] + 1);
+            }
+        }
+        frontier.swap(nextFrontier);
+    }
+}
+
+void DecisionTreeRegressionSolver::buildLevelWiseHistogramDecisionTree(const BinnedMatrix& Xb, const Vector& y, const std::vector<size_t>& sampleCounts)
+{
+    size_t numColumns = Xb.getNumColumns();
+    std::vector<LevelNode> frontier = getLevelRoot(y, sampleCounts);
+    size_t numLeaves = 1;
+    std::vector<uint32_t> firstChildren = {};
+    std::vector<FeatureHistogram> histograms(1);
+    histograms[0].clear(Xb);
+    for(size_t i = 0; i < y.size(); i++)
     {
-        std::cout << "\tNode[" << curNodeId << "]: " << tree->getText() << std::endl;
+        if(sampleCounts[i] > 0)
+        {
+            histograms[0].addRow(Xb, i, y[i], sampleCounts[i]);
+        }
+    }
+    for(size_t depth = 0; !frontier.empty(); depth++)
+    {
+        if(m_verbose)
+        {
+            log("Building tree level: " + std::to_string(depth));
+        }
+        m_threadPool->parallelFor(frontier.size(), [&](size_t f)
+        {
+            LevelNode& levelNode = frontier[f];
+            size_t& numLeftBins = levelNode.numLeftBins;
+            numLeftBins = 0;
+            levelNode.rss = 0;
+            if(canSplit(levelNode.count, depth))
+            {
+                for(const auto& j: getSplitCandidateColumns(numColumns, levelNode.seed))
+                {
+                    updateOptimalSplit(getHistogramOptimalSplit(Xb, histograms[f], j, levelNode.ysum, levelNode.count), j, levelNode.column, numLeftBins, levelNode.rss);
+                }
+            }
+            levelNode.leftSum = 0;
+            levelNode.numLeft = 0;
+            if(numLeftBins > 0)
+            {
+                const HistogramBin* bins = histograms[f].getColumnBins(Xb, levelNode.column);
+                for(size_t b = 0; b < numLeftBins; b++)
+                {
+                    levelNode.leftSum += bins[b].sum;
+                    levelNode.numLeft += bins[b].count;
+                }
+                levelNode.splitValue = Xb.getThreshold(levelNode.column, numLeftBins - 1);
+            }
+        });
+        selectLevelSplits(frontier, numLeaves);
+        std::vector<LevelNode> nextFrontier = growLevel(frontier, firstChildren);
+        // Only the smaller child of a pair is accumulated from its rows, and
+        // only if one of the pair can be split further; the histogram of the
+        // larger child is obtained by subtraction.
+        std::vector<FeatureHistogram> nextHistograms(nextFrontier.size());
+        std::vector<char> isAccumulated(nextFrontier.size(), 0);
+        for(size_t f = 0; f < nextFrontier.size(); f += 2)
+        {
+            if(canSplit(nextFrontier[f].count, depth + 1) || canSplit(nextFrontier[f + 1].count, depth + 1))
+            {
+                size_t smaller = (nextFrontier[f].count < nextFrontier[f + 1].count) ? f : (f + 1);
+                isAccumulated[smaller] = 1;
+                nextHistograms[smaller] = acquireHistogram();
+                nextHistograms[smaller].clear(Xb);
+            }
+        }
+        // The same sequential sweep over the rows moves every row to its
+        // child, and accumulates the histograms of the next depth.
+        for(size_t i = 0; i < y.size(); i++)
+        {
+            uint32_t f = m_rowNodes[i];
+            if(f == NO_NODE)
+            {
+                continue;
+            }
+            const LevelNode& levelNode = frontier[f];
+            if(firstChildren[f] == NO_NODE)
+            {
+                m_trainingPredictions[i] = levelNode.ysum / levelNode.count;
+                m_rowNodes[i] = NO_NODE;
+                continue;
+            }
+            bool goesLeft = (Xb.getBin(i, levelNode.column) < levelNode.numLeftBins);
+            uint32_t child = goesLeft ? firstChildren[f] : (firstChildren[f] + 1);
+            m_rowNodes[i] = child;
+            if(isAccumulated[child])
+            {
+                nextHistograms[child].addRow(Xb, i, y[i], sampleCounts[i]);
+            }
+        }
+        for(size_t f = 0; f < frontier.size(); f++)
+        {
+            uint32_t left = firstChildren[f];
+            if((left != NO_NODE) && (isAccumulated[left] || isAccumulated[left + 1]))
+            {
+                uint32_t smaller = isAccumulated[left] ? left : (left + 1);
+                uint32_t larger = isAccumulated[left] ? (left + 1) : left;
+                nextHistograms[larger] = acquireHistogram();
+                nextHistograms[larger].setDifference(histograms[f], nextHistograms[smaller]);
+            }
+            releaseHistogram(histograms[f]);
+        }
+        histograms.swap(nextHistograms);
+        frontier.swap(nextFrontier);
     }
-    buildDecisionTree(X, y, leftIndices, left);
-    buildDecisionTree(X, y, rightIndices, right);
+}
+
+void DecisionTreeRegressionSolver::beginSolve(size_t numRows, size_t numDatasetRows)
+{
+    assert(numRows > 0);
+    m_nodeCount = 0;
+    m_trainingPredictions.assign(numDatasetRows, 0);
+    // Rough node count of a tree whose leaves hold about maxLeafSize rows.
+    m_tree.reset(2 * (numRows / (m_maxLeafSize + 1)) + 1);
 }
 
 void DecisionTreeRegressionSolver::solve(const Matrix& X, const Vector& y)
+{
+    DenseMatrix denseX(X);
+    solve(denseX.getView(), y);
+}
+
+void DecisionTreeRegressionSolver::solve(const MatrixView& X, const Vector& y)
 {
     assert(y.size() > 0);
     assert(y.size() == X.getNumRows());
@@ -175,21 +981,134 @@ void DecisionTreeRegressionSolver::solve(const Matrix& X, const Vector& y)
     {
         indices.push_back(i);
     }
-    m_tree = new DecisionTree();
-    buildDecisionTree(X, y, indices, m_tree);
+    if(m_useHistograms)
+    {
+        solve(BinnedMatrix(X, m_maxNumBins), y, indices);
+        return;
+    }
+    if(m_levelWise)
+    {
+        std::vector<std::vector<size_t> > columnSortedIndices = {};
+        for(size_t j = 0; j < X.getNumColumns(); j++)
+        {
+            columnSortedIndices.push_back(getColumnSortedIndices(X, j, indices));
+        }
+        solve(X, y, indices, columnSortedIndices);
+        return;
+    }
+    // Each column is sorted only once. The sorted order of a node's rows
+    // is then carried down the tree by stable partitioning.
+    allocateIndexBuffers(X.getNumColumns(), y.size(), y.size());
+    for(size_t j = 0; j < X.getNumColumns(); j++)
+    {
+        std::vector<size_t> sortedIndices = getColumnSortedIndices(X, j, indices);
+        std::copy(sortedIndices.begin(), sortedIndices.end(), getIndices(0, j, 0));
+    }
+    beginSolve(y.size(), y.size());
+    buildDecisionTree(X, y, 0, y.size(), m_tree, 0, 0, m_seed);
+    releaseIndexBuffers();
+}
+
+void DecisionTreeRegressionSolver::solve(const Matrix& X, const Vector& y, const std::vector<size_t>& rows, const std::vector<std::vector<size_t> >& columnSortedIndices)
+{
+    DenseMatrix denseX(X);
+    solve(denseX.getView(), y, rows, columnSortedIndices);
+}
+
+void DecisionTreeRegressionSolver::solve(const MatrixView& X, const Vector& y, const std::vector<size_t>& rows, const std::vector<std::vector<size_t> >& columnSortedIndices)
+{
+    assert(y.size() == X.getNumRows());
+    // The sorted lists of the sample are obtained from the sorted lists
+    // of the whole dataset, repeating every row as often as it is sampled.
+    std::vector<size_t> sampleCounts(y.size(), 0);
+    for(const auto& i: rows)
+    {
+        sampleCounts[i]++;
+    }
+    beginSolve(rows.size(), y.size());
+    if(m_levelWise)
+    {
+        buildLevelWiseDecisionTree(X, y, sampleCounts, columnSortedIndices);
+        releaseIndexBuffers();
+        return;
+    }
+    allocateIndexBuffers(X.getNumColumns(), rows.size(), y.size());
+    for(size_t j = 0; j < X.getNumColumns(); j++)
+    {
+        assert(columnSortedIndices[j].size() == y.size());
+        size_t* sampleSortedIndices = getIndices(0, j, 0);
+        for(const auto& i: columnSortedIndices[j])
+        {
+            sampleSortedIndices = std::fill_n(sampleSortedIndices, sampleCounts[i], i);
+        }
+    }
+    buildDecisionTree(X, y, 0, rows.size(), m_tree, 0, 0, m_seed);
+    releaseIndexBuffers();
+}
+
+void DecisionTreeRegressionSolver::solve(const BinnedMatrix& Xb, const Vector& y, const std::vector<size_t>& rows)
+{
+    assert(y.size() == Xb.getNumRows());
+    beginSolve(rows.size(), y.size());
+    if(m_levelWise)
+    {
+        std::vector<size_t> sampleCounts(y.size(), 0);
+        for(const auto& i: rows)
+        {
+            sampleCounts[i]++;
+        }
+        buildLevelWiseHistogramDecisionTree(Xb, y, sampleCounts);
+        releaseIndexBuffers();
+        return;
+    }
+    allocateIndexBuffers(1, rows.size(), y.size());
+    std::copy(rows.begin(), rows.end(), getIndices(0, 0, 0));
+    FeatureHistogram histogram;
+    bool isHistogramUsed = (rows.size() >= m_histogramMinRows);
+    if(isHistogramUsed)
+    {
+        histogram.build(Xb, y, rows.data(), rows.size());
+    }
+    buildHistogramDecisionTree(Xb, y, 0, rows.size(), isHistogramUsed ? &histogram : nullptr, m_tree, 0, 0, m_seed);
+    releaseIndexBuffers();
 }
 
 Vector DecisionTreeRegressionSolver::predict(const Matrix& X) const
 {
-    std::vector<double> r = {};
+    std::vector<const double*> rows(X.getNumRows());
     for(size_t i = 0; i < X.getNumRows(); i++)
     {
-        r.push_back(predict(Vector(X.getData()[i])));
+        rows[i] = X.getData()[i].data();
     }
+    std::vector<double> r(X.getNumRows());
+    m_tree.getValues(rows.data(), rows.size(), r.data());
     return Vector(r);
 }
 
 double DecisionTreeRegressionSolver::predict(const Vector& xrow) const
 {
-    return m_tree->getValue(xrow);
+    return m_tree.getValue(xrow);
+}
+
+template<typename T>
+Vector DecisionTreeRegressionSolver::predictView(const BasicMatrixView<T>& X) const
+{
+    std::vector<const T*> rows(X.getNumRows());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        rows[i] = X.getRow(i);
+    }
+    std::vector<double> r(X.getNumRows());
+    m_tree.getValues(rows.data(), rows.size(), r.data());
+    return Vector(r);
+}
+
+Vector DecisionTreeRegressionSolver::predict(const MatrixView& X) const
+{
+    return predictView(X);
+}
+
+Vector DecisionTreeRegressionSolver::predict(const FloatMatrixView& X) const
+{
+    return predictView(X);
 }
\ No newline at end of file
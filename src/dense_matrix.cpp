@@ -0,0 +1,105 @@
+#include "dense_matrix.hpp"
+#include <algorithm>
+#include <cassert>
+
+template<typename T>
+BasicMatrixView<T>::BasicMatrixView()
+{
+    m_data = nullptr;
+    m_numRows = 0;
+    m_numColumns = 0;
+    m_stride = 0;
+}
+
+template<typename T>
+BasicMatrixView<T>::BasicMatrixView(const T* data, size_t numRows, size_t numColumns, size_t stride)
+{
+    assert(stride >= numColumns);
+    m_data = data;
+    m_numRows = numRows;
+    m_numColumns = numColumns;
+    m_stride = stride;
+}
+
+template<typename T>
+BasicMatrixView<T> BasicMatrixView<T>::getRows(size_t beginRow, size_t endRow) const
+{
+    assert(beginRow <= endRow && endRow <= m_numRows);
+    return BasicMatrixView<T>(getRow(beginRow), endRow - beginRow, m_numColumns, m_stride);
+}
+
+template<typename T>
+BasicDenseMatrix<T>::BasicDenseMatrix()
+{
+    m_numRows = 0;
+    m_numColumns = 0;
+}
+
+template<typename T>
+BasicDenseMatrix<T>::BasicDenseMatrix(size_t numRows, size_t numColumns)
+{
+    m_numRows = numRows;
+    m_numColumns = numColumns;
+    m_data.assign(numRows * numColumns, 0);
+}
+
+template<typename T>
+BasicDenseMatrix<T>::BasicDenseMatrix(const Matrix& X)
+{
+    m_numRows = X.getNumRows();
+    m_numColumns = X.getNumColumns();
+    m_data.resize(m_numRows * m_numColumns);
+    const std::vector<std::vector<double> >& data = X.getData();
+    for(size_t i = 0; i < m_numRows; i++)
+    {
+        assert(data[i].size() == m_numColumns);
+        std::copy(data[i].begin(), data[i].end(), getRow(i));
+    }
+}
+
+template<typename T>
+BasicDenseMatrix<T>::BasicDenseMatrix(const MatrixView& X)
+{
+    m_numRows = X.getNumRows();
+    m_numColumns = X.getNumColumns();
+    m_data.resize(m_numRows * m_numColumns);
+    for(size_t i = 0; i < m_numRows; i++)
+    {
+        std::copy(X.getRow(i), X.getRow(i) + m_numColumns, getRow(i));
+    }
+}
+
+template<typename T>
+size_t BasicDenseMatrix<T>::getNumRows() const
+{
+    return m_numRows;
+}
+
+template<typename T>
+size_t BasicDenseMatrix<T>::getNumColumns() const
+{
+    return m_numColumns;
+}
+
+template<typename T>
+T* BasicDenseMatrix<T>::getRow(size_t row)
+{
+    return m_data.data() + row * m_numColumns;
+}
+
+template<typename T>
+const T* BasicDenseMatrix<T>::getRow(size_t row) const
+{
+    return m_data.data() + row * m_numColumns;
+}
+
+template<typename T>
+BasicMatrixView<T> BasicDenseMatrix<T>::getView() const
+{
+    return BasicMatrixView<T>(m_data.data(), m_numRows, m_numColumns, m_numColumns);
+}
+
+template class BasicMatrixView<double>;
+template class BasicMatrixView<float>;
+template class BasicDenseMatrix<double>;
+template class BasicDenseMatrix<float>;
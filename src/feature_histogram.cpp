@@ -0,0 +1,51 @@
+#include "feature_histogram.hpp"
+#include <cassert>
+
+FeatureHistogram::FeatureHistogram()
+{
+    m_bins = {};
+}
+
+void FeatureHistogram::build(const BinnedMatrix& Xb, const Vector& y, const size_t* rows, size_t numRows)
+{
+    clear(Xb);
+    const std::vector<double>& yv = y.getData();
+    for(size_t k = 0; k < numRows; k++)
+    {
+        addRow(Xb, rows[k], yv[rows[k]]);
+    }
+}
+
+void FeatureHistogram::clear(const BinnedMatrix& Xb)
+{
+    HistogramBin emptyBin = {0, 0};
+    m_bins.assign(Xb.getTotalNumBins(), emptyBin);
+}
+
+void FeatureHistogram::addRow(const BinnedMatrix& Xb, size_t row, double yi, size_t weight)
+{
+    const uint8_t* rowBins = Xb.getRow(row);
+    double weightedYi = weight * yi;
+    for(size_t j = 0; j < Xb.getNumColumns(); j++)
+    {
+        HistogramBin& bin = m_bins[Xb.getBinOffset(j) + rowBins[j]];
+        bin.sum += weightedYi;
+        bin.count += weight;
+    }
+}
+
+void FeatureHistogram::setDifference(const FeatureHistogram& parent, const FeatureHistogram& sibling)
+{
+    assert(parent.m_bins.size() == sibling.m_bins.size());
+    m_bins.resize(parent.m_bins.size());
+    for(size_t k = 0; k < m_bins.size(); k++)
+    {
+        m_bins[k].sum = parent.m_bins[k].sum - sibling.m_bins[k].sum;
+        m_bins[k].count = parent.m_bins[k].count - sibling.m_bins[k].count;
+    }
+}
+
+const HistogramBin* FeatureHistogram::getColumnBins(const BinnedMatrix& Xb, size_t column) const
+{
+    return m_bins.data() + Xb.getBinOffset(column);
+}
@@ -0,0 +1,268 @@
+#include "gradient_boosted_trees_solver.hpp"
+#include "decision_tree_regression_solver.hpp"
+#include "binned_matrix.hpp"
+#include "dense_matrix.hpp"
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+GradientBoostedTreesSolver::GradientBoostedTreesSolver(size_t maxNumRounds, double learningRate, size_t maxDepth, double subsampleRatio, size_t earlyStoppingRounds)
+{
+    assert((subsampleRatio > 0) && (subsampleRatio <= 1));
+    m_maxNumRounds = maxNumRounds;
+    m_learningRate = learningRate;
+    m_maxDepth = maxDepth;
+    m_subsampleRatio = subsampleRatio;
+    m_earlyStoppingRounds = earlyStoppingRounds;
+    m_maxLeafSize = 1;
+    m_minGain = 0;
+    m_validationFraction = 0;
+    m_numThreads = 1;
+    m_seed = 0;
+    m_initialValue = 0;
+}
+
+void GradientBoostedTreesSolver::setMaxLeafSize(size_t maxLeafSize)
+{
+    m_maxLeafSize = maxLeafSize;
+}
+
+void GradientBoostedTreesSolver::setMinGain(double minGain)
+{
+    m_minGain = minGain;
+}
+
+void GradientBoostedTreesSolver::setValidationFraction(double validationFraction)
+{
+    assert((validationFraction >= 0) && (validationFraction < 1));
+    m_validationFraction = validationFraction;
+}
+
+void GradientBoostedTreesSolver::setNumThreads(size_t numThreads)
+{
+    m_numThreads = numThreads;
+}
+
+void GradientBoostedTreesSolver::setSeed(uint64_t seed)
+{
+    m_seed = seed;
+}
+
+size_t GradientBoostedTreesSolver::getNumTrees() const
+{
+    return m_trees.size();
+}
+
+const std::vector<double>& GradientBoostedTreesSolver::getValidationErrors() const
+{
+    return m_validationErrors;
+}
+
+void GradientBoostedTreesSolver::solve(const Matrix& X, const Vector& y)
+{
+    assert(y.size() > 0);
+    assert(y.size() == X.getNumRows());
+    std::vector<size_t> rows(y.size());
+    for(size_t i = 0; i < y.size(); i++)
+    {
+        rows[i] = i;
+    }
+    size_t numValidRows = size_t(m_validationFraction * y.size());
+    if(numValidRows == 0)
+    {
+        solve(X, y, rows, 0, 0, {});
+        return;
+    }
+    std::mt19937_64 generator(m_seed);
+    std::shuffle(rows.begin(), rows.end(), generator);
+    std::vector<size_t> validRows(rows.begin(), rows.begin() + numValidRows);
+    std::vector<size_t> trainRows(rows.begin() + numValidRows, rows.end());
+    std::sort(validRows.begin(), validRows.end());
+    std::sort(trainRows.begin(), trainRows.end());
+    solve(X, y, trainRows, &X, &y, validRows);
+}
+
+void GradientBoostedTreesSolver::solve(const Matrix& X, const Vector& y, const Matrix& XValid, const Vector& yValid)
+{
+    assert(y.size() == X.getNumRows());
+    assert(yValid.size() == XValid.getNumRows());
+    std::vector<size_t> trainRows(y.size());
+    for(size_t i = 0; i < y.size(); i++)
+    {
+        trainRows[i] = i;
+    }
+    std::vector<size_t> validRows(yValid.size());
+    for(size_t i = 0; i < yValid.size(); i++)
+    {
+        validRows[i] = i;
+    }
+    solve(X, y, trainRows, &XValid, &yValid, validRows);
+}
+
+void GradientBoostedTreesSolver::solve(const Matrix& X, const Vector& y, const std::vector<size_t>& trainRows, const Matrix* pXValid, const Vector* pyValid, const std::vector<size_t>& validRows)
+{
+    assert(!trainRows.empty());
+    size_t numRows = X.getNumRows();
+    const std::vector<double>& yv = y.getData();
+    m_trees.clear();
+    m_validationErrors.clear();
+
+    m_initialValue = 0;
+    for(const auto& i: trainRows)
+    {
+        m_initialValue += yv[i];
+    }
+    m_initialValue /= trainRows.size();
+    // Running predictions; only the entries of the training rows are used.
+    std::vector<double> predictions(numRows, m_initialValue);
+    std::vector<double> validPredictions(validRows.size(), m_initialValue);
+    m_residuals = Vector(std::vector<double>(numRows, 0));
+    std::vector<char> isInSample(numRows, 0);
+
+    DenseMatrix denseX(X);
+    BinnedMatrix Xb(denseX.getView());
+    DecisionTreeRegressionSolver treeSolver(m_maxLeafSize);
+    treeSolver.setHistogramMode(true);
+    treeSolver.setMaxDepth(m_maxDepth);
+    treeSolver.setMinGain(m_minGain);
+    treeSolver.setNumThreads(m_numThreads);
+
+    std::mt19937_64 generator(m_seed);
+    size_t sampleSize = std::max(size_t(1), size_t(m_subsampleRatio * trainRows.size()));
+    std::vector<size_t> sampleRows = trainRows;
+    double minValidError = 0;
+    size_t bestNumTrees = 0;
+    for(size_t round = 0; round < m_maxNumRounds; round++)
+    {
+        for(const auto& i: trainRows)
+        {
+            m_residuals[i] = yv[i] - predictions[i];
+        }
+        if(sampleSize < trainRows.size())
+        {
+            // Partial Fisher-Yates shuffle; the first sampleSize rows form
+            // the sample. Sorting them keeps the sweeps over X sequential.
+            sampleRows = trainRows;
+            for(size_t k = 0; k < sampleSize; k++)
+            {
+                std::uniform_int_distribution<size_t> distribution(k, sampleRows.size() - 1);
+                std::swap(sampleRows[k], sampleRows[distribution(generator)]);
+            }
+            sampleRows.resize(sampleSize);
+            std::sort(sampleRows.begin(), sampleRows.end());
+        }
+        treeSolver.solve(Xb, m_residuals, sampleRows);
+        const DecisionTree& tree = treeSolver.getTree();
+        m_trees.push_back(tree);
+
+        // Incremental update of the running predictions.
+        const std::vector<double>& treePredictions = treeSolver.getTrainingPredictions();
+        for(const auto& i: sampleRows)
+        {
+            isInSample[i] = 1;
+            predictions[i] += m_learningRate * treePredictions[i];
+        }
+        for(const auto& i: trainRows)
+        {
+            if(!isInSample[i])
+            {
+                predictions[i] += m_learningRate * tree.getValue(denseX.getRow(i));
+            }
+            isInSample[i] = 0;
+        }
+
+        if(validRows.empty())
+        {
+            continue;
+        }
+        double validError = 0;
+        for(size_t k = 0; k < validRows.size(); k++)
+        {
+            const double* xrow = pXValid->getData()[validRows[k]].data();
+            validPredictions[k] += m_learningRate * tree.getValue(xrow);
+            double diff = (*pyValid)[validRows[k]] - validPredictions[k];
+            validError += diff * diff;
+        }
+        validError /= validRows.size();
+        m_validationErrors.push_back(validError);
+        if((bestNumTrees == 0) || (validError < minValidError))
+        {
+            minValidError = validError;
+            bestNumTrees = m_trees.size();
+        }
+        else if(m_trees.size() - bestNumTrees >= m_earlyStoppingRounds)
+        {
+            break;
+        }
+    }
+    if(bestNumTrees > 0)
+    {
+        m_trees.resize(bestNumTrees);
+    }
+}
+
+template<typename T>
+Vector GradientBoostedTreesSolver::predictRows(const T* const* rows, size_t numRows) const
+{
+    std::vector<double> r(numRows, 0);
+    double treeValues[PREDICTION_BLOCK_SIZE];
+    // Blocks of rows are run through all the trees, as in random forests.
+    for(size_t iBegin = 0; iBegin < numRows; iBegin += PREDICTION_BLOCK_SIZE)
+    {
+        size_t blockSize = std::min(numRows, iBegin + PREDICTION_BLOCK_SIZE) - iBegin;
+        for(const auto& tree: m_trees)
+        {
+            tree.getValues(rows + iBegin, blockSize, treeValues);
+            for(size_t k = 0; k < blockSize; k++)
+            {
+                r[iBegin + k] += treeValues[k];
+            }
+        }
+        for(size_t k = 0; k < blockSize; k++)
+        {
+            r[iBegin + k] = m_initialValue + m_learningRate * r[iBegin + k];
+        }
+    }
+    return Vector(r);
+}
+
+Vector GradientBoostedTreesSolver::predict(const Matrix& X) const
+{
+    std::vector<const double*> rows(X.getNumRows());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        rows[i] = X.getData()[i].data();
+    }
+    return predictRows(rows.data(), rows.size());
+}
+
+Vector GradientBoostedTreesSolver::predict(const MatrixView& X) const
+{
+    std::vector<const double*> rows(X.getNumRows());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        rows[i] = X.getRow(i);
+    }
+    return predictRows(rows.data(), rows.size());
+}
+
+Vector GradientBoostedTreesSolver::predict(const FloatMatrixView& X) const
+{
+    std::vector<const float*> rows(X.getNumRows());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        rows[i] = X.getRow(i);
+    }
+    return predictRows(rows.data(), rows.size());
+}
+
+double GradientBoostedTreesSolver::predict(const Vector& xrow) const
+{
+    const double* x = xrow.getData().data();
+    double sum = 0;
+    for(const auto& tree: m_trees)
+    {
+        sum += tree.getValue(x);
+    }
+    return m_initialValue + m_learningRate * sum;
+}
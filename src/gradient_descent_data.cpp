@@ -1,20 +1,430 @@
 #include "gradient_descent_data.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
 
-GradientDescentData::GradientDescentData(size_t numStochasticSamples, double learningRate)
+// Below this weight scale, the scale is applied to the weights, which keeps
+// their stored values away from overflow.
+static const double MIN_WEIGHT_SCALE = 1e-9;
+
+GradientDescentData::GradientDescentData(size_t numStochasticSamples, double learningRate, size_t numThreads)
 {
     m_numStochasticSamples = numStochasticSamples;
     m_learningRate = learningRate;
+    m_threadPool = std::make_shared<ThreadPool>(numThreads);
+    m_isSeedSet = false;
+    m_seed = 0;
+    m_batchSeed = 0;
+    m_isSinglePrecision = false;
+    m_isFloatData = false;
+    m_numDataRows = 0;
+    m_pCsrX = nullptr;
+    m_isSparseData = false;
+    m_py = nullptr;
+    m_l2Penalty = 0;
+    m_optimizerIterationBase = 0;
+    m_isOptimizerIterationBaseSet = false;
+    m_weightScale = 1;
+}
+
+void GradientDescentData::setNumThreads(size_t numThreads)
+{
+    m_threadPool = std::make_shared<ThreadPool>(numThreads);
+}
+
+void GradientDescentData::setSeed(uint64_t seed)
+{
+    m_isSeedSet = true;
+    m_seed = seed;
+    m_streamGenerator = RandomGenerator(seed);
+}
+
+void GradientDescentData::setSinglePrecision(bool isSinglePrecision)
+{
+    m_isSinglePrecision = isSinglePrecision;
+}
+
+void GradientDescentData::setL2Penalty(double l2Penalty)
+{
+    m_l2Penalty = l2Penalty;
+}
+
+void GradientDescentData::setOptimizer(const std::shared_ptr<GradientOptimizer>& optimizer)
+{
+    m_optimizer = optimizer;
+    // (The state of the new optimizer is sized by its first reset.)
+    m_parameterGradient.clear();
+    m_parameterIncrements.clear();
+}
+
+void GradientDescentData::setLearningRateSchedule(const std::shared_ptr<LearningRateSchedule>& schedule)
+{
+    m_schedule = schedule;
 }
 
 void GradientDescentData::setData(const Matrix& X, const Vector& y)
+{
+    if(m_isSinglePrecision)
+    {
+        m_floatDenseX = FloatDenseMatrix(X);
+        setData(m_floatDenseX.getView(), y);
+        return;
+    }
+    m_denseX = DenseMatrix(X);
+    setData(m_denseX.getView(), y);
+}
+
+void GradientDescentData::setData(const MatrixView& X, const Vector& y)
+{
+    if(m_isSinglePrecision)
+    {
+        m_floatDenseX = FloatDenseMatrix(X);
+        setData(m_floatDenseX.getView(), y);
+        return;
+    }
+    assert(m_numStochasticSamples < X.getNumRows());
+    uint64_t seed = m_isSeedSet ? m_seed : uint64_t(rand());
+    setRows(X, y, m_numStochasticSamples, seed);
+    resetOptimizer();
+}
+
+void GradientDescentData::setData(const FloatMatrixView& X, const Vector& y)
 {
     assert(m_numStochasticSamples < X.getNumRows());
-    bool isStochasticGD = (m_numStochasticSamples > 0);
-    m_pX = &X;
+    uint64_t seed = m_isSeedSet ? m_seed : uint64_t(rand());
+    setRows(X, y, m_numStochasticSamples, seed);
+    resetOptimizer();
+}
+
+void GradientDescentData::setData(const CsrMatrix& X, const Vector& y)
+{
+    assert(m_numStochasticSamples < X.getNumRows());
+    uint64_t seed = m_isSeedSet ? m_seed : uint64_t(rand());
+    m_X = MatrixView();
+    m_floatX = FloatMatrixView();
+    m_isFloatData = false;
+    m_pCsrX = &X;
+    m_isSparseData = true;
+    setSampling(X.getNumRows(), X.getNumColumns(), y, m_numStochasticSamples, seed);
+    // The gradient over all the columns, when needed, is evaluated in a
+    // single pass, without the partial gradients of chunks.
+    m_chunkGradients.clear();
+    m_chunkErrSums.assign(1, 0);
+    m_batchErrors.assign(m_numRows, 0);
+    m_sparseIncrements.assign(m_numColumns, 0);
+    // (Reserved once, so that the sparse steps do not allocate.)
+    m_touchedColumns.clear();
+    m_touchedColumns.reserve(m_numColumns);
+    resetOptimizer();
+}
+
+void GradientDescentData::clearDataReferences()
+{
+    m_py = nullptr;
+    m_X = MatrixView();
+    m_floatX = FloatMatrixView();
+    m_pCsrX = nullptr;
+}
+
+void GradientDescentData::resetOptimizer()
+{
+    if(m_optimizer)
+    {
+        m_optimizer->reset(m_numColumns + 1);
+        m_parameterGradient.assign(m_numColumns + 1, 0);
+        m_parameterIncrements.assign(m_numColumns + 1, 0);
+    }
+    // (A partial fit may reset the optimizer in the middle of training.)
+    m_isOptimizerIterationBaseSet = false;
+}
+
+void GradientDescentData::setRows(const MatrixView& X, const Vector& y, size_t batchSize, uint64_t seed)
+{
+    m_X = X;
+    m_floatX = FloatMatrixView();
+    m_isFloatData = false;
+    m_pCsrX = nullptr;
+    m_isSparseData = false;
+    setSampling(X.getNumRows(), X.getNumColumns(), y, batchSize, seed);
+}
+
+void GradientDescentData::setRows(const FloatMatrixView& X, const Vector& y, size_t batchSize, uint64_t seed)
+{
+    m_X = MatrixView();
+    m_floatX = X;
+    m_isFloatData = true;
+    m_pCsrX = nullptr;
+    m_isSparseData = false;
+    m_floatWeights.assign(X.getNumColumns(), 0);
+    setSampling(X.getNumRows(), X.getNumColumns(), y, batchSize, seed);
+}
+
+void GradientDescentData::setSampling(size_t numRows, size_t numColumns, const Vector& y, size_t batchSize, uint64_t seed)
+{
     m_py = &y;
-    m_numRows = isStochasticGD ? m_numStochasticSamples : X.getNumRows();
-    m_numColumns = X.getNumColumns();
-    m_indexer = IndexShuffler(X.getNumRows(), isStochasticGD);
+    m_numDataRows = numRows;
+    m_numRows = (batchSize > 0) ? batchSize : numRows;
+    m_numColumns = numColumns;
+    m_indexer = IndexShuffler(numRows, batchSize, seed);
+    m_batchSeed = seed;
+    m_weightScale = 1;
     m_constMult = -m_learningRate / (1.0 * m_numRows);
-}
\ No newline at end of file
+    size_t numChunks = (m_numRows + GRADIENT_CHUNK_SIZE - 1) / GRADIENT_CHUNK_SIZE;
+    m_gradient.assign(m_numColumns, 0);
+    m_chunkGradients.assign(numChunks * m_numColumns, 0);
+    m_chunkErrSums.assign(numChunks, 0);
+}
+
+void GradientDescentData::beginStream(size_t numColumns)
+{
+    m_numColumns = numColumns;
+    m_streamGenerator = RandomGenerator(m_isSeedSet ? m_seed : uint64_t(rand()));
+    resetOptimizer();
+}
+
+size_t GradientDescentData::setChunkData(const MatrixView& X, const Vector& y)
+{
+    // A chunk smaller than a mini-batch is used whole.
+    size_t batchSize = (m_numStochasticSamples < X.getNumRows()) ? m_numStochasticSamples : 0;
+    setRows(X, y, batchSize, m_streamGenerator.next());
+    return X.getNumRows() / m_numRows;
+}
+
+size_t GradientDescentData::setPartialData(const Matrix& X, const Vector& y)
+{
+    m_denseX = DenseMatrix(X);
+    return setPartialData(m_denseX.getView(), y);
+}
+
+size_t GradientDescentData::setPartialData(const MatrixView& X, const Vector& y)
+{
+    assert(X.getNumRows() > 0);
+    uint64_t seed = m_isSeedSet ? m_streamGenerator.next() : uint64_t(rand());
+    // Fewer rows than a mini-batch are used whole.
+    size_t batchSize = (m_numStochasticSamples < X.getNumRows()) ? m_numStochasticSamples : 0;
+    setRows(X, y, batchSize, seed);
+    // The optimizer state carries over, unless it is for other parameters.
+    if(m_optimizer && m_parameterGradient.size() != m_numColumns + 1)
+    {
+        resetOptimizer();
+    }
+    return X.getNumRows() / m_numRows;
+}
+
+double GradientDescentData::evaluateGradient(const double* weights, double bias, GradientLoss loss)
+{
+    double errSum;
+    if(m_isSparseData)
+    {
+        errSum = computeGradient(*m_pCsrX, m_py->getData().data(), m_indexer.getIndices(), m_numRows, weights, bias, loss, m_gradient.data());
+    }
+    else if(m_isFloatData)
+    {
+        std::copy(weights, weights + m_numColumns, m_floatWeights.begin());
+        errSum = evaluateGradient(m_floatX, m_floatWeights.data(), bias, loss);
+    }
+    else
+    {
+        errSum = evaluateGradient(m_X, weights, bias, loss);
+    }
+    if(m_l2Penalty > 0)
+    {
+        // m_gradient is the gradient of the cost times numRows.
+        for(size_t j = 0; j < m_numColumns; j++)
+        {
+            m_gradient[j] += m_l2Penalty * m_numRows * weights[j];
+        }
+    }
+    return errSum;
+}
+
+template<typename T>
+double GradientDescentData::evaluateGradient(const BasicMatrixView<T>& X, const T* weights, double bias, GradientLoss loss)
+{
+    const double* y = m_py->getData().data();
+    const size_t* rows = m_indexer.getIndices();
+    auto evaluateChunk = [&](size_t, size_t begin, size_t numChunkRows, double* gradient)
+    {
+        return computeGradient(X, y, rows + begin, numChunkRows, weights, bias, loss, gradient);
+    };
+    return reduceChunks(m_chunkErrSums.size(), m_numColumns, evaluateChunk, m_chunkGradients.data(), m_chunkErrSums.data(), m_gradient.data());
+}
+
+double GradientDescentData::computeIncrements(double errSum, size_t iteration, double* weightIncrements)
+{
+    double learningRate = m_schedule ? m_schedule->getLearningRate(m_learningRate, iteration) : m_learningRate;
+    if(!m_optimizer)
+    {
+        double constMult = m_schedule ? (-learningRate / (1.0 * m_numRows)) : m_constMult;
+        for(size_t j = 0; j < m_numColumns; j++)
+        {
+            weightIncrements[j] = m_gradient[j] * constMult;
+        }
+        return errSum * constMult;
+    }
+    for(size_t j = 0; j < m_numColumns; j++)
+    {
+        m_parameterGradient[j] = m_gradient[j] / m_numRows;
+    }
+    m_parameterGradient[m_numColumns] = errSum / m_numRows;
+    if(!m_isOptimizerIterationBaseSet)
+    {
+        m_optimizerIterationBase = iteration;
+        m_isOptimizerIterationBaseSet = true;
+    }
+    m_optimizer->computeIncrements(m_parameterGradient.data(), learningRate, iteration - m_optimizerIterationBase, m_parameterIncrements.data());
+    std::copy(m_parameterIncrements.begin(), m_parameterIncrements.begin() + m_numColumns, weightIncrements);
+    return m_parameterIncrements[m_numColumns];
+}
+
+double GradientDescentData::evaluateLoss(const double* weights, double bias, GradientLoss loss) const
+{
+    const double* y = m_py->getData().data();
+    double cost;
+    if(m_isSparseData)
+    {
+        cost = computeLoss(*m_pCsrX, y, weights, bias, loss);
+    }
+    else if(m_isFloatData)
+    {
+        cost = computeLoss(m_floatX, y, weights, bias, loss);
+    }
+    else
+    {
+        cost = computeLoss(m_X, y, weights, bias, loss);
+    }
+    if(m_l2Penalty > 0)
+    {
+        double squaredNorm = 0;
+        for(size_t j = 0; j < m_numColumns; j++)
+        {
+            squaredNorm += weights[j] * weights[j];
+        }
+        cost += 0.5 * m_l2Penalty * squaredNorm;
+    }
+    return cost;
+}
+
+double GradientDescentData::evaluateLossAndGradient(const double* parameters, GradientLoss loss, double* gradient)
+{
+    double bias = parameters[m_numColumns];
+    double errSum = evaluateGradient(parameters, bias, loss);
+    for(size_t j = 0; j < m_numColumns; j++)
+    {
+        gradient[j] = m_gradient[j] / m_numRows;
+    }
+    gradient[m_numColumns] = errSum / m_numRows;
+    return evaluateLoss(parameters, bias, loss);
+}
+
+void GradientDescentData::runHogwildWorker(HogwildParameters& parameters, size_t worker, GradientLoss loss) const
+{
+    // Stream 0 would repeat the sampling of synchronous training.
+    RandomGenerator generator = RandomGenerator(m_batchSeed).getStream(worker + 1);
+    IndexShuffler indexer(m_numDataRows, m_numStochasticSamples, generator.next());
+    size_t numRows = indexer.getBatchSize();
+    const double* y = m_py->getData().data();
+    // Sized once, so that updates do not allocate memory.
+    std::vector<double> point(m_numColumns + 1);
+    std::vector<float> floatPoint(m_isFloatData ? m_numColumns : 0);
+    std::vector<double> gradient(m_numColumns);
+    std::vector<double> increments(m_numColumns + 1);
+    size_t update;
+    while(parameters.claimUpdate(update))
+    {
+        indexer.update();
+        parameters.read(point.data());
+        double errSum;
+        if(m_isFloatData)
+        {
+            std::copy(point.begin(), point.begin() + m_numColumns, floatPoint.begin());
+            errSum = computeGradient(m_floatX, y, indexer.getIndices(), numRows, floatPoint.data(), point[m_numColumns], loss, gradient.data());
+        }
+        else
+        {
+            errSum = computeGradient(m_X, y, indexer.getIndices(), numRows, point.data(), point[m_numColumns], loss, gradient.data());
+        }
+        double learningRate = m_schedule ? m_schedule->getLearningRate(m_learningRate, update) : m_learningRate;
+        double constMult = -learningRate / (1.0 * numRows);
+        for(size_t j = 0; j < m_numColumns; j++)
+        {
+            increments[j] = gradient[j] * constMult;
+        }
+        increments[m_numColumns] = errSum * constMult;
+        if(m_l2Penalty > 0)
+        {
+            for(size_t j = 0; j < m_numColumns; j++)
+            {
+                increments[j] -= learningRate * m_l2Penalty * point[j];
+            }
+        }
+        parameters.add(increments.data(), worker);
+    }
+}
+
+double GradientDescentData::stepSparse(double* weights, double& bias, size_t iteration, GradientLoss loss)
+{
+    m_indexer.update();
+    const size_t* rows = m_indexer.getIndices();
+    const CsrMatrix& X = *m_pCsrX;
+    double learningRate = m_schedule ? m_schedule->getLearningRate(m_learningRate, iteration) : m_learningRate;
+    // The errors at the current parameters, before any of them changes.
+    double errSum = computeErrors(X, m_py->getData().data(), rows, m_numRows, weights, m_weightScale, bias, loss, m_batchErrors.data());
+    // L2 decay: weights <- (1 - learningRate * l2Penalty) * weights.
+    if(m_l2Penalty > 0)
+    {
+        assert(learningRate * m_l2Penalty < 1);
+        m_weightScale *= 1 - learningRate * m_l2Penalty;
+        if(m_weightScale < MIN_WEIGHT_SCALE)
+        {
+            applyWeightScale(weights);
+        }
+    }
+    // The increments of the columns of the batch are gathered first, so that
+    // the maximum is taken over their totals.
+    double constMult = -learningRate / (1.0 * m_numRows);
+    for(size_t r = 0; r < m_numRows; r++)
+    {
+        const uint32_t* columns = X.getRowColumns(rows[r]);
+        const double* values = X.getRowValues(rows[r]);
+        double errMult = constMult * m_batchErrors[r];
+        for(size_t k = 0; k < X.getRowSize(rows[r]); k++)
+        {
+            // (A column whose total comes back to 0 may be listed twice,
+            // which is harmless: its second increment is 0.)
+            if(m_sparseIncrements[columns[k]] == 0)
+            {
+                m_touchedColumns.push_back(columns[k]);
+            }
+            m_sparseIncrements[columns[k]] += errMult * values[k];
+        }
+    }
+    double biasIncrement = constMult * errSum;
+    bias += biasIncrement;
+    double maxIncrement = fabs(biasIncrement);
+    for(uint32_t column: m_touchedColumns)
+    {
+        double increment = m_sparseIncrements[column];
+        m_sparseIncrements[column] = 0;
+        weights[column] += increment / m_weightScale;
+        if(!(fabs(increment) <= maxIncrement))
+        {
+            maxIncrement = fabs(increment);
+        }
+    }
+    m_touchedColumns.clear();
+    return maxIncrement;
+}
+
+void GradientDescentData::applyWeightScale(double* weights)
+{
+    if(m_weightScale != 1)
+    {
+        for(size_t j = 0; j < m_numColumns; j++)
+        {
+            weights[j] *= m_weightScale;
+        }
+        m_weightScale = 1;
+    }
+}
@@ -2,28 +2,84 @@
 #include "random_quantities.hpp"
 #include <cmath>
 #include "matrix.hpp"
+#include "gradient_kernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+const size_t GradientDescentSolver::ASYNC_MONITOR_PERIOD_MICROSECONDS;
 
 GradientDescentSolver::GradientDescentSolver(size_t numIterations, double tolerance)
 {
     m_maxIterations = numIterations;
     m_tolerance = tolerance;
+    m_isTargetLossSet = false;
+    m_targetLoss = 0;
+    m_numAsyncWorkers = 0;
+    m_isWarmStart = false;
+    m_trainingLoss = 0;
+}
+
+void GradientDescentSolver::setAsyncWorkers(size_t numWorkers)
+{
+    m_numAsyncWorkers = numWorkers;
+}
+
+void GradientDescentSolver::setWarmStart(bool isWarmStart)
+{
+    m_isWarmStart = isWarmStart;
+}
+
+void GradientDescentSolver::setTargetLoss(double targetLoss)
+{
+    m_isTargetLossSet = true;
+    m_targetLoss = targetLoss;
+}
+
+void GradientDescentSolver::clearTargetLoss()
+{
+    m_isTargetLossSet = false;
 }
 
 bool GradientDescentSolver::shouldContinueIterating()
 {
-    // Compute maximum error
-    double absMinWIncrement = fabs(m_weightIncrements.getMin());
-    double absMaxWIncrement = fabs(m_weightIncrements.getMax());
-    double wIncrement = (absMinWIncrement < absMaxWIncrement) ? absMinWIncrement : absMaxWIncrement;
-    double absBiasIncrement = fabs(m_biasIncrement);
-    m_maxIncrement = (wIncrement < absBiasIncrement) ? absBiasIncrement : wIncrement;
+    // Compute maximum error: the largest increment of the weights and bias,
+    // as in the asynchronous and sparse modes.
+    m_maxIncrement = fabs(m_biasIncrement);
+    const double* weightIncrements = &m_weightIncrements[0];
+    for(size_t j = 0; j < m_weightIncrements.size(); j++)
+    {
+        // (A NaN increment, from diverging iterations, is kept.)
+        if(!(fabs(weightIncrements[j]) <= m_maxIncrement))
+        {
+            m_maxIncrement = fabs(weightIncrements[j]);
+        }
+    }
 
     bool incrementCond = m_maxIncrement > m_tolerance;
     bool iterCond = m_iterationCount < m_maxIterations;
     // The looping to find optimal weights continues if:
-    //   a. the maximum error is still greater than the provided tolerance, and
-    //   b. the number of iterations is smaller than the provided iteration limit.
-    return incrementCond && iterCond;
+    //   a. the maximum error is still greater than the provided tolerance,
+    //   b. the number of iterations is smaller than the provided iteration limit, and
+    //   c. the training loss has not reached the target loss, if any.
+    if(!(incrementCond && iterCond))
+    {
+        return false;
+    }
+    // (A NaN loss, from diverging iterations, does not reach the target.)
+    return !m_isTargetLossSet || !(evaluateTrainingLoss() <= m_targetLoss);
+}
+
+double GradientDescentSolver::getTrainingLoss() const
+{
+    return m_trainingLoss;
+}
+
+void GradientDescentSolver::finishTraining()
+{
+    m_trainingLoss = evaluateTrainingLoss();
+    releaseTrainingData();
 }
 
 void GradientDescentSolver::log() const
@@ -32,22 +88,189 @@ void GradientDescentSolver::log() const
 }
 
 void GradientDescentSolver::solve(const Matrix& X, const Vector& y)
+{
+    iterate(X.getNumColumns());
+}
+
+bool GradientDescentSolver::hasParameters(size_t numColumns) const
+{
+    return m_weights.getData().size() == numColumns && numColumns > 0;
+}
+
+void GradientDescentSolver::initializeParameters(size_t numColumns)
 {
     // Initialize bias and weights.
-    m_bias = getRandom();
-    m_weights = getRandomVector(X.getNumColumns());
+    if(!(m_isWarmStart && hasParameters(numColumns)))
+    {
+        m_bias = getRandom();
+        m_weights = getRandomVector(numColumns);
+    }
+    m_weightIncrements = Vector(std::vector<double>(numColumns, 0));
+    m_iterationCount = 0;
+}
+
+void GradientDescentSolver::update(size_t numColumns)
+{
+    evaluateIncrements();
+    axpy(numColumns, 1, &m_weightIncrements[0], &m_weights[0]);
+    m_bias += m_biasIncrement;
+    m_iterationCount++;
+}
 
+bool GradientDescentSolver::step(size_t numColumns)
+{
+    update(numColumns);
+    bool cond = shouldContinueIterating();
+    log();
+    return cond;
+}
+
+void GradientDescentSolver::iterate(size_t numColumns)
+{
+    if(m_numAsyncWorkers > 0)
+    {
+        iterateAsync(numColumns);
+        return;
+    }
+    initializeParameters(numColumns);
     // Variables that will determine whether or not to continue iterating:
     bool cond = true;
-    m_iterationCount = 0;
+    while(cond)
+    {
+        cond = step(numColumns);
+    }
+    finishTraining();
+}
 
+void GradientDescentSolver::iterateAsync(size_t numColumns)
+{
+    initializeParameters(numColumns);
+    HogwildParameters parameters(&m_weights[0], m_bias, numColumns, m_numAsyncWorkers, m_maxIterations);
+    std::vector<std::thread> workers;
+    for(size_t w = 0; w < m_numAsyncWorkers; w++)
+    {
+        workers.emplace_back([this, &parameters, w](){ runAsyncWorker(parameters, w); });
+    }
+    std::vector<double> point(numColumns + 1);
+    bool cond = true;
+    bool isTargetLossReached = false;
+    while(cond)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(ASYNC_MONITOR_PERIOD_MICROSECONDS));
+        m_maxIncrement = parameters.getMaxLatestIncrement();
+        m_iterationCount = parameters.getNumUpdates();
+        cond = (m_maxIncrement > m_tolerance) && (m_iterationCount < m_maxIterations);
+        if(cond && m_isTargetLossSet)
+        {
+            // The loss of a snapshot of the parameters, which the workers
+            // keep updating meanwhile.
+            parameters.read(point.data());
+            std::copy(point.begin(), point.begin() + numColumns, &m_weights[0]);
+            m_bias = point[numColumns];
+            isTargetLossReached = evaluateTrainingLoss() <= m_targetLoss;
+            cond = !isTargetLossReached;
+        }
+    }
+    parameters.stop();
+    for(std::thread& worker: workers)
+    {
+        worker.join();
+    }
+    // The snapshot that reached the target loss is kept: the updates the
+    // workers made after it need not reach the target.
+    if(!isTargetLossReached)
+    {
+        parameters.read(point.data());
+        std::copy(point.begin(), point.begin() + numColumns, &m_weights[0]);
+        m_bias = point[numColumns];
+        m_iterationCount = parameters.getNumUpdates();
+    }
+    finishTraining();
+}
+
+void GradientDescentSolver::iterateSparse(size_t numColumns)
+{
+    initializeParameters(numColumns);
+    bool cond = true;
     while(cond)
     {
-        evaluateIncrements();
-        m_weights = m_weights + m_weightIncrements;
-        m_bias += m_biasIncrement;
+        m_maxIncrement = runSparseStep();
         m_iterationCount++;
-        cond = shouldContinueIterating();
+        cond = (m_maxIncrement > m_tolerance) && (m_iterationCount < m_maxIterations);
+        if(cond && m_isTargetLossSet)
+        {
+            finishSparseSteps();
+            cond = !(evaluateTrainingLoss() <= m_targetLoss);
+        }
         log();
     }
-}
\ No newline at end of file
+    finishSparseSteps();
+    finishTraining();
+}
+
+void GradientDescentSolver::iterateStream(DataSource& source, size_t numEpochs, size_t chunkSize)
+{
+    size_t numColumns = source.getNumColumns();
+    initializeParameters(numColumns);
+    ChunkPrefetcher prefetcher(source, chunkSize);
+    bool cond = true;
+    double lossSum = 0;
+    size_t numLossRows = 0;
+    for(size_t epoch = 0; epoch < numEpochs && cond; epoch++)
+    {
+        bool isLastEpoch = epoch + 1 == numEpochs;
+        lossSum = 0;
+        numLossRows = 0;
+        prefetcher.start();
+        const DataChunk* chunk = prefetcher.next();
+        while(chunk != nullptr && cond)
+        {
+            size_t numBatches = setChunk(*chunk);
+            for(size_t batch = 0; batch < numBatches && cond; batch++)
+            {
+                cond = step(numColumns);
+            }
+            // The chunk is released by the next call to the prefetcher, so
+            // the training loss is computed while it is still there.
+            if(isLastEpoch || !cond)
+            {
+                lossSum += evaluateTrainingLoss() * chunk->numRows;
+                numLossRows += chunk->numRows;
+            }
+            // (Asking for the next chunk would have the prefetcher read yet
+            // another one, in vain.)
+            if(!cond)
+            {
+                break;
+            }
+            chunk = prefetcher.next();
+        }
+    }
+    m_trainingLoss = (numLossRows > 0) ? lossSum / numLossRows : 0;
+    releaseTrainingData();
+}
+
+void GradientDescentSolver::iteratePartial(size_t numColumns, size_t numBatches)
+{
+    if(!hasParameters(numColumns))
+    {
+        m_bias = getRandom();
+        m_weights = getRandomVector(numColumns);
+        m_iterationCount = 0;
+    }
+    if(m_weightIncrements.getData().size() != numColumns)
+    {
+        m_weightIncrements = Vector(std::vector<double>(numColumns, 0));
+    }
+    for(size_t batch = 0; batch < numBatches; batch++)
+    {
+        update(numColumns);
+        log();
+    }
+    finishTraining();
+}
+
+size_t GradientDescentSolver::getIterationCount() const
+{
+    return m_iterationCount;
+}
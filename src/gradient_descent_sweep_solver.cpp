@@ -0,0 +1,234 @@
+#include "gradient_descent_sweep_solver.hpp"
+#include "random_quantities.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+const double GradientDescentSweepSolver::MAX_INCREMENT = 1e10;
+
+GradientDescentSweepSolver::GradientDescentSweepSolver(GradientLoss loss, const std::vector<SweepConfiguration>& configurations, size_t numStochasticSamples, size_t maxNumIterations, size_t numThreads)
+:GradientDescentData(numStochasticSamples, 1, numThreads)
+{
+    m_loss = loss;
+    m_configurations = configurations;
+    m_maxIterations = maxNumIterations;
+    m_statuses.assign(configurations.size(), SweepStatus::ACTIVE);
+    m_iterationCounts.assign(configurations.size(), 0);
+    m_trainingLosses.assign(configurations.size(), 0);
+}
+
+size_t GradientDescentSweepSolver::getNumModels() const
+{
+    return m_configurations.size();
+}
+
+const SweepConfiguration& GradientDescentSweepSolver::getConfiguration(size_t model) const
+{
+    return m_configurations[model];
+}
+
+std::vector<double> GradientDescentSweepSolver::getWeights(size_t model) const
+{
+    return std::vector<double>(m_modelWeights.begin() + model * m_numColumns, m_modelWeights.begin() + (model + 1) * m_numColumns);
+}
+
+double GradientDescentSweepSolver::getBias(size_t model) const
+{
+    return m_modelBiases[model];
+}
+
+SweepStatus GradientDescentSweepSolver::getStatus(size_t model) const
+{
+    return m_statuses[model];
+}
+
+size_t GradientDescentSweepSolver::getIterationCount(size_t model) const
+{
+    return m_iterationCounts[model];
+}
+
+double GradientDescentSweepSolver::getTrainingLoss(size_t model) const
+{
+    return m_trainingLosses[model];
+}
+
+double GradientDescentSweepSolver::evaluateTrainingLoss(size_t model) const
+{
+    const double* weights = &m_modelWeights[model * m_numColumns];
+    double cost = computeLoss(m_X, m_py->getData().data(), weights, m_modelBiases[model], m_loss);
+    double squaredNorm = 0;
+    for(size_t j = 0; j < m_numColumns; j++)
+    {
+        squaredNorm += weights[j] * weights[j];
+    }
+    return cost + 0.5 * m_configurations[model].l2Penalty * squaredNorm;
+}
+
+void GradientDescentSweepSolver::solve(const Matrix& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+void GradientDescentSweepSolver::solve(const MatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+void GradientDescentSweepSolver::evaluateSweepGradient()
+{
+    const double* y = m_py->getData().data();
+    const size_t* rows = m_indexer.getIndices();
+    size_t numModels = m_activeModels.size();
+    size_t numParameters = (m_numColumns + 1) * numModels;
+    size_t numChunks = (m_numRows + GRADIENT_CHUNK_SIZE - 1) / GRADIENT_CHUNK_SIZE;
+    auto evaluateChunk = [&](size_t c, size_t begin, size_t numChunkRows, double* gradient)
+    {
+        double* scores = &m_chunkScores[c * MULTICLASS_BLOCK_SIZE * numModels];
+        computeSweepGradient(m_X, y, rows + begin, numChunkRows, numModels, m_activeWeights.data(), m_activeBiases.data(), m_loss, scores, gradient, gradient + m_numColumns * numModels);
+        return 0.0;
+    };
+    reduceChunks(numChunks, numParameters, evaluateChunk, m_chunkSweepGradients.data(), nullptr, m_sweepGradient.data());
+}
+
+void GradientDescentSweepSolver::removeStoppedModels(size_t numColumns)
+{
+    size_t numModels = m_activeModels.size();
+    m_keptPositions.clear();
+    for(size_t a = 0; a < numModels; a++)
+    {
+        size_t model = m_activeModels[a];
+        if(m_statuses[model] == SweepStatus::ACTIVE)
+        {
+            m_keptPositions.push_back(a);
+            continue;
+        }
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            m_modelWeights[model * numColumns + j] = m_activeWeights[j * numModels + a];
+        }
+        m_modelBiases[model] = m_activeBiases[a];
+    }
+    size_t numKept = m_keptPositions.size();
+    // Compacts the columns of the kept models in place, row after row: every
+    // value moves to a lower (or the same) position, and the positions are
+    // written in increasing order, so that no value is overwritten before
+    // it is read.
+    for(size_t j = 0; j < numColumns; j++)
+    {
+        for(size_t k = 0; k < numKept; k++)
+        {
+            m_activeWeights[j * numKept + k] = m_activeWeights[j * numModels + m_keptPositions[k]];
+        }
+    }
+    for(size_t k = 0; k < numKept; k++)
+    {
+        m_activeModels[k] = m_activeModels[m_keptPositions[k]];
+        m_activeBiases[k] = m_activeBiases[m_keptPositions[k]];
+    }
+    m_activeModels.resize(numKept);
+    m_activeBiases.resize(numKept);
+    m_activeWeights.resize(numColumns * numKept);
+}
+
+void GradientDescentSweepSolver::iterate(size_t numColumns)
+{
+    assert(!m_isFloatData && !m_isSparseData);
+    size_t numModels = m_configurations.size();
+    // The same random initial weights and bias for all the models, drawn as
+    // by the other gradient descent solvers.
+    double bias = getRandom();
+    std::vector<double> weights = getRandomVector(numColumns).getData();
+    m_modelWeights.resize(numModels * numColumns);
+    for(size_t model = 0; model < numModels; model++)
+    {
+        std::copy(weights.begin(), weights.end(), m_modelWeights.begin() + model * numColumns);
+    }
+    m_modelBiases.assign(numModels, bias);
+    m_statuses.assign(numModels, SweepStatus::ACTIVE);
+    m_iterationCounts.assign(numModels, 0);
+    m_activeModels.resize(numModels);
+    m_activeWeights.resize(numColumns * numModels);
+    for(size_t model = 0; model < numModels; model++)
+    {
+        m_activeModels[model] = model;
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            m_activeWeights[j * numModels + model] = weights[j];
+        }
+    }
+    m_activeBiases.assign(numModels, bias);
+    m_maxIncrements.assign(numModels, 0);
+    m_constMults.assign(numModels, 0);
+    m_l2Terms.assign(numModels, 0);
+    m_keptPositions.clear();
+    m_keptPositions.reserve(numModels);
+    size_t numChunks = (m_numRows + GRADIENT_CHUNK_SIZE - 1) / GRADIENT_CHUNK_SIZE;
+    m_sweepGradient.assign((numColumns + 1) * numModels, 0);
+    m_chunkSweepGradients.assign((numChunks > 1) ? numChunks * (numColumns + 1) * numModels : 0, 0);
+    m_chunkScores.assign(numChunks * MULTICLASS_BLOCK_SIZE * numModels, 0);
+
+    size_t iteration = 0;
+    while(!m_activeModels.empty())
+    {
+        m_indexer.update();
+        evaluateSweepGradient();
+        size_t numActiveModels = m_activeModels.size();
+        for(size_t a = 0; a < numActiveModels; a++)
+        {
+            const SweepConfiguration& configuration = m_configurations[m_activeModels[a]];
+            double learningRate = m_schedule ? m_schedule->getLearningRate(configuration.learningRate, iteration) : configuration.learningRate;
+            m_constMults[a] = -learningRate / (1.0 * m_numRows);
+            // The gradient is the one of the cost times numRows.
+            m_l2Terms[a] = configuration.l2Penalty * m_numRows;
+            m_maxIncrements[a] = 0;
+        }
+        for(size_t j = 0; j <= numColumns; j++)
+        {
+            // The weights of feature j, or the biases.
+            double* parameters = (j < numColumns) ? &m_activeWeights[j * numActiveModels] : m_activeBiases.data();
+            const double* gradient = &m_sweepGradient[j * numActiveModels];
+            for(size_t a = 0; a < numActiveModels; a++)
+            {
+                double l2Term = (j < numColumns) ? m_l2Terms[a] * parameters[a] : 0;
+                double increment = m_constMults[a] * (gradient[a] + l2Term);
+                parameters[a] += increment;
+                // (A NaN increment is kept, and makes the model diverge.)
+                if(!(fabs(increment) <= m_maxIncrements[a]))
+                {
+                    m_maxIncrements[a] = fabs(increment);
+                }
+            }
+        }
+        iteration++;
+        bool isAnyModelStopped = false;
+        for(size_t a = 0; a < numActiveModels; a++)
+        {
+            size_t model = m_activeModels[a];
+            m_iterationCounts[model] = iteration;
+            if(!(m_maxIncrements[a] <= MAX_INCREMENT))
+            {
+                m_statuses[model] = SweepStatus::DIVERGED;
+            }
+            else if(!(m_maxIncrements[a] > m_configurations[model].tolerance))
+            {
+                m_statuses[model] = SweepStatus::CONVERGED;
+            }
+            else if(iteration >= m_maxIterations)
+            {
+                m_statuses[model] = SweepStatus::MAX_ITERATIONS;
+            }
+            isAnyModelStopped = isAnyModelStopped || (m_statuses[model] != SweepStatus::ACTIVE);
+        }
+        if(isAnyModelStopped)
+        {
+            removeStoppedModels(numColumns);
+        }
+    }
+    for(size_t model = 0; model < numModels; model++)
+    {
+        m_trainingLosses[model] = evaluateTrainingLoss(model);
+    }
+    clearDataReferences();
+}
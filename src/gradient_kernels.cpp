@@ -0,0 +1,959 @@
+#include "gradient_kernels.hpp"
+#include "ml_functions.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRADIENT_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+static inline double getError(double z, double y, GradientLoss loss)
+{
+    return ((loss == GradientLoss::LOGISTIC) ? sigmoid(z) : z) - y;
+}
+
+template<typename T>
+static double computeGradientScalar(const BasicMatrixView<T>& X, const double* y, const size_t* rows, size_t numRows, const T* weights, double bias, GradientLoss loss, double* gradient)
+{
+    size_t numColumns = X.getNumColumns();
+    double errSum = 0;
+    for(size_t r = 0; r < numRows; r++)
+    {
+        const T* xrow = X.getRow(rows[r]);
+        double z = bias;
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            z += xrow[j] * weights[j];
+        }
+        double err = getError(z, y[rows[r]], loss);
+        errSum += err;
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            gradient[j] += err * xrow[j];
+        }
+    }
+    return errSum;
+}
+
+#ifdef GRADIENT_KERNELS_X86
+
+__attribute__((target("avx2,fma")))
+static double computeGradientAVX2(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double bias, GradientLoss loss, double* gradient)
+{
+    size_t numColumns = X.getNumColumns();
+    size_t numVectorColumns = numColumns - numColumns % 4;
+    double errSum = 0;
+    for(size_t r = 0; r < numRows; r++)
+    {
+        const double* xrow = X.getRow(rows[r]);
+        // Two accumulators, so that consecutive FMAs do not wait on each other.
+        __m256d dot0 = _mm256_setzero_pd();
+        __m256d dot1 = _mm256_setzero_pd();
+        size_t j = 0;
+        for(; j + 8 <= numColumns; j += 8)
+        {
+            dot0 = _mm256_fmadd_pd(_mm256_loadu_pd(xrow + j), _mm256_loadu_pd(weights + j), dot0);
+            dot1 = _mm256_fmadd_pd(_mm256_loadu_pd(xrow + j + 4), _mm256_loadu_pd(weights + j + 4), dot1);
+        }
+        for(; j < numVectorColumns; j += 4)
+        {
+            dot0 = _mm256_fmadd_pd(_mm256_loadu_pd(xrow + j), _mm256_loadu_pd(weights + j), dot0);
+        }
+        dot0 = _mm256_add_pd(dot0, dot1);
+        __m128d dot = _mm_add_pd(_mm256_castpd256_pd128(dot0), _mm256_extractf128_pd(dot0, 1));
+        double z = bias + _mm_cvtsd_f64(dot) + _mm_cvtsd_f64(_mm_unpackhi_pd(dot, dot));
+        for(; j < numColumns; j++)
+        {
+            z += xrow[j] * weights[j];
+        }
+        double err = getError(z, y[rows[r]], loss);
+        errSum += err;
+        __m256d errs = _mm256_set1_pd(err);
+        for(j = 0; j < numVectorColumns; j += 4)
+        {
+            _mm256_storeu_pd(gradient + j, _mm256_fmadd_pd(errs, _mm256_loadu_pd(xrow + j), _mm256_loadu_pd(gradient + j)));
+        }
+        for(; j < numColumns; j++)
+        {
+            gradient[j] += err * xrow[j];
+        }
+    }
+    return errSum;
+}
+
+__attribute__((target("avx512f")))
+static double computeGradientAVX512(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double bias, GradientLoss loss, double* gradient)
+{
+    size_t numColumns = X.getNumColumns();
+    // The last (partial) block of 8 columns is handled by masked loads.
+    __mmask8 tailMask = __mmask8((1u << (numColumns % 8)) - 1);
+    size_t numFullColumns = numColumns - numColumns % 8;
+    double errSum = 0;
+    for(size_t r = 0; r < numRows; r++)
+    {
+        const double* xrow = X.getRow(rows[r]);
+        __m512d dot0 = _mm512_setzero_pd();
+        __m512d dot1 = _mm512_setzero_pd();
+        size_t j = 0;
+        for(; j + 16 <= numColumns; j += 16)
+        {
+            dot0 = _mm512_fmadd_pd(_mm512_loadu_pd(xrow + j), _mm512_loadu_pd(weights + j), dot0);
+            dot1 = _mm512_fmadd_pd(_mm512_loadu_pd(xrow + j + 8), _mm512_loadu_pd(weights + j + 8), dot1);
+        }
+        for(; j < numFullColumns; j += 8)
+        {
+            dot0 = _mm512_fmadd_pd(_mm512_loadu_pd(xrow + j), _mm512_loadu_pd(weights + j), dot0);
+        }
+        if(tailMask != 0)
+        {
+            dot1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(tailMask, xrow + j), _mm512_maskz_loadu_pd(tailMask, weights + j), dot1);
+        }
+        double z = bias + _mm512_reduce_add_pd(_mm512_add_pd(dot0, dot1));
+        double err = getError(z, y[rows[r]], loss);
+        errSum += err;
+        __m512d errs = _mm512_set1_pd(err);
+        for(j = 0; j < numFullColumns; j += 8)
+        {
+            _mm512_storeu_pd(gradient + j, _mm512_fmadd_pd(errs, _mm512_loadu_pd(xrow + j), _mm512_loadu_pd(gradient + j)));
+        }
+        if(tailMask != 0)
+        {
+            __m512d sums = _mm512_fmadd_pd(errs, _mm512_maskz_loadu_pd(tailMask, xrow + j), _mm512_maskz_loadu_pd(tailMask, gradient + j));
+            _mm512_mask_storeu_pd(gradient + j, tailMask, sums);
+        }
+    }
+    return errSum;
+}
+
+__attribute__((target("avx2,fma")))
+static double computeGradientAVX2(const FloatMatrixView& X, const double* y, const size_t* rows, size_t numRows, const float* weights, double bias, GradientLoss loss, double* gradient)
+{
+    size_t numColumns = X.getNumColumns();
+    size_t numVectorColumns = numColumns - numColumns % 8;
+    size_t numGradientColumns = numColumns - numColumns % 4;
+    double errSum = 0;
+    for(size_t r = 0; r < numRows; r++)
+    {
+        const float* xrow = X.getRow(rows[r]);
+        // 8 floats per register: twice the columns of the double kernel.
+        __m256 dot0 = _mm256_setzero_ps();
+        __m256 dot1 = _mm256_setzero_ps();
+        size_t j = 0;
+        for(; j + 16 <= numColumns; j += 16)
+        {
+            dot0 = _mm256_fmadd_ps(_mm256_loadu_ps(xrow + j), _mm256_loadu_ps(weights + j), dot0);
+            dot1 = _mm256_fmadd_ps(_mm256_loadu_ps(xrow + j + 8), _mm256_loadu_ps(weights + j + 8), dot1);
+        }
+        for(; j < numVectorColumns; j += 8)
+        {
+            dot0 = _mm256_fmadd_ps(_mm256_loadu_ps(xrow + j), _mm256_loadu_ps(weights + j), dot0);
+        }
+        dot0 = _mm256_add_ps(dot0, dot1);
+        __m128 dot = _mm_add_ps(_mm256_castps256_ps128(dot0), _mm256_extractf128_ps(dot0, 1));
+        dot = _mm_add_ps(dot, _mm_movehl_ps(dot, dot));
+        dot = _mm_add_ss(dot, _mm_shuffle_ps(dot, dot, 1));
+        double z = bias + _mm_cvtss_f32(dot);
+        for(; j < numColumns; j++)
+        {
+            z += xrow[j] * weights[j];
+        }
+        double err = getError(z, y[rows[r]], loss);
+        errSum += err;
+        // The gradient is accumulated in double precision, 4 columns at a time.
+        __m256d errs = _mm256_set1_pd(err);
+        for(j = 0; j < numGradientColumns; j += 4)
+        {
+            __m256d x = _mm256_cvtps_pd(_mm_loadu_ps(xrow + j));
+            _mm256_storeu_pd(gradient + j, _mm256_fmadd_pd(errs, x, _mm256_loadu_pd(gradient + j)));
+        }
+        for(; j < numColumns; j++)
+        {
+            gradient[j] += err * xrow[j];
+        }
+    }
+    return errSum;
+}
+
+__attribute__((target("avx512f")))
+static double computeGradientAVX512(const FloatMatrixView& X, const double* y, const size_t* rows, size_t numRows, const float* weights, double bias, GradientLoss loss, double* gradient)
+{
+    size_t numColumns = X.getNumColumns();
+    __mmask16 tailMask = __mmask16((1u << (numColumns % 16)) - 1);
+    size_t numFullColumns = numColumns - numColumns % 16;
+    // The gradient is accumulated in double precision, 8 columns at a time.
+    __mmask16 gradientTailMask = __mmask16((1u << (numColumns % 8)) - 1);
+    size_t numGradientColumns = numColumns - numColumns % 8;
+    double errSum = 0;
+    for(size_t r = 0; r < numRows; r++)
+    {
+        const float* xrow = X.getRow(rows[r]);
+        __m512 dot0 = _mm512_setzero_ps();
+        __m512 dot1 = _mm512_setzero_ps();
+        size_t j = 0;
+        for(; j + 32 <= numColumns; j += 32)
+        {
+            dot0 = _mm512_fmadd_ps(_mm512_loadu_ps(xrow + j), _mm512_loadu_ps(weights + j), dot0);
+            dot1 = _mm512_fmadd_ps(_mm512_loadu_ps(xrow + j + 16), _mm512_loadu_ps(weights + j + 16), dot1);
+        }
+        for(; j < numFullColumns; j += 16)
+        {
+            dot0 = _mm512_fmadd_ps(_mm512_loadu_ps(xrow + j), _mm512_loadu_ps(weights + j), dot0);
+        }
+        if(tailMask != 0)
+        {
+            dot1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tailMask, xrow + j), _mm512_maskz_loadu_ps(tailMask, weights + j), dot1);
+        }
+        double z = bias + _mm512_reduce_add_ps(_mm512_add_ps(dot0, dot1));
+        double err = getError(z, y[rows[r]], loss);
+        errSum += err;
+        __m512d errs = _mm512_set1_pd(err);
+        for(j = 0; j < numGradientColumns; j += 8)
+        {
+            __m512d x = _mm512_cvtps_pd(_mm256_loadu_ps(xrow + j));
+            _mm512_storeu_pd(gradient + j, _mm512_fmadd_pd(errs, x, _mm512_loadu_pd(gradient + j)));
+        }
+        if(gradientTailMask != 0)
+        {
+            __m512d x = _mm512_cvtps_pd(_mm512_castps512_ps256(_mm512_maskz_loadu_ps(gradientTailMask, xrow + j)));
+            __m512d sums = _mm512_fmadd_pd(errs, x, _mm512_maskz_loadu_pd(__mmask8(gradientTailMask), gradient + j));
+            _mm512_mask_storeu_pd(gradient + j, __mmask8(gradientTailMask), sums);
+        }
+    }
+    return errSum;
+}
+
+#endif
+
+bool isGradientKernelSupported(GradientKernel kernel)
+{
+    switch(kernel)
+    {
+#ifdef GRADIENT_KERNELS_X86
+    case GradientKernel::AVX512:
+        return __builtin_cpu_supports("avx512f");
+    case GradientKernel::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    case GradientKernel::SCALAR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+GradientKernel getBestGradientKernel()
+{
+    // Detected once; the answer does not change while running.
+    static const GradientKernel bestKernel = isGradientKernelSupported(GradientKernel::AVX512) ? GradientKernel::AVX512 :
+        (isGradientKernelSupported(GradientKernel::AVX2) ? GradientKernel::AVX2 : GradientKernel::SCALAR);
+    return bestKernel;
+}
+
+const char* getGradientKernelName(GradientKernel kernel)
+{
+    switch(kernel)
+    {
+    case GradientKernel::AVX512:
+        return "AVX-512";
+    case GradientKernel::AVX2:
+        return "AVX2";
+    default:
+        return "SCALAR";
+    }
+}
+
+double computeGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double bias, GradientLoss loss, double* gradient)
+{
+    return computeGradient(X, y, rows, numRows, weights, bias, loss, gradient, getBestGradientKernel());
+}
+
+double computeGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double bias, GradientLoss loss, double* gradient, GradientKernel kernel)
+{
+    assert(isGradientKernelSupported(kernel));
+    std::fill(gradient, gradient + X.getNumColumns(), 0.0);
+    switch(kernel)
+    {
+#ifdef GRADIENT_KERNELS_X86
+    case GradientKernel::AVX512:
+        return computeGradientAVX512(X, y, rows, numRows, weights, bias, loss, gradient);
+    case GradientKernel::AVX2:
+        return computeGradientAVX2(X, y, rows, numRows, weights, bias, loss, gradient);
+#endif
+    default:
+        return computeGradientScalar(X, y, rows, numRows, weights, bias, loss, gradient);
+    }
+}
+
+double computeGradient(const FloatMatrixView& X, const double* y, const size_t* rows, size_t numRows, const float* weights, double bias, GradientLoss loss, double* gradient)
+{
+    return computeGradient(X, y, rows, numRows, weights, bias, loss, gradient, getBestGradientKernel());
+}
+
+double computeGradient(const FloatMatrixView& X, const double* y, const size_t* rows, size_t numRows, const float* weights, double bias, GradientLoss loss, double* gradient, GradientKernel kernel)
+{
+    assert(isGradientKernelSupported(kernel));
+    std::fill(gradient, gradient + X.getNumColumns(), 0.0);
+    switch(kernel)
+    {
+#ifdef GRADIENT_KERNELS_X86
+    case GradientKernel::AVX512:
+        return computeGradientAVX512(X, y, rows, numRows, weights, bias, loss, gradient);
+    case GradientKernel::AVX2:
+        return computeGradientAVX2(X, y, rows, numRows, weights, bias, loss, gradient);
+#endif
+    default:
+        return computeGradientScalar(X, y, rows, numRows, weights, bias, loss, gradient);
+    }
+}
+
+double computeGradient(const CsrMatrix& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double bias, GradientLoss loss, double* gradient)
+{
+    std::fill(gradient, gradient + X.getNumColumns(), 0.0);
+    double errSum = 0;
+    for(size_t r = 0; r < numRows; r++)
+    {
+        double err = getError(X.getScore(rows[r], weights, bias), y[rows[r]], loss);
+        errSum += err;
+        const uint32_t* columns = X.getRowColumns(rows[r]);
+        const double* values = X.getRowValues(rows[r]);
+        for(size_t k = 0; k < X.getRowSize(rows[r]); k++)
+        {
+            gradient[columns[k]] += err * values[k];
+        }
+    }
+    return errSum;
+}
+
+double computeErrors(const CsrMatrix& X, const double* y, const size_t* rows, size_t numRows, const double* weights, double weightScale, double bias, GradientLoss loss, double* errors)
+{
+    double errSum = 0;
+    for(size_t r = 0; r < numRows; r++)
+    {
+        double z = bias + weightScale * (X.getScore(rows[r], weights, 0));
+        errors[r] = getError(z, y[rows[r]], loss);
+        errSum += errors[r];
+    }
+    return errSum;
+}
+
+static inline double getLoss(double z, double y, GradientLoss loss)
+{
+    if(loss == GradientLoss::LOGISTIC)
+    {
+        // log(1 + exp(z)), without overflowing for large z
+        return std::max(z, 0.0) + log1p(exp(-fabs(z))) - y * z;
+    }
+    double err = z - y;
+    return 0.5 * err * err;
+}
+
+template<typename T>
+static double computeLossOf(const BasicMatrixView<T>& X, const double* y, const double* weights, double bias, GradientLoss loss)
+{
+    size_t numRows = X.getNumRows();
+    size_t numColumns = X.getNumColumns();
+    double lossSum = 0;
+    for(size_t i = 0; i < numRows; i++)
+    {
+        const T* xrow = X.getRow(i);
+        double z = bias;
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            z += xrow[j] * weights[j];
+        }
+        lossSum += getLoss(z, y[i], loss);
+    }
+    return (numRows > 0) ? lossSum / numRows : 0;
+}
+
+double computeLoss(const MatrixView& X, const double* y, const double* weights, double bias, GradientLoss loss)
+{
+    return computeLossOf(X, y, weights, bias, loss);
+}
+
+double computeLoss(const FloatMatrixView& X, const double* y, const double* weights, double bias, GradientLoss loss)
+{
+    return computeLossOf(X, y, weights, bias, loss);
+}
+
+double computeLoss(const CsrMatrix& X, const double* y, const double* weights, double bias, GradientLoss loss)
+{
+    size_t numRows = X.getNumRows();
+    double lossSum = 0;
+    for(size_t i = 0; i < numRows; i++)
+    {
+        lossSum += getLoss(X.getScore(i, weights, bias), y[i], loss);
+    }
+    return (numRows > 0) ? lossSum / numRows : 0;
+}
+
+template<typename T>
+static void computeScoresOf(const BasicMatrixView<T>& X, const double* weights, double bias, double* scores)
+{
+    size_t numColumns = X.getNumColumns();
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        const T* xrow = X.getRow(i);
+        double z = bias;
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            z += xrow[j] * weights[j];
+        }
+        scores[i] = z;
+    }
+}
+
+void computeScores(const MatrixView& X, const double* weights, double bias, double* scores)
+{
+    computeScoresOf(X, weights, bias, scores);
+}
+
+void computeScores(const FloatMatrixView& X, const double* weights, double bias, double* scores)
+{
+    computeScoresOf(X, weights, bias, scores);
+}
+
+void computeScores(const CsrMatrix& X, const double* weights, double bias, double* scores)
+{
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        scores[i] = X.getScore(i, weights, bias);
+    }
+}
+
+// Block products of the multi-class (and sweep) kernels, for a block of (at
+// most MULTICLASS_BLOCK_SIZE) rows, given by their row pointers; the
+// classes are the models of a sweep:
+//   logits[r] = biases + xrows[r] * weights
+//   gradient += xrows-transpose * errors
+// (errors: numRows x numClasses, as the logits). The vectorized variants go
+// through the classes in tiles of up to 4 registers, which hold the logits
+// of a row (or the gradient of a feature) while the features (or the rows)
+// are gone through, so that they are loaded and stored once per tile.
+
+static void computeBlockLogitsScalar(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* weights, const double* biases, double* logits)
+{
+    for(size_t r = 0; r < numRows; r++)
+    {
+        double* rowLogits = logits + r * numClasses;
+        std::copy(biases, biases + numClasses, rowLogits);
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            axpy(numClasses, xrows[r][j], weights + j * numClasses, rowLogits);
+        }
+    }
+}
+
+static void addBlockGradientScalar(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* errors, double* gradient)
+{
+    for(size_t j = 0; j < numColumns; j++)
+    {
+        double* featureGradient = gradient + j * numClasses;
+        for(size_t r = 0; r < numRows; r++)
+        {
+            axpy(numClasses, xrows[r][j], errors + r * numClasses, featureGradient);
+        }
+    }
+}
+
+#ifdef GRADIENT_KERNELS_X86
+
+// A tile of V registers of 8 classes from class k (the last register holds
+// the classes of lastMask), for R rows (or features) at a time: the R * V
+// independent sums keep the FMA units busy.
+template<int V, int R>
+__attribute__((target("avx512f")))
+static void computeTileLogitsAVX512(const double* const* xrows, size_t numColumns, size_t numClasses, const double* weights, const double* biases, double* logits, size_t k, __mmask8 lastMask)
+{
+    __mmask8 masks[V];
+    #pragma GCC unroll 4
+    for(int t = 0; t < V; t++)
+    {
+        masks[t] = (t == V - 1) ? lastMask : __mmask8(0xFF);
+    }
+    __m512d sums[R][V];
+    #pragma GCC unroll 4
+    for(int t = 0; t < V; t++)
+    {
+        __m512d bias = _mm512_maskz_loadu_pd(masks[t], biases + k + 8 * t);
+        #pragma GCC unroll 4
+        for(int r = 0; r < R; r++)
+        {
+            sums[r][t] = bias;
+        }
+    }
+    for(size_t j = 0; j < numColumns; j++)
+    {
+        const double* featureWeights = weights + j * numClasses + k;
+        __m512d w[V];
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            w[t] = _mm512_maskz_loadu_pd(masks[t], featureWeights + 8 * t);
+        }
+        #pragma GCC unroll 4
+        for(int r = 0; r < R; r++)
+        {
+            __m512d x = _mm512_set1_pd(xrows[r][j]);
+            #pragma GCC unroll 4
+            for(int t = 0; t < V; t++)
+            {
+                sums[r][t] = _mm512_fmadd_pd(x, w[t], sums[r][t]);
+            }
+        }
+    }
+    #pragma GCC unroll 4
+    for(int r = 0; r < R; r++)
+    {
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            _mm512_mask_storeu_pd(logits + r * numClasses + k + 8 * t, masks[t], sums[r][t]);
+        }
+    }
+}
+
+template<int V, int R>
+__attribute__((target("avx512f")))
+static void addTileGradientAVX512(const double* const* xrows, size_t numRows, size_t numClasses, const double* errors, double* gradient, size_t j, size_t k, __mmask8 lastMask)
+{
+    __mmask8 masks[V];
+    #pragma GCC unroll 4
+    for(int t = 0; t < V; t++)
+    {
+        masks[t] = (t == V - 1) ? lastMask : __mmask8(0xFF);
+    }
+    __m512d sums[R][V];
+    #pragma GCC unroll 4
+    for(int f = 0; f < R; f++)
+    {
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            sums[f][t] = _mm512_maskz_loadu_pd(masks[t], gradient + (j + f) * numClasses + k + 8 * t);
+        }
+    }
+    for(size_t r = 0; r < numRows; r++)
+    {
+        const double* rowErrors = errors + r * numClasses + k;
+        __m512d e[V];
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            e[t] = _mm512_maskz_loadu_pd(masks[t], rowErrors + 8 * t);
+        }
+        #pragma GCC unroll 4
+        for(int f = 0; f < R; f++)
+        {
+            __m512d x = _mm512_set1_pd(xrows[r][j + f]);
+            #pragma GCC unroll 4
+            for(int t = 0; t < V; t++)
+            {
+                sums[f][t] = _mm512_fmadd_pd(x, e[t], sums[f][t]);
+            }
+        }
+    }
+    #pragma GCC unroll 4
+    for(int f = 0; f < R; f++)
+    {
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            _mm512_mask_storeu_pd(gradient + (j + f) * numClasses + k + 8 * t, masks[t], sums[f][t]);
+        }
+    }
+}
+
+// Goes through the rows, 4 at a time, for a tile of V registers.
+template<int V>
+__attribute__((target("avx512f")))
+static void computeTilesLogitsAVX512(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* weights, const double* biases, double* logits, size_t k, __mmask8 lastMask)
+{
+    size_t r = 0;
+    for(; r + 4 <= numRows; r += 4)
+    {
+        computeTileLogitsAVX512<V, 4>(xrows + r, numColumns, numClasses, weights, biases, logits + r * numClasses, k, lastMask);
+    }
+    for(; r < numRows; r++)
+    {
+        computeTileLogitsAVX512<V, 1>(xrows + r, numColumns, numClasses, weights, biases, logits + r * numClasses, k, lastMask);
+    }
+}
+
+// Goes through the features, 4 at a time, for a tile of V registers.
+template<int V>
+__attribute__((target("avx512f")))
+static void addTilesGradientAVX512(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* errors, double* gradient, size_t k, __mmask8 lastMask)
+{
+    size_t j = 0;
+    for(; j + 4 <= numColumns; j += 4)
+    {
+        addTileGradientAVX512<V, 4>(xrows, numRows, numClasses, errors, gradient, j, k, lastMask);
+    }
+    for(; j < numColumns; j++)
+    {
+        addTileGradientAVX512<V, 1>(xrows, numRows, numClasses, errors, gradient, j, k, lastMask);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void computeBlockLogitsAVX512(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* weights, const double* biases, double* logits)
+{
+    for(size_t k = 0; k < numClasses; k += 32)
+    {
+        size_t tileSize = std::min(size_t(32), numClasses - k);
+        __mmask8 lastMask = __mmask8((1u << (tileSize - (tileSize - 1) / 8 * 8)) - 1);
+        switch((tileSize + 7) / 8)
+        {
+        case 1:
+            computeTilesLogitsAVX512<1>(xrows, numRows, numColumns, numClasses, weights, biases, logits, k, lastMask);
+            break;
+        case 2:
+            computeTilesLogitsAVX512<2>(xrows, numRows, numColumns, numClasses, weights, biases, logits, k, lastMask);
+            break;
+        case 3:
+            computeTilesLogitsAVX512<3>(xrows, numRows, numColumns, numClasses, weights, biases, logits, k, lastMask);
+            break;
+        default:
+            computeTilesLogitsAVX512<4>(xrows, numRows, numColumns, numClasses, weights, biases, logits, k, lastMask);
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static void addBlockGradientAVX512(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* errors, double* gradient)
+{
+    for(size_t k = 0; k < numClasses; k += 32)
+    {
+        size_t tileSize = std::min(size_t(32), numClasses - k);
+        __mmask8 lastMask = __mmask8((1u << (tileSize - (tileSize - 1) / 8 * 8)) - 1);
+        switch((tileSize + 7) / 8)
+        {
+        case 1:
+            addTilesGradientAVX512<1>(xrows, numRows, numColumns, numClasses, errors, gradient, k, lastMask);
+            break;
+        case 2:
+            addTilesGradientAVX512<2>(xrows, numRows, numColumns, numClasses, errors, gradient, k, lastMask);
+            break;
+        case 3:
+            addTilesGradientAVX512<3>(xrows, numRows, numColumns, numClasses, errors, gradient, k, lastMask);
+            break;
+        default:
+            addTilesGradientAVX512<4>(xrows, numRows, numColumns, numClasses, errors, gradient, k, lastMask);
+        }
+    }
+}
+
+// AVX2 tiles are of V registers of 4 classes; the classes left over (fewer
+// than 4) go through the scalar loops.
+template<int V>
+__attribute__((target("avx2,fma")))
+static void computeTileLogitsAVX2(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* weights, const double* biases, double* logits, size_t k)
+{
+    for(size_t r = 0; r < numRows; r++)
+    {
+        const double* xrow = xrows[r];
+        __m256d sums[V];
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            sums[t] = _mm256_loadu_pd(biases + k + 4 * t);
+        }
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            __m256d x = _mm256_set1_pd(xrow[j]);
+            const double* featureWeights = weights + j * numClasses + k;
+            #pragma GCC unroll 4
+            for(int t = 0; t < V; t++)
+            {
+                sums[t] = _mm256_fmadd_pd(x, _mm256_loadu_pd(featureWeights + 4 * t), sums[t]);
+            }
+        }
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            _mm256_storeu_pd(logits + r * numClasses + k + 4 * t, sums[t]);
+        }
+    }
+}
+
+template<int V>
+__attribute__((target("avx2,fma")))
+static void addTileGradientAVX2(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* errors, double* gradient, size_t k)
+{
+    for(size_t j = 0; j < numColumns; j++)
+    {
+        double* featureGradient = gradient + j * numClasses + k;
+        __m256d sums[V];
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            sums[t] = _mm256_loadu_pd(featureGradient + 4 * t);
+        }
+        for(size_t r = 0; r < numRows; r++)
+        {
+            __m256d x = _mm256_set1_pd(xrows[r][j]);
+            const double* rowErrors = errors + r * numClasses + k;
+            #pragma GCC unroll 4
+            for(int t = 0; t < V; t++)
+            {
+                sums[t] = _mm256_fmadd_pd(x, _mm256_loadu_pd(rowErrors + 4 * t), sums[t]);
+            }
+        }
+        #pragma GCC unroll 4
+        for(int t = 0; t < V; t++)
+        {
+            _mm256_storeu_pd(featureGradient + 4 * t, sums[t]);
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void computeBlockLogitsAVX2(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* weights, const double* biases, double* logits)
+{
+    size_t numVectorClasses = numClasses - numClasses % 4;
+    for(size_t k = 0; k < numVectorClasses; k += 16)
+    {
+        switch(std::min(size_t(16), numVectorClasses - k) / 4)
+        {
+        case 1:
+            computeTileLogitsAVX2<1>(xrows, numRows, numColumns, numClasses, weights, biases, logits, k);
+            break;
+        case 2:
+            computeTileLogitsAVX2<2>(xrows, numRows, numColumns, numClasses, weights, biases, logits, k);
+            break;
+        case 3:
+            computeTileLogitsAVX2<3>(xrows, numRows, numColumns, numClasses, weights, biases, logits, k);
+            break;
+        default:
+            computeTileLogitsAVX2<4>(xrows, numRows, numColumns, numClasses, weights, biases, logits, k);
+        }
+    }
+    for(size_t k = numVectorClasses; k < numClasses; k++)
+    {
+        for(size_t r = 0; r < numRows; r++)
+        {
+            double z = biases[k];
+            for(size_t j = 0; j < numColumns; j++)
+            {
+                z += xrows[r][j] * weights[j * numClasses + k];
+            }
+            logits[r * numClasses + k] = z;
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void addBlockGradientAVX2(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* errors, double* gradient)
+{
+    size_t numVectorClasses = numClasses - numClasses % 4;
+    for(size_t k = 0; k < numVectorClasses; k += 16)
+    {
+        switch(std::min(size_t(16), numVectorClasses - k) / 4)
+        {
+        case 1:
+            addTileGradientAVX2<1>(xrows, numRows, numColumns, numClasses, errors, gradient, k);
+            break;
+        case 2:
+            addTileGradientAVX2<2>(xrows, numRows, numColumns, numClasses, errors, gradient, k);
+            break;
+        case 3:
+            addTileGradientAVX2<3>(xrows, numRows, numColumns, numClasses, errors, gradient, k);
+            break;
+        default:
+            addTileGradientAVX2<4>(xrows, numRows, numColumns, numClasses, errors, gradient, k);
+        }
+    }
+    for(size_t k = numVectorClasses; k < numClasses; k++)
+    {
+        for(size_t j = 0; j < numColumns; j++)
+        {
+            double sum = gradient[j * numClasses + k];
+            for(size_t r = 0; r < numRows; r++)
+            {
+                sum += xrows[r][j] * errors[r * numClasses + k];
+            }
+            gradient[j * numClasses + k] = sum;
+        }
+    }
+}
+
+#endif
+
+static void computeBlockLogits(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* weights, const double* biases, double* logits, GradientKernel kernel)
+{
+    switch(kernel)
+    {
+#ifdef GRADIENT_KERNELS_X86
+    case GradientKernel::AVX512:
+        computeBlockLogitsAVX512(xrows, numRows, numColumns, numClasses, weights, biases, logits);
+        return;
+    case GradientKernel::AVX2:
+        computeBlockLogitsAVX2(xrows, numRows, numColumns, numClasses, weights, biases, logits);
+        return;
+#endif
+    default:
+        computeBlockLogitsScalar(xrows, numRows, numColumns, numClasses, weights, biases, logits);
+    }
+}
+
+static void addBlockGradient(const double* const* xrows, size_t numRows, size_t numColumns, size_t numClasses, const double* errors, double* gradient, GradientKernel kernel)
+{
+    switch(kernel)
+    {
+#ifdef GRADIENT_KERNELS_X86
+    case GradientKernel::AVX512:
+        addBlockGradientAVX512(xrows, numRows, numColumns, numClasses, errors, gradient);
+        return;
+    case GradientKernel::AVX2:
+        addBlockGradientAVX2(xrows, numRows, numColumns, numClasses, errors, gradient);
+        return;
+#endif
+    default:
+        addBlockGradientScalar(xrows, numRows, numColumns, numClasses, errors, gradient);
+    }
+}
+
+// Turns the logits of a row into its errors p - onehot(label), in place,
+// and returns its loss.
+static double computeMulticlassErrors(double* logits, size_t numClasses, size_t label, MulticlassLoss loss)
+{
+    double rowLoss = 0;
+    if(loss == MulticlassLoss::SOFTMAX)
+    {
+        double maxLogit = *std::max_element(logits, logits + numClasses);
+        double labelLogit = logits[label] - maxLogit;
+        double expSum = 0;
+        for(size_t k = 0; k < numClasses; k++)
+        {
+            logits[k] = exp(logits[k] - maxLogit);
+            expSum += logits[k];
+        }
+        // -log(p[label]) = log(SUM(exp(z - max))) - (z[label] - max)
+        rowLoss = log(expSum) - labelLogit;
+        for(size_t k = 0; k < numClasses; k++)
+        {
+            logits[k] /= expSum;
+        }
+    }
+    else
+    {
+        for(size_t k = 0; k < numClasses; k++)
+        {
+            double z = logits[k];
+            rowLoss += std::max(z, 0.0) + log1p(exp(-fabs(z))) - ((k == label) ? z : 0);
+            logits[k] = sigmoid(z);
+        }
+    }
+    logits[label] -= 1;
+    return rowLoss;
+}
+
+double computeMulticlassGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, size_t numClasses, const double* weights, const double* biases, MulticlassLoss loss, double* logits, double* gradient, double* biasGradient)
+{
+    return computeMulticlassGradient(X, y, rows, numRows, numClasses, weights, biases, loss, logits, gradient, biasGradient, getBestGradientKernel());
+}
+
+double computeMulticlassGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, size_t numClasses, const double* weights, const double* biases, MulticlassLoss loss, double* logits, double* gradient, double* biasGradient, GradientKernel kernel)
+{
+    assert(isGradientKernelSupported(kernel));
+    size_t numColumns = X.getNumColumns();
+    std::fill(gradient, gradient + numColumns * numClasses, 0.0);
+    std::fill(biasGradient, biasGradient + numClasses, 0.0);
+    const double* xrows[MULTICLASS_BLOCK_SIZE];
+    double lossSum = 0;
+    for(size_t begin = 0; begin < numRows; begin += MULTICLASS_BLOCK_SIZE)
+    {
+        size_t blockSize = std::min(MULTICLASS_BLOCK_SIZE, numRows - begin);
+        for(size_t r = 0; r < blockSize; r++)
+        {
+            xrows[r] = X.getRow(rows[begin + r]);
+        }
+        computeBlockLogits(xrows, blockSize, numColumns, numClasses, weights, biases, logits, kernel);
+        for(size_t r = 0; r < blockSize; r++)
+        {
+            double* errors = logits + r * numClasses;
+            lossSum += computeMulticlassErrors(errors, numClasses, size_t(y[rows[begin + r]]), loss);
+            axpy(numClasses, 1, errors, biasGradient);
+        }
+        addBlockGradient(xrows, blockSize, numColumns, numClasses, logits, gradient, kernel);
+    }
+    return lossSum;
+}
+
+void computeSweepGradient(const MatrixView& X, const double* y, const size_t* rows, size_t numRows, size_t numModels, const double* weights, const double* biases, GradientLoss loss, double* scores, double* gradient, double* biasGradient)
+{
+    GradientKernel kernel = getBestGradientKernel();
+    size_t numColumns = X.getNumColumns();
+    std::fill(gradient, gradient + numColumns * numModels, 0.0);
+    std::fill(biasGradient, biasGradient + numModels, 0.0);
+    const double* xrows[MULTICLASS_BLOCK_SIZE];
+    for(size_t begin = 0; begin < numRows; begin += MULTICLASS_BLOCK_SIZE)
+    {
+        size_t blockSize = std::min(MULTICLASS_BLOCK_SIZE, numRows - begin);
+        for(size_t r = 0; r < blockSize; r++)
+        {
+            xrows[r] = X.getRow(rows[begin + r]);
+        }
+        computeBlockLogits(xrows, blockSize, numColumns, numModels, weights, biases, scores, kernel);
+        for(size_t r = 0; r < blockSize; r++)
+        {
+            double* errors = scores + r * numModels;
+            double yr = y[rows[begin + r]];
+            for(size_t m = 0; m < numModels; m++)
+            {
+                errors[m] = getError(errors[m], yr, loss);
+            }
+            axpy(numModels, 1, errors, biasGradient);
+        }
+        addBlockGradient(xrows, blockSize, numColumns, numModels, scores, gradient, kernel);
+    }
+}
+
+double computeMulticlassLoss(const MatrixView& X, const double* y, size_t numClasses, const double* weights, const double* biases, MulticlassLoss loss)
+{
+    size_t numRows = X.getNumRows();
+    std::vector<double> logits(MULTICLASS_BLOCK_SIZE * numClasses);
+    const double* xrows[MULTICLASS_BLOCK_SIZE];
+    double lossSum = 0;
+    for(size_t begin = 0; begin < numRows; begin += MULTICLASS_BLOCK_SIZE)
+    {
+        size_t blockSize = std::min(MULTICLASS_BLOCK_SIZE, numRows - begin);
+        for(size_t r = 0; r < blockSize; r++)
+        {
+            xrows[r] = X.getRow(begin + r);
+        }
+        computeBlockLogits(xrows, blockSize, X.getNumColumns(), numClasses, weights, biases, logits.data(), getBestGradientKernel());
+        for(size_t r = 0; r < blockSize; r++)
+        {
+            lossSum += computeMulticlassErrors(&logits[r * numClasses], numClasses, size_t(y[begin + r]), loss);
+        }
+    }
+    return (numRows > 0) ? lossSum / numRows : 0;
+}
+
+void computeLogits(const MatrixView& X, size_t numClasses, const double* weights, const double* biases, double* logits)
+{
+    size_t numRows = X.getNumRows();
+    const double* xrows[MULTICLASS_BLOCK_SIZE];
+    for(size_t begin = 0; begin < numRows; begin += MULTICLASS_BLOCK_SIZE)
+    {
+        size_t blockSize = std::min(MULTICLASS_BLOCK_SIZE, numRows - begin);
+        for(size_t r = 0; r < blockSize; r++)
+        {
+            xrows[r] = X.getRow(begin + r);
+        }
+        computeBlockLogits(xrows, blockSize, X.getNumColumns(), numClasses, weights, biases, logits + begin * numClasses, getBestGradientKernel());
+    }
+}
+
+void axpy(size_t n, double a, const double* x, double* y)
+{
+    for(size_t j = 0; j < n; j++)
+    {
+        y[j] += a * x[j];
+    }
+}
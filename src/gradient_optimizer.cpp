@@ -0,0 +1,146 @@
+#include "gradient_optimizer.hpp"
+#include <algorithm>
+#include <cmath>
+
+StepDecaySchedule::StepDecaySchedule(size_t stepSize, double factor)
+{
+    m_stepSize = (stepSize > 0) ? stepSize : 1;
+    m_factor = factor;
+}
+
+double StepDecaySchedule::getLearningRate(double initialRate, size_t iteration) const
+{
+    return initialRate * pow(m_factor, double(iteration / m_stepSize));
+}
+
+CosineSchedule::CosineSchedule(size_t period, double minFraction)
+{
+    m_period = (period > 0) ? period : 1;
+    m_minFraction = minFraction;
+}
+
+double CosineSchedule::getLearningRate(double initialRate, size_t iteration) const
+{
+    double progress = double(std::min(iteration, m_period)) / m_period;
+    double minRate = m_minFraction * initialRate;
+    return minRate + 0.5 * (initialRate - minRate) * (1 + cos(M_PI * progress));
+}
+
+InverseTimeSchedule::InverseTimeSchedule(double decay)
+{
+    m_decay = decay;
+}
+
+double InverseTimeSchedule::getLearningRate(double initialRate, size_t iteration) const
+{
+    return initialRate / (1 + m_decay * iteration);
+}
+
+SGDOptimizer::SGDOptimizer()
+{
+    m_numParameters = 0;
+}
+
+const char* SGDOptimizer::getName() const
+{
+    return "SGD";
+}
+
+void SGDOptimizer::reset(size_t numParameters)
+{
+    m_numParameters = numParameters;
+}
+
+void SGDOptimizer::computeIncrements(const double* gradient, double learningRate, size_t /*iteration*/, double* increments)
+{
+    for(size_t k = 0; k < m_numParameters; k++)
+    {
+        increments[k] = -learningRate * gradient[k];
+    }
+}
+
+MomentumOptimizer::MomentumOptimizer(double momentum, bool nesterov)
+{
+    m_momentum = momentum;
+    m_nesterov = nesterov;
+}
+
+const char* MomentumOptimizer::getName() const
+{
+    return m_nesterov ? "NESTEROV" : "MOMENTUM";
+}
+
+void MomentumOptimizer::reset(size_t numParameters)
+{
+    m_velocity.assign(numParameters, 0);
+}
+
+void MomentumOptimizer::computeIncrements(const double* gradient, double learningRate, size_t /*iteration*/, double* increments)
+{
+    for(size_t k = 0; k < m_velocity.size(); k++)
+    {
+        double step = -learningRate * gradient[k];
+        m_velocity[k] = m_momentum * m_velocity[k] + step;
+        increments[k] = m_nesterov ? (m_momentum * m_velocity[k] + step) : m_velocity[k];
+    }
+}
+
+AdamOptimizer::AdamOptimizer(double beta1, double beta2, double epsilon)
+{
+    m_beta1 = beta1;
+    m_beta2 = beta2;
+    m_epsilon = epsilon;
+}
+
+const char* AdamOptimizer::getName() const
+{
+    return "ADAM";
+}
+
+void AdamOptimizer::reset(size_t numParameters)
+{
+    m_firstMoment.assign(numParameters, 0);
+    m_secondMoment.assign(numParameters, 0);
+}
+
+void AdamOptimizer::computeIncrements(const double* gradient, double learningRate, size_t iteration, double* increments)
+{
+    // The moving averages start from 0, and are corrected for that bias.
+    double t = double(iteration + 1);
+    double correction1 = 1 - pow(m_beta1, t);
+    double correction2 = 1 - pow(m_beta2, t);
+    for(size_t k = 0; k < m_firstMoment.size(); k++)
+    {
+        double g = gradient[k];
+        m_firstMoment[k] = m_beta1 * m_firstMoment[k] + (1 - m_beta1) * g;
+        m_secondMoment[k] = m_beta2 * m_secondMoment[k] + (1 - m_beta2) * g * g;
+        double m = m_firstMoment[k] / correction1;
+        double v = m_secondMoment[k] / correction2;
+        increments[k] = -learningRate * m / (sqrt(v) + m_epsilon);
+    }
+}
+
+AdaGradOptimizer::AdaGradOptimizer(double epsilon)
+{
+    m_epsilon = epsilon;
+}
+
+const char* AdaGradOptimizer::getName() const
+{
+    return "ADAGRAD";
+}
+
+void AdaGradOptimizer::reset(size_t numParameters)
+{
+    m_squaredGradientSums.assign(numParameters, 0);
+}
+
+void AdaGradOptimizer::computeIncrements(const double* gradient, double learningRate, size_t /*iteration*/, double* increments)
+{
+    for(size_t k = 0; k < m_squaredGradientSums.size(); k++)
+    {
+        double g = gradient[k];
+        m_squaredGradientSums[k] += g * g;
+        increments[k] = -learningRate * g / (sqrt(m_squaredGradientSums[k]) + m_epsilon);
+    }
+}
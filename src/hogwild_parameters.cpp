@@ -0,0 +1,97 @@
+#include "hogwild_parameters.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+HogwildParameters::HogwildParameters(const double* weights, double bias, size_t numColumns, size_t numWorkers, size_t maxNumUpdates)
+:m_parameters(new std::atomic<double>[numColumns + 1]),
+m_latestIncrements(new WorkerIncrement[numWorkers])
+{
+    m_numParameters = numColumns + 1;
+    m_numWorkers = numWorkers;
+    m_maxNumUpdates = maxNumUpdates;
+    for(size_t k = 0; k < numColumns; k++)
+    {
+        m_parameters[k].store(weights[k], std::memory_order_relaxed);
+    }
+    m_parameters[numColumns].store(bias, std::memory_order_relaxed);
+    for(size_t w = 0; w < numWorkers; w++)
+    {
+        m_latestIncrements[w].value.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+    }
+    m_numClaimedUpdates.store(0, std::memory_order_relaxed);
+    m_isStopped.store(false, std::memory_order_relaxed);
+}
+
+size_t HogwildParameters::getNumParameters() const
+{
+    return m_numParameters;
+}
+
+size_t HogwildParameters::getNumWorkers() const
+{
+    return m_numWorkers;
+}
+
+void HogwildParameters::read(double* parameters) const
+{
+    for(size_t k = 0; k < m_numParameters; k++)
+    {
+        parameters[k] = m_parameters[k].load(std::memory_order_relaxed);
+    }
+}
+
+void HogwildParameters::add(const double* increments, size_t worker)
+{
+    double maxIncrement = 0;
+    for(size_t k = 0; k < m_numParameters; k++)
+    {
+        double value = m_parameters[k].load(std::memory_order_relaxed);
+        m_parameters[k].store(value + increments[k], std::memory_order_relaxed);
+        // (A NaN increment, from diverging updates, is kept.)
+        if(!(fabs(increments[k]) <= maxIncrement))
+        {
+            maxIncrement = fabs(increments[k]);
+        }
+    }
+    m_latestIncrements[worker].value.store(maxIncrement, std::memory_order_relaxed);
+}
+
+bool HogwildParameters::claimUpdate(size_t& update)
+{
+    if(m_isStopped.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    update = m_numClaimedUpdates.fetch_add(1, std::memory_order_relaxed);
+    return update < m_maxNumUpdates;
+}
+
+size_t HogwildParameters::getNumUpdates() const
+{
+    return std::min(m_numClaimedUpdates.load(std::memory_order_relaxed), m_maxNumUpdates);
+}
+
+double HogwildParameters::getMaxLatestIncrement() const
+{
+    double maxIncrement = 0;
+    for(size_t w = 0; w < m_numWorkers; w++)
+    {
+        double increment = m_latestIncrements[w].value.load(std::memory_order_relaxed);
+        if(!(increment <= maxIncrement))
+        {
+            maxIncrement = increment;
+        }
+    }
+    return maxIncrement;
+}
+
+void HogwildParameters::stop()
+{
+    m_isStopped.store(true, std::memory_order_relaxed);
+}
+
+bool HogwildParameters::isStopped() const
+{
+    return m_isStopped.load(std::memory_order_relaxed);
+}
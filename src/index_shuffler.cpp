@@ -1,38 +1,70 @@
 #include "index_shuffler.hpp"
-#include <cstdlib>
+#include <cassert>
 
 IndexShuffler::IndexShuffler()
 {
     m_indices = {};
-    m_doShuffle = false;
+    m_batchSize = 0;
+    m_position = 0;
+    m_epoch = 0;
 }
 
-IndexShuffler::IndexShuffler(size_t size, bool doShuffle)
+IndexShuffler::IndexShuffler(size_t size, size_t batchSize, uint64_t seed)
+:m_generator(seed)
 {
-    m_indices = {};
+    assert(batchSize <= size);
+    m_indices.resize(size);
     for(size_t i = 0; i < size; i++)
     {
-        m_indices.push_back(i);
+        m_indices[i] = i;
     }
-    m_doShuffle = doShuffle;
+    m_batchSize = (batchSize == 0) ? size : batchSize;
+    // In mini-batch mode, the first update starts the first epoch.
+    m_position = (m_batchSize == size) ? 0 : size;
+    m_epoch = 0;
 }
 
 void IndexShuffler::update()
 {
-    if(!m_doShuffle)
+    if(m_batchSize == m_indices.size())
     {
         return;
     }
-    for(size_t i = 0; i < m_indices.size(); i++)
+    m_position += m_batchSize;
+    if(m_position + m_batchSize > m_indices.size())
+    {
+        m_position = 0;
+        m_epoch++;
+    }
+    // Fisher-Yates steps for the positions of this batch only; every
+    // position gets a row drawn uniformly from the rows not yet drawn in
+    // this epoch.
+    size_t size = m_indices.size();
+    for(size_t k = m_position; k < m_position + m_batchSize; k++)
     {
-        size_t i2 = rand() % m_indices.size();
-        size_t temp = m_indices[i];
-        m_indices[i] = m_indices[i2];
-        m_indices[i2] = temp;
+        size_t k2 = k + m_generator.getBounded(size - k);
+        size_t temp = m_indices[k];
+        m_indices[k] = m_indices[k2];
+        m_indices[k2] = temp;
     }
 }
 
 size_t IndexShuffler::getIndex(size_t i)
 {
-    return m_indices[i];
-}
\ No newline at end of file
+    return m_indices[m_position + i];
+}
+
+const size_t* IndexShuffler::getIndices() const
+{
+    return m_indices.data() + m_position;
+}
+
+size_t IndexShuffler::getBatchSize() const
+{
+    return m_batchSize;
+}
+
+size_t IndexShuffler::getEpoch() const
+{
+    return m_epoch;
+}
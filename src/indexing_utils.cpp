@@ -9,7 +9,9 @@ ColumnSortFunctor::ColumnSortFunctor(const Matrix& X, size_t column)
 
 bool ColumnSortFunctor::operator()(const size_t& i, const size_t& j)
 {
-    const std::vector<std::vector<double> > data = m_pX->getData();
+    // A reference is taken here; copying the dataset on every comparison
+    // would make sorting prohibitively expensive.
+    const std::vector<std::vector<double> >& data = m_pX->getData();
     return data[i][m_column] < data[j][m_column];
 }
 
@@ -18,4 +20,14 @@ std::vector<size_t> getColumnSortedIndices(const Matrix& X, size_t column, const
     std::vector<size_t> indices = indicesToInspect;
     std::sort(indices.begin(), indices.end(), ColumnSortFunctor(X, column));
     return indices;
-}
\ No newline at end of file
+}
+
+std::vector<size_t> getColumnSortedIndices(const MatrixView& X, size_t column, const std::vector<size_t>& indicesToInspect)
+{
+    std::vector<size_t> indices = indicesToInspect;
+    std::sort(indices.begin(), indices.end(), [&](size_t i, size_t j)
+    {
+        return X(i, column) < X(j, column);
+    });
+    return indices;
+}
@@ -0,0 +1,273 @@
+#include "lbfgs_solver.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Strong Wolfe conditions, for a step t along a descent direction d:
+//   loss(x + t d) <= loss(x) + WOLFE_DECREASE * t * slope(0)
+//   |slope(t)| <= WOLFE_CURVATURE * |slope(0)|
+// where slope(t) is the derivative of loss(x + t d) with respect to t.
+static const double WOLFE_DECREASE = 1e-4;
+static const double WOLFE_CURVATURE = 0.9;
+
+const size_t LBFGSSolver::MAX_LINE_SEARCH_EVALUATIONS;
+
+static double getDot(const double* a, const double* b, size_t n)
+{
+    double dot = 0;
+    for(size_t k = 0; k < n; k++)
+    {
+        dot += a[k] * b[k];
+    }
+    return dot;
+}
+
+// Minimizer of the cubic that interpolates the losses and slopes at steps a
+// and b, if it lies well inside [a, b]; the midpoint otherwise.
+static double getCubicMinimizer(double a, double lossA, double slopeA, double b, double lossB, double slopeB)
+{
+    double midpoint = 0.5 * (a + b);
+    double d1 = slopeA + slopeB - 3 * (lossA - lossB) / (a - b);
+    double discriminant = d1 * d1 - slopeA * slopeB;
+    if(!(discriminant >= 0))
+    {
+        return midpoint;
+    }
+    double d2 = ((b > a) ? 1 : -1) * sqrt(discriminant);
+    double t = b - (b - a) * (slopeB + d2 - d1) / (slopeB - slopeA + 2 * d2);
+    // Keep away from the ends of the interval, so that it keeps shrinking.
+    double margin = 0.1 * fabs(b - a);
+    double low = std::min(a, b) + margin;
+    double high = std::max(a, b) - margin;
+    return (t >= low && t <= high) ? t : midpoint;
+}
+
+LBFGSSolver::LBFGSSolver(size_t historySize, size_t maxNumIterations, double tolerance)
+{
+    m_historySize = (historySize > 0) ? historySize : 1;
+    m_maxIterations = maxNumIterations;
+    m_tolerance = tolerance;
+    m_numParameters = 0;
+    m_numPairs = 0;
+    m_newestPair = 0;
+    m_iterationCount = 0;
+    m_numEvaluations = 0;
+    m_numLineSearchEvaluations = 0;
+    m_loss = 0;
+}
+
+size_t LBFGSSolver::getIterationCount() const
+{
+    return m_iterationCount;
+}
+
+size_t LBFGSSolver::getNumEvaluations() const
+{
+    return m_numEvaluations;
+}
+
+double LBFGSSolver::getTrainingLoss() const
+{
+    return m_loss;
+}
+
+double LBFGSSolver::evaluateTrialPoint(double step, double& slope)
+{
+    for(size_t k = 0; k < m_numParameters; k++)
+    {
+        m_trialPoint[k] = m_point[k] + step * m_direction[k];
+    }
+    double loss = evaluateObjective(m_trialPoint.data(), m_trialGradient.data());
+    m_numEvaluations++;
+    m_numLineSearchEvaluations++;
+    slope = getDot(m_trialGradient.data(), m_direction.data(), m_numParameters);
+    return loss;
+}
+
+void LBFGSSolver::computeDirection()
+{
+    // Two-loop recursion: direction = -H * gradient, where H approximates
+    // the inverse Hessian from the stored pairs, newest first.
+    size_t n = m_numParameters;
+    double* q = m_direction.data();
+    for(size_t k = 0; k < n; k++)
+    {
+        q[k] = -m_pointGradient[k];
+    }
+    if(m_numPairs == 0)
+    {
+        return;
+    }
+    for(size_t i = 0; i < m_numPairs; i++)
+    {
+        size_t pair = (m_newestPair + m_historySize - i) % m_historySize;
+        const double* s = &m_steps[pair * n];
+        const double* y = &m_gradientChanges[pair * n];
+        m_alphas[pair] = m_rhos[pair] * getDot(s, q, n);
+        for(size_t k = 0; k < n; k++)
+        {
+            q[k] -= m_alphas[pair] * y[k];
+        }
+    }
+    // Initial inverse Hessian: (s . y) / (y . y) of the newest pair, times I.
+    const double* newestY = &m_gradientChanges[m_newestPair * n];
+    double gamma = 1 / (m_rhos[m_newestPair] * getDot(newestY, newestY, n));
+    for(size_t k = 0; k < n; k++)
+    {
+        q[k] *= gamma;
+    }
+    for(size_t i = m_numPairs; i > 0; i--)
+    {
+        size_t pair = (m_newestPair + m_historySize - (i - 1)) % m_historySize;
+        const double* s = &m_steps[pair * n];
+        const double* y = &m_gradientChanges[pair * n];
+        double beta = m_rhos[pair] * getDot(y, q, n);
+        for(size_t k = 0; k < n; k++)
+        {
+            q[k] += (m_alphas[pair] - beta) * s[k];
+        }
+    }
+}
+
+bool LBFGSSolver::zoom(double loss, double slope, double lowStep, double lowLoss, double lowSlope, double highStep, double highLoss, double highSlope, double& trialLoss)
+{
+    // The interval between lowStep (the best step so far, satisfying the
+    // sufficient decrease condition) and highStep holds acceptable steps.
+    while(m_numLineSearchEvaluations < MAX_LINE_SEARCH_EVALUATIONS)
+    {
+        double step = getCubicMinimizer(lowStep, lowLoss, lowSlope, highStep, highLoss, highSlope);
+        double trialSlope;
+        trialLoss = evaluateTrialPoint(step, trialSlope);
+        if(!(trialLoss <= loss + WOLFE_DECREASE * step * slope) || trialLoss >= lowLoss)
+        {
+            highStep = step;
+            highLoss = trialLoss;
+            highSlope = trialSlope;
+            continue;
+        }
+        if(fabs(trialSlope) <= -WOLFE_CURVATURE * slope)
+        {
+            return true;
+        }
+        if(trialSlope * (highStep - lowStep) >= 0)
+        {
+            highStep = lowStep;
+            highLoss = lowLoss;
+            highSlope = lowSlope;
+        }
+        lowStep = step;
+        lowLoss = trialLoss;
+        lowSlope = trialSlope;
+    }
+    return false;
+}
+
+bool LBFGSSolver::searchLine(double loss, double slope, double step, double& trialLoss)
+{
+    m_numLineSearchEvaluations = 0;
+    double previousStep = 0;
+    double previousLoss = loss;
+    double previousSlope = slope;
+    while(m_numLineSearchEvaluations < MAX_LINE_SEARCH_EVALUATIONS)
+    {
+        double trialSlope;
+        trialLoss = evaluateTrialPoint(step, trialSlope);
+        if(!(trialLoss <= loss + WOLFE_DECREASE * step * slope) || (previousStep > 0 && trialLoss >= previousLoss))
+        {
+            return zoom(loss, slope, previousStep, previousLoss, previousSlope, step, trialLoss, trialSlope, trialLoss);
+        }
+        if(fabs(trialSlope) <= -WOLFE_CURVATURE * slope)
+        {
+            return true;
+        }
+        if(trialSlope >= 0)
+        {
+            return zoom(loss, slope, step, trialLoss, trialSlope, previousStep, previousLoss, previousSlope, trialLoss);
+        }
+        previousStep = step;
+        previousLoss = trialLoss;
+        previousSlope = trialSlope;
+        step *= 2;
+    }
+    return false;
+}
+
+void LBFGSSolver::minimize(size_t numColumns)
+{
+    size_t n = numColumns + 1;
+    m_numParameters = n;
+    m_point.assign(n, 0);
+    m_pointGradient.assign(n, 0);
+    m_direction.assign(n, 0);
+    m_trialPoint.assign(n, 0);
+    m_trialGradient.assign(n, 0);
+    m_steps.assign(m_historySize * n, 0);
+    m_gradientChanges.assign(m_historySize * n, 0);
+    m_rhos.assign(m_historySize, 0);
+    m_alphas.assign(m_historySize, 0);
+    m_numPairs = 0;
+    m_newestPair = 0;
+    m_iterationCount = 0;
+
+    m_loss = evaluateObjective(m_point.data(), m_pointGradient.data());
+    m_numEvaluations = 1;
+    while(m_iterationCount < m_maxIterations)
+    {
+        double gradientNorm = 0;
+        for(size_t k = 0; k < n; k++)
+        {
+            gradientNorm = std::max(gradientNorm, fabs(m_pointGradient[k]));
+        }
+        if(!(gradientNorm > m_tolerance))
+        {
+            break;
+        }
+        computeDirection();
+        double slope = getDot(m_pointGradient.data(), m_direction.data(), n);
+        if(!(slope < 0))
+        {
+            // Not a descent direction (from a poor approximation): restart
+            // from steepest descent.
+            m_numPairs = 0;
+            computeDirection();
+            slope = getDot(m_pointGradient.data(), m_direction.data(), n);
+        }
+        // The first step along the gradient moves the parameters by a unit
+        // distance; later on, the unit step of a Newton method is tried first.
+        double step = (m_numPairs > 0) ? 1 : 1 / sqrt(-slope);
+        double trialLoss;
+        if(!searchLine(m_loss, slope, step, trialLoss))
+        {
+            break;
+        }
+        // New pair: s = trial - point, y = trialGradient - pointGradient.
+        size_t pair = (m_numPairs > 0) ? (m_newestPair + 1) % m_historySize : 0;
+        double* s = &m_steps[pair * n];
+        double* y = &m_gradientChanges[pair * n];
+        for(size_t k = 0; k < n; k++)
+        {
+            s[k] = m_trialPoint[k] - m_point[k];
+            y[k] = m_trialGradient[k] - m_pointGradient[k];
+        }
+        double curvature = getDot(s, y, n);
+        if(curvature > 0)
+        {
+            m_rhos[pair] = 1 / curvature;
+            m_newestPair = pair;
+            m_numPairs = std::min(m_numPairs + 1, m_historySize);
+        }
+        else if(m_numPairs == m_historySize)
+        {
+            // The slot held the oldest pair, which is lost.
+            m_numPairs--;
+        }
+        m_point.swap(m_trialPoint);
+        m_pointGradient.swap(m_trialGradient);
+        m_loss = trialLoss;
+        m_iterationCount++;
+    }
+
+    std::vector<double> weights(m_point.begin(), m_point.begin() + numColumns);
+    m_weights = Vector(weights);
+    m_bias = m_point[numColumns];
+    releaseTrainingData();
+}
@@ -8,9 +8,9 @@
 #include <iostream>
 #include <cmath>
 
-LinearRegressionGDSolver::LinearRegressionGDSolver(double learningRate, size_t numStochasticSamples, size_t maxNumIterations, double tolerance)
+LinearRegressionGDSolver::LinearRegressionGDSolver(double learningRate, size_t numStochasticSamples, size_t maxNumIterations, double tolerance, size_t numThreads)
 :GradientDescentSolver(maxNumIterations, tolerance),
-GradientDescentData(numStochasticSamples, learningRate)
+GradientDescentData(numStochasticSamples, learningRate, numThreads)
 {
 }
 
@@ -20,41 +20,90 @@ void LinearRegressionGDSolver::solve(const Matrix& X, const Vector& y)
     GradientDescentSolver::solve(X, y);
 }
 
+void LinearRegressionGDSolver::solve(const MatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+void LinearRegressionGDSolver::solve(const FloatMatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+void LinearRegressionGDSolver::solve(const CsrMatrix& X, const Vector& y)
+{
+    setData(X, y);
+    iterateSparse(X.getNumColumns());
+}
+
+void LinearRegressionGDSolver::solve(DataSource& source, size_t numEpochs, size_t chunkSize)
+{
+    beginStream(source.getNumColumns());
+    iterateStream(source, numEpochs, chunkSize);
+}
+
+void LinearRegressionGDSolver::partialFit(const Matrix& X, const Vector& y)
+{
+    iteratePartial(X.getNumColumns(), setPartialData(X, y));
+}
+
+void LinearRegressionGDSolver::partialFit(const MatrixView& X, const Vector& y)
+{
+    iteratePartial(X.getNumColumns(), setPartialData(X, y));
+}
+
+size_t LinearRegressionGDSolver::setChunk(const DataChunk& chunk)
+{
+    return setChunkData(chunk.getView(), chunk.targets);
+}
+
+void LinearRegressionGDSolver::runAsyncWorker(HogwildParameters& parameters, size_t worker)
+{
+    runHogwildWorker(parameters, worker, GradientLoss::SQUARED_ERROR);
+}
+
+double LinearRegressionGDSolver::runSparseStep()
+{
+    return stepSparse(&m_weights[0], m_bias, m_iterationCount, GradientLoss::SQUARED_ERROR);
+}
+
+void LinearRegressionGDSolver::finishSparseSteps()
+{
+    applyWeightScale(&m_weights[0]);
+}
+
 void LinearRegressionGDSolver::evaluateIncrements()
 {
     m_indexer.update();
 
-    // error vector
-    std::vector<double> err = {};
-    for(size_t i = 0; i < m_numRows; i++)
-    {
-        size_t iActual = m_indexer.getIndex(i);
-        double sum = m_bias - m_py->getData()[iActual];
-        for(size_t j = 0; j < m_numColumns; j++)
-        {
-            sum += m_pX->getData()[iActual][j] * m_weights.getData()[j];
-        }
-        err.push_back(sum);
-    }
-    std::vector<double> dCdwVec = {};
-    for(size_t i = 0; i < m_numColumns; i++)
-    {
-        double sum = 0;
-        for(size_t j = 0; j < m_numRows; j++)
-        {
-            // sum += (X-transpose[i][indexer.getIndex(j)] times err[j])
-            // but X-transpose[i][indexer.getIndex(j)] = X[indexer.getIndex(j)][i]
-            sum += (m_pX->getData()[m_indexer.getIndex(j)][i] * err[j]);
-        }
-        dCdwVec.push_back(sum);
-    }
+    // A single pass over the sampled rows gives both dCdw * numRows, i.e.
+    // SUM(err[i] * Xsam[i]), and dCdb * numRows, i.e. SUM(err[i]), where
+    // err[i] = (bias + Xsam[i] . weights) - y[i].
+    double errSum = evaluateGradient(m_weights.getData().data(), m_bias, GradientLoss::SQUARED_ERROR);
 
     // Partial derivative of cost function w.r.t. weights: dCdw = Xsam-transpose * err / numRows
     // Xsam -> entire X or sampled X in case of stochastic gradient descent
-    // Increment in weights for gradient descent: dCdw * negative-learning-rate
-    m_weightIncrements = Vector(dCdwVec) * m_constMult;
-
     // Partial derivative of cost function w.r.t. bias: dCdb = SUM(err) / numRows
-    // Increment in bias for gradiant descent: dCdb * negative-learning-rate
-    m_biasIncrement = Vector(err).getSum() * m_constMult;
-}
\ No newline at end of file
+    // The increments (by default dCdw and dCdb times negative-learning-rate)
+    // are written in place, into the increments sized once by the solver.
+    m_biasIncrement = computeIncrements(errSum, m_iterationCount, &m_weightIncrements[0]);
+}
+
+double LinearRegressionGDSolver::evaluateTrainingLoss() const
+{
+    return evaluateLoss(m_weights.getData().data(), m_bias, GradientLoss::SQUARED_ERROR);
+}
+
+void LinearRegressionGDSolver::releaseTrainingData()
+{
+    clearDataReferences();
+}
+
+Vector LinearRegressionGDSolver::predict(const CsrMatrix& X) const
+{
+    std::vector<double> scores(X.getNumRows());
+    computeScores(X, m_weights.getData().data(), m_bias, scores.data());
+    return Vector(scores);
+}
@@ -0,0 +1,41 @@
+#include "linear_regression_LBFGS_solver.hpp"
+
+LinearRegressionLBFGSSolver::LinearRegressionLBFGSSolver(size_t historySize, size_t maxNumIterations, double tolerance, size_t numThreads)
+:LBFGSSolver(historySize, maxNumIterations, tolerance),
+GradientDescentData(0, 1, numThreads)
+{
+}
+
+double LinearRegressionLBFGSSolver::evaluateObjective(const double* parameters, double* gradient)
+{
+    return evaluateLossAndGradient(parameters, GradientLoss::SQUARED_ERROR, gradient);
+}
+
+void LinearRegressionLBFGSSolver::releaseTrainingData()
+{
+    clearDataReferences();
+}
+
+void LinearRegressionLBFGSSolver::solve(const Matrix& X, const Vector& y)
+{
+    setData(X, y);
+    minimize(X.getNumColumns());
+}
+
+void LinearRegressionLBFGSSolver::solve(const MatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    minimize(X.getNumColumns());
+}
+
+void LinearRegressionLBFGSSolver::solve(const FloatMatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    minimize(X.getNumColumns());
+}
+
+void LinearRegressionLBFGSSolver::solve(const CsrMatrix& X, const Vector& y)
+{
+    setData(X, y);
+    minimize(X.getNumColumns());
+}
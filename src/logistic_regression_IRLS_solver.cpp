@@ -0,0 +1,198 @@
+#include "logistic_regression_IRLS_solver.hpp"
+#include "cholesky.hpp"
+#include "ml_functions.hpp"
+#include <algorithm>
+#include <cmath>
+
+const size_t LogisticRegressionIRLSSolver::GRAM_BLOCK_SIZE;
+
+LogisticRegressionIRLSSolver::LogisticRegressionIRLSSolver(double ridge, size_t maxNumIterations, double tolerance)
+:GradientDescentData(0, 1)
+{
+    m_ridge = ridge;
+    m_maxIterations = maxNumIterations;
+    m_tolerance = tolerance;
+    m_iterationCount = 0;
+    m_loss = 0;
+}
+
+size_t LogisticRegressionIRLSSolver::getIterationCount() const
+{
+    return m_iterationCount;
+}
+
+double LogisticRegressionIRLSSolver::getTrainingLoss() const
+{
+    return m_loss;
+}
+
+void LogisticRegressionIRLSSolver::solve(const Matrix& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+void LogisticRegressionIRLSSolver::solve(const MatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+void LogisticRegressionIRLSSolver::solve(const FloatMatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+double LogisticRegressionIRLSSolver::evaluateCost(const double* parameters) const
+{
+    double cost = evaluateLoss(parameters, parameters[m_numColumns], GradientLoss::LOGISTIC);
+    double squaredNorm = 0;
+    for(size_t j = 0; j < m_numColumns; j++)
+    {
+        squaredNorm += parameters[j] * parameters[j];
+    }
+    return cost + 0.5 * m_ridge * squaredNorm;
+}
+
+double LogisticRegressionIRLSSolver::evaluateNewtonSystem()
+{
+    return m_isFloatData ? evaluateNewtonSystem(m_floatX) : evaluateNewtonSystem(m_X);
+}
+
+template<typename T>
+double LogisticRegressionIRLSSolver::evaluateNewtonSystem(const BasicMatrixView<T>& X)
+{
+    size_t numRows = X.getNumRows();
+    size_t p = m_numColumns + 1;
+    const double* y = m_py->getData().data();
+    const double* weights = m_parameters.data();
+    double bias = m_parameters[m_numColumns];
+    std::fill(m_newtonGradient.begin(), m_newtonGradient.end(), 0);
+    std::fill(m_hessian.begin(), m_hessian.end(), 0);
+    double lossSum = 0;
+    for(size_t begin = 0; begin < numRows; begin += GRAM_BLOCK_SIZE)
+    {
+        size_t blockSize = std::min(GRAM_BLOCK_SIZE, numRows - begin);
+        for(size_t r = 0; r < blockSize; r++)
+        {
+            const T* xrow = X.getRow(begin + r);
+            double z = bias;
+            for(size_t j = 0; j < m_numColumns; j++)
+            {
+                z += xrow[j] * weights[j];
+            }
+            double yi = y[begin + r];
+            double probability = sigmoid(z);
+            double err = probability - yi;
+            double rowWeight = probability * (1 - probability);
+            lossSum += std::max(z, 0.0) + log1p(exp(-fabs(z))) - yi * z;
+            for(size_t j = 0; j < m_numColumns; j++)
+            {
+                m_newtonGradient[j] += err * xrow[j];
+                m_blockColumns[j * GRAM_BLOCK_SIZE + r] = xrow[j];
+                m_weightedBlockColumns[j * GRAM_BLOCK_SIZE + r] = rowWeight * xrow[j];
+            }
+            m_newtonGradient[m_numColumns] += err;
+            m_blockColumns[m_numColumns * GRAM_BLOCK_SIZE + r] = 1;
+            m_weightedBlockColumns[m_numColumns * GRAM_BLOCK_SIZE + r] = rowWeight;
+        }
+        // Lower triangle of the block's contribution to X-transpose * W * X.
+        for(size_t j = 0; j < p; j++)
+        {
+            const double* weightedColumn = &m_weightedBlockColumns[j * GRAM_BLOCK_SIZE];
+            double* hessianRow = &m_hessian[j * p];
+            for(size_t k = 0; k <= j; k++)
+            {
+                const double* column = &m_blockColumns[k * GRAM_BLOCK_SIZE];
+                double sum = 0;
+                for(size_t r = 0; r < blockSize; r++)
+                {
+                    sum += weightedColumn[r] * column[r];
+                }
+                hessianRow[k] += sum;
+            }
+        }
+    }
+    double squaredNorm = 0;
+    for(size_t j = 0; j < p; j++)
+    {
+        m_newtonGradient[j] /= numRows;
+        for(size_t k = 0; k <= j; k++)
+        {
+            m_hessian[j * p + k] /= numRows;
+        }
+    }
+    for(size_t j = 0; j < m_numColumns; j++)
+    {
+        m_newtonGradient[j] += m_ridge * weights[j];
+        m_hessian[j * p + j] += m_ridge;
+        squaredNorm += weights[j] * weights[j];
+    }
+    return lossSum / numRows + 0.5 * m_ridge * squaredNorm;
+}
+
+void LogisticRegressionIRLSSolver::iterate(size_t numColumns)
+{
+    size_t p = numColumns + 1;
+    m_parameters.assign(p, 0);
+    m_newtonGradient.assign(p, 0);
+    m_newtonStep.assign(p, 0);
+    m_trialParameters.assign(p, 0);
+    m_hessian.assign(p * p, 0);
+    m_blockColumns.assign(p * GRAM_BLOCK_SIZE, 0);
+    m_weightedBlockColumns.assign(p * GRAM_BLOCK_SIZE, 0);
+    m_iterationCount = 0;
+
+    m_loss = evaluateNewtonSystem();
+    while(m_iterationCount < m_maxIterations)
+    {
+        // Newton step: Hessian * step = -gradient
+        if(!choleskyDecompose(m_hessian.data(), p))
+        {
+            break;
+        }
+        for(size_t j = 0; j < p; j++)
+        {
+            m_newtonStep[j] = -m_newtonGradient[j];
+        }
+        choleskySolve(m_hessian.data(), p, m_newtonStep.data());
+        double slope = 0;
+        for(size_t j = 0; j < p; j++)
+        {
+            slope += m_newtonGradient[j] * m_newtonStep[j];
+        }
+        // -slope / 2 (half the squared Newton decrement) is the decrease of
+        // the cost expected from the step.
+        if(!(-0.5 * slope > m_tolerance))
+        {
+            break;
+        }
+        // Backtracking (Armijo) line search from the full Newton step.
+        double step = 1;
+        bool isStepFound = false;
+        for(size_t attempt = 0; attempt < 30 && !isStepFound; attempt++)
+        {
+            for(size_t j = 0; j < p; j++)
+            {
+                m_trialParameters[j] = m_parameters[j] + step * m_newtonStep[j];
+            }
+            double trialLoss = evaluateCost(m_trialParameters.data());
+            isStepFound = (trialLoss <= m_loss + 1e-4 * step * slope);
+            step *= 0.5;
+        }
+        if(!isStepFound)
+        {
+            break;
+        }
+        m_parameters.swap(m_trialParameters);
+        m_iterationCount++;
+        m_loss = evaluateNewtonSystem();
+    }
+
+    std::vector<double> weights(m_parameters.begin(), m_parameters.begin() + numColumns);
+    m_weights = Vector(weights);
+    m_bias = m_parameters[numColumns];
+    // The loss is kept in m_loss; the caller may free the training data.
+    clearDataReferences();
+}
@@ -0,0 +1,41 @@
+#include "logistic_regression_LBFGS_solver.hpp"
+
+LogisticRegressionLBFGSSolver::LogisticRegressionLBFGSSolver(size_t historySize, size_t maxNumIterations, double tolerance, size_t numThreads)
+:LBFGSSolver(historySize, maxNumIterations, tolerance),
+GradientDescentData(0, 1, numThreads)
+{
+}
+
+double LogisticRegressionLBFGSSolver::evaluateObjective(const double* parameters, double* gradient)
+{
+    return evaluateLossAndGradient(parameters, GradientLoss::LOGISTIC, gradient);
+}
+
+void LogisticRegressionLBFGSSolver::releaseTrainingData()
+{
+    clearDataReferences();
+}
+
+void LogisticRegressionLBFGSSolver::solve(const Matrix& X, const Vector& y)
+{
+    setData(X, y);
+    minimize(X.getNumColumns());
+}
+
+void LogisticRegressionLBFGSSolver::solve(const MatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    minimize(X.getNumColumns());
+}
+
+void LogisticRegressionLBFGSSolver::solve(const FloatMatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    minimize(X.getNumColumns());
+}
+
+void LogisticRegressionLBFGSSolver::solve(const CsrMatrix& X, const Vector& y)
+{
+    setData(X, y);
+    minimize(X.getNumColumns());
+}
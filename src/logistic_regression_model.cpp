@@ -0,0 +1,116 @@
+#include "logistic_regression_model.hpp"
+#include "ml_functions.hpp"
+#include "gradient_kernels.hpp"
+
+Vector LogisticRegressionModel::getProbability(const Matrix& X) const
+{
+    Vector temp = BaseSolver::predict(X);
+    std::vector<double> res = {};
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        res.push_back(sigmoid(temp.getData()[i]));
+    }
+    return Vector(res);
+}
+
+double LogisticRegressionModel::getProbability(const Vector& xrow) const
+{
+    return sigmoid(BaseSolver::predict(xrow));
+}
+
+Vector LogisticRegressionModel::predict(const Matrix& X) const
+{
+    Vector temp = getProbability(X);
+    std::vector<double> res = {};
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        bool isOne = (temp.getData()[i] > 0.5);
+        res.push_back(isOne ? 1 : 0);
+    }
+    return Vector(res);
+}
+
+double LogisticRegressionModel::predict(const Vector& xrow) const
+{
+    return (getProbability(xrow) > 0.5) ? 1 : 0;
+}
+
+void LogisticRegressionModel::solve(const Matrix& X, const std::vector<bool>& yB)
+{
+    std::vector<double> yvec = {};
+    for(size_t i = 0; i < yB.size(); i++)
+    {
+        yvec.push_back(yB[i] ? 1 : 0);
+    }
+    solve(X, Vector(yvec));
+}
+
+bool LogisticRegressionModel::predictB(const Vector& xrow) const
+{
+    return (getProbability(xrow) > 0.5);
+}
+
+std::vector<bool> LogisticRegressionModel::predictB(const Matrix& X) const
+{
+    std::vector<bool> res = {};
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        res.push_back(predictB(Vector(X.getData()[i])));
+    }
+    return res;
+}
+
+template<typename M>
+static std::vector<double> getProbabilities(const M& X, const Vector& weights, double bias)
+{
+    std::vector<double> probabilities(X.getNumRows());
+    computeScores(X, weights.getData().data(), bias, probabilities.data());
+    for(size_t i = 0; i < probabilities.size(); i++)
+    {
+        probabilities[i] = sigmoid(probabilities[i]);
+    }
+    return probabilities;
+}
+
+template<typename M>
+static std::vector<bool> getPredictions(const M& X, const Vector& weights, double bias)
+{
+    std::vector<double> scores(X.getNumRows());
+    computeScores(X, weights.getData().data(), bias, scores.data());
+    std::vector<bool> res(X.getNumRows());
+    for(size_t i = 0; i < scores.size(); i++)
+    {
+        res[i] = (sigmoid(scores[i]) > 0.5);
+    }
+    return res;
+}
+
+std::vector<double> LogisticRegressionModel::getProbability(const MatrixView& X) const
+{
+    return getProbabilities(X, m_weights, m_bias);
+}
+
+std::vector<double> LogisticRegressionModel::getProbability(const FloatMatrixView& X) const
+{
+    return getProbabilities(X, m_weights, m_bias);
+}
+
+std::vector<double> LogisticRegressionModel::getProbability(const CsrMatrix& X) const
+{
+    return getProbabilities(X, m_weights, m_bias);
+}
+
+std::vector<bool> LogisticRegressionModel::predictB(const MatrixView& X) const
+{
+    return getPredictions(X, m_weights, m_bias);
+}
+
+std::vector<bool> LogisticRegressionModel::predictB(const FloatMatrixView& X) const
+{
+    return getPredictions(X, m_weights, m_bias);
+}
+
+std::vector<bool> LogisticRegressionModel::predictB(const CsrMatrix& X) const
+{
+    return getPredictions(X, m_weights, m_bias);
+}
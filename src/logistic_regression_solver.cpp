@@ -1,111 +1,94 @@
 #include "logistic_regression_solver.hpp"
-#include "ml_functions.hpp"
 
-LogisticRegressionSolver::LogisticRegressionSolver(double learningRate, size_t numStochasticSamples, size_t maxNumIterations, double tolerance)
+LogisticRegressionSolver::LogisticRegressionSolver(double learningRate, size_t numStochasticSamples, size_t maxNumIterations, double tolerance, size_t numThreads)
 :GradientDescentSolver(maxNumIterations, tolerance),
-GradientDescentData(numStochasticSamples, learningRate)
+GradientDescentData(numStochasticSamples, learningRate, numThreads)
 {
 }
 
-void LogisticRegressionSolver::evaluateIncrements()
+void LogisticRegressionSolver::solve(DataSource& source, size_t numEpochs, size_t chunkSize)
 {
-    m_indexer.update();
+    beginStream(source.getNumColumns());
+    iterateStream(source, numEpochs, chunkSize);
+}
 
-    // error vector
-    std::vector<double> err = {};
-    for(size_t i = 0; i < m_numRows; i++)
-    {
-        size_t iActual = m_indexer.getIndex(i);
-        double sum = m_bias;// - m_py->getData()[iActual];
-        for(size_t j = 0; j < m_numColumns; j++)
-        {
-            sum += m_pX->getData()[iActual][j] * m_weights.getData()[j];
-        }
-        err.push_back(sigmoid(sum) - m_py->getData()[iActual]);
-    }
-    std::vector<double> dCdwVec = {};
-    for(size_t i = 0; i < m_numColumns; i++)
-    {
-        double sum = 0;
-        for(size_t j = 0; j < m_numRows; j++)
-        {
-            // sum += (X-transpose[i][indexer.getIndex(j)] times err[j])
-            // but X-transpose[i][indexer.getIndex(j)] = X[indexer.getIndex(j)][i]
-            sum += (m_pX->getData()[m_indexer.getIndex(j)][i] * err[j]);
-        }
-        dCdwVec.push_back(sum);
-    }
+void LogisticRegressionSolver::partialFit(const Matrix& X, const Vector& y)
+{
+    iteratePartial(X.getNumColumns(), setPartialData(X, y));
+}
 
-    // Partial derivative of cost function w.r.t. weights: dCdw = Xsam-transpose * err / numRows
-    // Xsam -> entire X or sampled X in case of stochastic gradient descent
-    // Increment in weights for gradient descent: dCdw * negative-learning-rate
-    m_weightIncrements = Vector(dCdwVec) * m_constMult;
+void LogisticRegressionSolver::partialFit(const MatrixView& X, const Vector& y)
+{
+    iteratePartial(X.getNumColumns(), setPartialData(X, y));
+}
 
-    // Partial derivative of cost function w.r.t. bias: dCdb = SUM(err) / numRows
-    // Increment in bias for gradiant descent: dCdb * negative-learning-rate
-    m_biasIncrement = Vector(err).getSum() * m_constMult;
+size_t LogisticRegressionSolver::setChunk(const DataChunk& chunk)
+{
+    return setChunkData(chunk.getView(), chunk.targets);
 }
 
-void LogisticRegressionSolver::solve(const Matrix& X, const Vector& y)
+void LogisticRegressionSolver::runAsyncWorker(HogwildParameters& parameters, size_t worker)
 {
-    setData(X, y);
-    GradientDescentSolver::solve(X, y);
+    runHogwildWorker(parameters, worker, GradientLoss::LOGISTIC);
+}
+
+double LogisticRegressionSolver::runSparseStep()
+{
+    return stepSparse(&m_weights[0], m_bias, m_iterationCount, GradientLoss::LOGISTIC);
 }
 
-Vector LogisticRegressionSolver::getProbability(const Matrix& X) const
+void LogisticRegressionSolver::finishSparseSteps()
 {
-    Vector temp = BaseSolver::predict(X);
-    std::vector<double> res = {};
-    for(size_t i = 0; i < X.getNumRows(); i++)
-    {
-        res.push_back(sigmoid(temp.getData()[i]));
-    }
-    return Vector(res);
+    applyWeightScale(&m_weights[0]);
 }
 
-double LogisticRegressionSolver::getProbability(const Vector& xrow) const
+void LogisticRegressionSolver::evaluateIncrements()
 {
-    return sigmoid(BaseSolver::predict(xrow));
+    m_indexer.update();
+
+    // A single pass over the sampled rows gives both dCdw * numRows, i.e.
+    // SUM(err[i] * Xsam[i]), and dCdb * numRows, i.e. SUM(err[i]), where
+    // err[i] = sigmoid(bias + Xsam[i] . weights) - y[i].
+    double errSum = evaluateGradient(m_weights.getData().data(), m_bias, GradientLoss::LOGISTIC);
+
+    // Partial derivative of cost function w.r.t. weights: dCdw = Xsam-transpose * err / numRows
+    // Xsam -> entire X or sampled X in case of stochastic gradient descent
+    // Partial derivative of cost function w.r.t. bias: dCdb = SUM(err) / numRows
+    // The increments (by default dCdw and dCdb times negative-learning-rate)
+    // are written in place, into the increments sized once by the solver.
+    m_biasIncrement = computeIncrements(errSum, m_iterationCount, &m_weightIncrements[0]);
 }
 
-Vector LogisticRegressionSolver::predict(const Matrix& X) const
+double LogisticRegressionSolver::evaluateTrainingLoss() const
 {
-    Vector temp = getProbability(X);
-    std::vector<double> res = {};
-    for(size_t i = 0; i < X.getNumRows(); i++)
-    {
-        bool isOne = (temp.getData()[i] > 0.5);
-        res.push_back(isOne ? 1 : 0);
-    }
-    return Vector(res);
+    return evaluateLoss(m_weights.getData().data(), m_bias, GradientLoss::LOGISTIC);
 }
 
-double LogisticRegressionSolver::predict(const Vector& xrow) const
+void LogisticRegressionSolver::releaseTrainingData()
 {
-    return (getProbability(xrow) > 0.5) ? 1 : 0;
+    clearDataReferences();
 }
 
-void LogisticRegressionSolver::solve(const Matrix& X, const std::vector<bool>& yB)
+void LogisticRegressionSolver::solve(const Matrix& X, const Vector& y)
 {
-    std::vector<double> yvec = {};
-    for(size_t i = 0; i < yB.size(); i++)
-    {
-        yvec.push_back(yB[i] ? 1 : 0);
-    }
-    solve(X, Vector(yvec));
+    setData(X, y);
+    GradientDescentSolver::solve(X, y);
+}
+
+void LogisticRegressionSolver::solve(const MatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
 }
 
-bool LogisticRegressionSolver::predictB(const Vector& xrow) const
+void LogisticRegressionSolver::solve(const FloatMatrixView& X, const Vector& y)
 {
-    return (getProbability(xrow) > 0.5);
+    setData(X, y);
+    iterate(X.getNumColumns());
 }
 
-std::vector<bool> LogisticRegressionSolver::predictB(const Matrix& X) const
+void LogisticRegressionSolver::solve(const CsrMatrix& X, const Vector& y)
 {
-    std::vector<bool> res = {};
-    for(size_t i = 0; i < X.getNumRows(); i++)
-    {
-        res.push_back(predictB(Vector(X.getData()[i])));
-    }
-    return res;
-}
\ No newline at end of file
+    setData(X, y);
+    iterateSparse(X.getNumColumns());
+}
@@ -0,0 +1,210 @@
+#include "multiclass_logistic_regression_solver.hpp"
+#include "ml_functions.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+MulticlassLogisticRegressionSolver::MulticlassLogisticRegressionSolver(double learningRate, size_t numStochasticSamples, size_t maxNumIterations, double tolerance, size_t numThreads)
+:GradientDescentData(numStochasticSamples, learningRate, numThreads)
+{
+    m_loss = MulticlassLoss::SOFTMAX;
+    m_maxIterations = maxNumIterations;
+    m_tolerance = tolerance;
+    m_iterationCount = 0;
+    m_numClasses = 0;
+    m_trainingLoss = 0;
+}
+
+void MulticlassLogisticRegressionSolver::setMulticlassLoss(MulticlassLoss loss)
+{
+    m_loss = loss;
+}
+
+size_t MulticlassLogisticRegressionSolver::getNumClasses() const
+{
+    return m_numClasses;
+}
+
+size_t MulticlassLogisticRegressionSolver::getIterationCount() const
+{
+    return m_iterationCount;
+}
+
+std::vector<double> MulticlassLogisticRegressionSolver::getWeights() const
+{
+    return std::vector<double>(m_parameters.begin(), m_parameters.begin() + m_numColumns * m_numClasses);
+}
+
+std::vector<double> MulticlassLogisticRegressionSolver::getBiases() const
+{
+    return std::vector<double>(m_parameters.begin() + m_numColumns * m_numClasses, m_parameters.end());
+}
+
+void MulticlassLogisticRegressionSolver::solve(const Matrix& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+void MulticlassLogisticRegressionSolver::solve(const MatrixView& X, const Vector& y)
+{
+    setData(X, y);
+    iterate(X.getNumColumns());
+}
+
+double MulticlassLogisticRegressionSolver::evaluateMulticlassGradient()
+{
+    const double* y = m_py->getData().data();
+    const size_t* rows = m_indexer.getIndices();
+    const double* weights = m_parameters.data();
+    const double* biases = weights + m_numColumns * m_numClasses;
+    size_t numParameters = m_parameters.size();
+    auto evaluateChunk = [&](size_t c, size_t begin, size_t numChunkRows, double* gradient)
+    {
+        double* logits = &m_chunkLogits[c * MULTICLASS_BLOCK_SIZE * m_numClasses];
+        return computeMulticlassGradient(m_X, y, rows + begin, numChunkRows, m_numClasses, weights, biases, m_loss, logits, gradient, gradient + m_numColumns * m_numClasses);
+    };
+    return reduceChunks(m_chunkLosses.size(), numParameters, evaluateChunk, m_chunkParameterGradients.data(), m_chunkLosses.data(), m_multiclassGradient.data());
+}
+
+void MulticlassLogisticRegressionSolver::iterate(size_t numColumns)
+{
+    assert(!m_isFloatData && !m_isSparseData);
+    const double* y = m_py->getData().data();
+    double maxLabel = 0;
+    for(size_t i = 0; i < m_numDataRows; i++)
+    {
+        assert(y[i] >= 0 && y[i] == floor(y[i]));
+        maxLabel = std::max(maxLabel, y[i]);
+    }
+    m_numClasses = size_t(maxLabel) + 1;
+    size_t numWeights = numColumns * m_numClasses;
+    size_t numParameters = numWeights + m_numClasses;
+    size_t numChunks = (m_numRows + GRADIENT_CHUNK_SIZE - 1) / GRADIENT_CHUNK_SIZE;
+    m_parameters.assign(numParameters, 0);
+    m_multiclassGradient.assign(numParameters, 0);
+    m_increments.assign(numParameters, 0);
+    m_chunkParameterGradients.assign((numChunks > 1) ? numChunks * numParameters : 0, 0);
+    m_chunkLosses.assign(numChunks, 0);
+    m_chunkLogits.assign(numChunks * MULTICLASS_BLOCK_SIZE * m_numClasses, 0);
+    if(m_optimizer)
+    {
+        m_optimizer->reset(numParameters);
+    }
+    m_iterationCount = 0;
+
+    double maxIncrement = m_tolerance + 1;
+    while(maxIncrement > m_tolerance && m_iterationCount < m_maxIterations)
+    {
+        m_indexer.update();
+        evaluateMulticlassGradient();
+        if(m_l2Penalty > 0)
+        {
+            axpy(numWeights, m_l2Penalty * m_numRows, m_parameters.data(), m_multiclassGradient.data());
+        }
+        double learningRate = m_schedule ? m_schedule->getLearningRate(m_learningRate, m_iterationCount) : m_learningRate;
+        if(m_optimizer)
+        {
+            for(size_t k = 0; k < numParameters; k++)
+            {
+                m_multiclassGradient[k] /= m_numRows;
+            }
+            m_optimizer->computeIncrements(m_multiclassGradient.data(), learningRate, m_iterationCount, m_increments.data());
+        }
+        else
+        {
+            double constMult = -learningRate / (1.0 * m_numRows);
+            for(size_t k = 0; k < numParameters; k++)
+            {
+                m_increments[k] = constMult * m_multiclassGradient[k];
+            }
+        }
+        maxIncrement = 0;
+        for(size_t k = 0; k < numParameters; k++)
+        {
+            m_parameters[k] += m_increments[k];
+            // (A NaN increment, from diverging iterations, stops them.)
+            maxIncrement = (fabs(m_increments[k]) <= maxIncrement) ? maxIncrement : fabs(m_increments[k]);
+        }
+        m_iterationCount++;
+    }
+    m_trainingLoss = evaluateTrainingLoss();
+    clearDataReferences();
+}
+
+double MulticlassLogisticRegressionSolver::getTrainingLoss() const
+{
+    return m_trainingLoss;
+}
+
+double MulticlassLogisticRegressionSolver::evaluateTrainingLoss() const
+{
+    const double* weights = m_parameters.data();
+    size_t numWeights = m_numColumns * m_numClasses;
+    double cost = computeMulticlassLoss(m_X, m_py->getData().data(), m_numClasses, weights, weights + numWeights, m_loss);
+    if(m_l2Penalty > 0)
+    {
+        double squaredNorm = 0;
+        for(size_t k = 0; k < numWeights; k++)
+        {
+            squaredNorm += weights[k] * weights[k];
+        }
+        cost += 0.5 * m_l2Penalty * squaredNorm;
+    }
+    return cost;
+}
+
+std::vector<double> MulticlassLogisticRegressionSolver::getProbabilities(const MatrixView& X) const
+{
+    assert(X.getNumColumns() == m_numColumns);
+    const double* weights = m_parameters.data();
+    std::vector<double> probabilities(X.getNumRows() * m_numClasses);
+    computeLogits(X, m_numClasses, weights, weights + m_numColumns * m_numClasses, probabilities.data());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        double* rowProbabilities = &probabilities[i * m_numClasses];
+        if(m_loss == MulticlassLoss::SOFTMAX)
+        {
+            double maxLogit = *std::max_element(rowProbabilities, rowProbabilities + m_numClasses);
+            double expSum = 0;
+            for(size_t k = 0; k < m_numClasses; k++)
+            {
+                rowProbabilities[k] = exp(rowProbabilities[k] - maxLogit);
+                expSum += rowProbabilities[k];
+            }
+            for(size_t k = 0; k < m_numClasses; k++)
+            {
+                rowProbabilities[k] /= expSum;
+            }
+        }
+        else
+        {
+            for(size_t k = 0; k < m_numClasses; k++)
+            {
+                rowProbabilities[k] = sigmoid(rowProbabilities[k]);
+            }
+        }
+    }
+    return probabilities;
+}
+
+std::vector<size_t> MulticlassLogisticRegressionSolver::predictClass(const MatrixView& X) const
+{
+    assert(X.getNumColumns() == m_numColumns);
+    const double* weights = m_parameters.data();
+    std::vector<double> logits(X.getNumRows() * m_numClasses);
+    computeLogits(X, m_numClasses, weights, weights + m_numColumns * m_numClasses, logits.data());
+    std::vector<size_t> classes(X.getNumRows());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        const double* rowLogits = &logits[i * m_numClasses];
+        classes[i] = size_t(std::max_element(rowLogits, rowLogits + m_numClasses) - rowLogits);
+    }
+    return classes;
+}
+
+std::vector<size_t> MulticlassLogisticRegressionSolver::predictClass(const Matrix& X) const
+{
+    DenseMatrix denseX(X);
+    return predictClass(denseX.getView());
+}
@@ -0,0 +1,171 @@
+#include "random_forest_regression_solver.hpp"
+#include "decision_tree_regression_solver.hpp"
+#include "binned_matrix.hpp"
+#include "dense_matrix.hpp"
+#include "indexing_utils.hpp"
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+RandomForestRegressionSolver::RandomForestRegressionSolver(size_t numTrees, size_t maxLeafSize, size_t numFeaturesPerSplit, size_t numThreads)
+{
+    assert(numTrees > 0);
+    m_numTrees = numTrees;
+    m_maxLeafSize = maxLeafSize;
+    m_numFeaturesPerSplit = numFeaturesPerSplit;
+    m_useHistograms = false;
+    m_seed = 0;
+    m_threadPool = std::make_shared<ThreadPool>(numThreads);
+}
+
+void RandomForestRegressionSolver::setHistogramMode(bool useHistograms)
+{
+    m_useHistograms = useHistograms;
+}
+
+void RandomForestRegressionSolver::setSeed(uint64_t seed)
+{
+    m_seed = seed;
+}
+
+size_t RandomForestRegressionSolver::getNumTrees() const
+{
+    return m_trees.size();
+}
+
+const DecisionTree& RandomForestRegressionSolver::getTree(size_t t) const
+{
+    return m_trees[t];
+}
+
+void RandomForestRegressionSolver::solve(const Matrix& X, const Vector& y)
+{
+    assert(y.size() > 0);
+    assert(y.size() == X.getNumRows());
+    size_t numRows = X.getNumRows();
+    size_t numColumns = X.getNumColumns();
+    size_t numFeaturesPerSplit = m_numFeaturesPerSplit;
+    if(numFeaturesPerSplit == 0)
+    {
+        numFeaturesPerSplit = (numColumns >= 3) ? (numColumns / 3) : 1;
+    }
+
+    // Preprocessing shared by all the trees.
+    DenseMatrix denseX(X);
+    MatrixView XView = denseX.getView();
+    std::vector<std::vector<size_t> > columnSortedIndices(numColumns);
+    BinnedMatrix Xb;
+    if(m_useHistograms)
+    {
+        Xb = BinnedMatrix(XView);
+    }
+    else
+    {
+        std::vector<size_t> indices(numRows);
+        for(size_t i = 0; i < numRows; i++)
+        {
+            indices[i] = i;
+        }
+        m_threadPool->parallelFor(numColumns, [&](size_t j)
+        {
+            columnSortedIndices[j] = getColumnSortedIndices(XView, j, indices);
+        });
+    }
+
+    m_trees.assign(m_numTrees, DecisionTree());
+    m_threadPool->parallelFor(m_numTrees, [&](size_t t)
+    {
+        // Each tree has a generator of its own, so the forest does not
+        // depend on the order in which the trees are trained.
+        std::mt19937_64 generator(m_seed + t);
+        std::uniform_int_distribution<size_t> distribution(0, numRows - 1);
+        std::vector<size_t> rows(numRows);
+        for(size_t i = 0; i < numRows; i++)
+        {
+            rows[i] = distribution(generator);
+        }
+        DecisionTreeRegressionSolver treeSolver(m_maxLeafSize);
+        treeSolver.setFeatureSubsampling(numFeaturesPerSplit, generator());
+        if(m_useHistograms)
+        {
+            treeSolver.solve(Xb, y, rows);
+        }
+        else
+        {
+            treeSolver.solve(XView, y, rows, columnSortedIndices);
+        }
+        m_trees[t] = treeSolver.getTree();
+    });
+}
+
+template<typename T>
+Vector RandomForestRegressionSolver::predictRows(const T* const* rows, size_t numRows) const
+{
+    assert(!m_trees.empty());
+    size_t numBlocks = (numRows + PREDICTION_BLOCK_SIZE - 1) / PREDICTION_BLOCK_SIZE;
+    std::vector<double> r(numRows, 0);
+    // A block of rows, small enough to stay in the cache, is run through
+    // all the trees, rather than running the whole dataset through one tree
+    // after another.
+    m_threadPool->parallelFor(numBlocks, [&](size_t b)
+    {
+        size_t iBegin = b * PREDICTION_BLOCK_SIZE;
+        size_t blockSize = std::min(numRows, iBegin + PREDICTION_BLOCK_SIZE) - iBegin;
+        double treeValues[PREDICTION_BLOCK_SIZE];
+        for(const auto& tree: m_trees)
+        {
+            tree.getValues(rows + iBegin, blockSize, treeValues);
+            for(size_t k = 0; k < blockSize; k++)
+            {
+                r[iBegin + k] += treeValues[k];
+            }
+        }
+        for(size_t k = 0; k < blockSize; k++)
+        {
+            r[iBegin + k] /= m_trees.size();
+        }
+    });
+    return Vector(r);
+}
+
+Vector RandomForestRegressionSolver::predict(const Matrix& X) const
+{
+    std::vector<const double*> rows(X.getNumRows());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        rows[i] = X.getData()[i].data();
+    }
+    return predictRows(rows.data(), rows.size());
+}
+
+Vector RandomForestRegressionSolver::predict(const MatrixView& X) const
+{
+    std::vector<const double*> rows(X.getNumRows());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        rows[i] = X.getRow(i);
+    }
+    return predictRows(rows.data(), rows.size());
+}
+
+Vector RandomForestRegressionSolver::predict(const FloatMatrixView& X) const
+{
+    std::vector<const float*> rows(X.getNumRows());
+    for(size_t i = 0; i < X.getNumRows(); i++)
+    {
+        rows[i] = X.getRow(i);
+    }
+    return predictRows(rows.data(), rows.size());
+}
+
+double RandomForestRegressionSolver::predict(const Vector& xrow) const
+{
+    assert(!m_trees.empty());
+    const double* x = xrow.getData().data();
+    double sum = 0;
+    for(const auto& tree: m_trees)
+    {
+        sum += tree.getValue(x);
+    }
+    return sum / m_trees.size();
+}
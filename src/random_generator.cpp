@@ -0,0 +1,94 @@
+#include "random_generator.hpp"
+#include <cassert>
+
+static inline uint64_t rotateLeft(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+RandomGenerator::RandomGenerator(uint64_t seed)
+{
+    // The state is filled by splitmix64, as recommended for xoshiro, so that
+    // similar seeds still give unrelated (and never all-zero) states.
+    for(size_t k = 0; k < 4; k++)
+    {
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        m_state[k] = z ^ (z >> 31);
+    }
+}
+
+uint64_t RandomGenerator::next()
+{
+    uint64_t result = rotateLeft(m_state[1] * 5, 7) * 9;
+    uint64_t t = m_state[1] << 17;
+    m_state[2] ^= m_state[0];
+    m_state[3] ^= m_state[1];
+    m_state[1] ^= m_state[2];
+    m_state[0] ^= m_state[3];
+    m_state[2] ^= t;
+    m_state[3] = rotateLeft(m_state[3], 45);
+    return result;
+}
+
+double RandomGenerator::getUniform()
+{
+    // The upper 53 bits fill the mantissa of a double.
+    return (next() >> 11) * 0x1.0p-53;
+}
+
+size_t RandomGenerator::getBounded(size_t n)
+{
+    assert(n > 0);
+    // Lemire's multiply-and-shift method: the upper half of next() * n is
+    // in [0, n); the few products whose lower half falls below
+    // (2^64 mod n) are rejected, which removes the bias.
+    unsigned __int128 product = (unsigned __int128)next() * n;
+    uint64_t low = uint64_t(product);
+    if(low < n)
+    {
+        uint64_t threshold = (0 - uint64_t(n)) % n;
+        while(low < threshold)
+        {
+            product = (unsigned __int128)next() * n;
+            low = uint64_t(product);
+        }
+    }
+    return size_t(product >> 64);
+}
+
+void RandomGenerator::jump()
+{
+    static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+    uint64_t state[4] = {0, 0, 0, 0};
+    for(size_t k = 0; k < 4; k++)
+    {
+        for(int b = 0; b < 64; b++)
+        {
+            if(JUMP[k] & (uint64_t(1) << b))
+            {
+                for(size_t s = 0; s < 4; s++)
+                {
+                    state[s] ^= m_state[s];
+                }
+            }
+            next();
+        }
+    }
+    for(size_t s = 0; s < 4; s++)
+    {
+        m_state[s] = state[s];
+    }
+}
+
+RandomGenerator RandomGenerator::getStream(size_t streamIndex) const
+{
+    RandomGenerator generator = *this;
+    for(size_t k = 0; k < streamIndex; k++)
+    {
+        generator.jump();
+    }
+    return generator;
+}
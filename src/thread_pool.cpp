@@ -0,0 +1,160 @@
+#include "thread_pool.hpp"
+#include <cassert>
+#include <chrono>
+
+// The pool and the queue that the current thread works from, if the
+// current thread is a worker of a pool.
+static thread_local const ThreadPool* t_pool = 0;
+static thread_local size_t t_queue = 0;
+
+TaskGroup::TaskGroup()
+{
+    m_numPendingTasks = 0;
+}
+
+ThreadPool::ThreadPool(size_t numThreads)
+{
+    m_numThreads = (numThreads > 0) ? numThreads : 1;
+    m_numQueuedTasks = 0;
+    m_stop = false;
+    for(size_t k = 0; k < m_numThreads; k++)
+    {
+        m_queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    }
+    for(size_t k = 1; k < m_numThreads; k++)
+    {
+        m_workers.push_back(std::thread(&ThreadPool::workerLoop, this, k));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_sleepCondition.notify_all();
+    for(auto& worker: m_workers)
+    {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::getNumThreads() const
+{
+    return m_numThreads;
+}
+
+size_t ThreadPool::getDefaultNumThreads()
+{
+    size_t numThreads = std::thread::hardware_concurrency();
+    return (numThreads > 0) ? numThreads : 1;
+}
+
+size_t ThreadPool::getCurrentQueue() const
+{
+    return (t_pool == this) ? t_queue : 0;
+}
+
+bool ThreadPool::popTask(size_t queue, Task& task)
+{
+    TaskQueue& taskQueue = *m_queues[queue];
+    std::lock_guard<std::mutex> lock(taskQueue.mutex);
+    if(taskQueue.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(taskQueue.tasks.back());
+    taskQueue.tasks.pop_back();
+    m_numQueuedTasks--;
+    return true;
+}
+
+bool ThreadPool::stealTask(size_t thiefQueue, Task& task)
+{
+    for(size_t k = 1; k < m_numThreads; k++)
+    {
+        TaskQueue& taskQueue = *m_queues[(thiefQueue + k) % m_numThreads];
+        std::lock_guard<std::mutex> lock(taskQueue.mutex);
+        if(!taskQueue.tasks.empty())
+        {
+            task = std::move(taskQueue.tasks.front());
+            taskQueue.tasks.pop_front();
+            m_numQueuedTasks--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::runPendingTask()
+{
+    Task task;
+    size_t queue = getCurrentQueue();
+    if(!popTask(queue, task) && !stealTask(queue, task))
+    {
+        return false;
+    }
+    task.function();
+    task.group->m_numPendingTasks--;
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t queue)
+{
+    t_pool = this;
+    t_queue = queue;
+    while(true)
+    {
+        if(runPendingTask())
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepCondition.wait(lock, [this](){ return m_stop || (m_numQueuedTasks > 0); });
+        if(m_stop)
+        {
+            return;
+        }
+    }
+}
+
+void ThreadPool::submit(TaskGroup& group, const std::function<void()>& task)
+{
+    group.m_numPendingTasks++;
+    TaskQueue& taskQueue = *m_queues[getCurrentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(taskQueue.mutex);
+        taskQueue.tasks.push_back({task, &group});
+        m_numQueuedTasks++;
+    }
+    if(m_numThreads > 1)
+    {
+        // Taking the lock makes sure that no worker is between checking
+        // the queued task count and going to sleep.
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_sleepCondition.notify_one();
+    }
+}
+
+void ThreadPool::wait(TaskGroup& group)
+{
+    while(group.m_numPendingTasks > 0)
+    {
+        if(!runPendingTask())
+        {
+            // The remaining tasks of the group are running on other threads.
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t numTasks, const std::function<void(size_t)>& task)
+{
+    TaskGroup group;
+    for(size_t k = 0; k < numTasks; k++)
+    {
+        submit(group, [&task, k](){ task(k); });
+    }
+    wait(group);
+}
@@ -0,0 +1,55 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every allocation made through the global operator new is counted, so
+// that tests can check that a piece of code does not allocate memory.
+// The single-object and array forms of new and delete (with the sized
+// deletes) are all replaced, so that they are matched by malloc and free.
+// They are defined in a translation unit of their own: where a replacement
+// delete is inlined into code that called the library's operator new, GCC
+// sees free called on memory from operator new, and warns of mismatched
+// allocation functions.
+
+static std::atomic<size_t> g_allocationCount(0);
+
+void* operator new(size_t size)
+{
+    g_allocationCount++;
+    void* p = malloc(size > 0 ? size : 1);
+    if(p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+size_t getAllocationCount()
+{
+    return g_allocationCount.load();
+}
@@ -2,13 +2,32 @@
 #include "linear_regression_analytical_solver.hpp"
 #include "linear_regression_GD_solver.hpp"
 #include "logistic_regression_solver.hpp"
+#include "linear_regression_LBFGS_solver.hpp"
+#include "logistic_regression_LBFGS_solver.hpp"
+#include "logistic_regression_IRLS_solver.hpp"
+#include "multiclass_logistic_regression_solver.hpp"
+#include "gradient_descent_sweep_solver.hpp"
+#include "cholesky.hpp"
 #include "decision_tree_regression_solver.hpp"
+#include "random_forest_regression_solver.hpp"
+#include "gradient_boosted_trees_solver.hpp"
+#include "dense_matrix.hpp"
+#include "csr_matrix.hpp"
+#include "data_source.hpp"
+#include "gradient_kernels.hpp"
+#include "gradient_optimizer.hpp"
+#include "index_shuffler.hpp"
+#include "random_generator.hpp"
 #include "matrix.hpp"
 #include "vectr.hpp"
 #include "random_quantities.hpp"
+#include "ml_functions.hpp"
 #include <iostream>
 #include <cmath>
 #include <cassert>
+#include <algorithm>
+#include <cstdio>
+#include <map>
 
 using namespace std;
 
@@ -153,7 +172,7 @@ void testLogisticRegression(size_t sampleSize=1000, size_t numFeatures=1)
     std::cout << getTableText(data, headers) << std::endl;
 }
 
-void testDecisionTreeRegression(size_t sampleSize=1000, size_t numFeatures=1)
+void testDecisionTreeRegression(size_t sampleSize=1000, size_t numFeatures=1, bool useHistograms=false)
 {
     // Prepare X and y data.
     // Data will be of the following pattern, like, for 2 dimensions (x1, x2):
@@ -189,6 +208,7 @@ void testDecisionTreeRegression(size_t sampleSize=1000, size_t numFeatures=1)
     Matrix X(Xdata);
     Vector y(ydata);
     DecisionTreeRegressionSolver DTSolver = DecisionTreeRegressionSolver(20, true);
+    DTSolver.setHistogramMode(useHistograms);
     DTSolver.solve(X, y);
     DTSolver.describeTree();
 
@@ -227,11 +247,1651 @@ void testDecisionTreeRegression(size_t sampleSize=1000, size_t numFeatures=1)
     cout << "Test MSE : " << getMeanSquareError(yTest, yTestPred) << endl;
 }
 
+// The tree built by several threads must be the same as the serial one.
+void testParallelDecisionTreeRegression(size_t sampleSize=25000, size_t numFeatures=4, size_t numThreads=4)
+{
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -3, 3);
+    vector<double> ydata = {};
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        double f = getRandom(-0.1, 0.1);
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            double xj = X.getData()[i][j];
+            f += (j + 1) * xj * xj;
+        }
+        ydata.push_back(f);
+    }
+    Vector y(ydata);
+    std::vector<std::vector<std::string> > data = {};
+    for(bool useHistograms: {false, true})
+    {
+        DecisionTreeRegressionSolver serialSolver(5);
+        DecisionTreeRegressionSolver parallelSolver(5);
+        serialSolver.setHistogramMode(useHistograms);
+        parallelSolver.setHistogramMode(useHistograms);
+        parallelSolver.setNumThreads(numThreads);
+        auto tStart = getMicroSeconds();
+        serialSolver.solve(X, y);
+        auto tMid = getMicroSeconds();
+        parallelSolver.solve(X, y);
+        auto tEnd = getMicroSeconds();
+        assert(serialSolver.getNodeCount() == parallelSolver.getNodeCount());
+        Vector ySerial = serialSolver.predict(X);
+        Vector yParallel = parallelSolver.predict(X);
+        for(size_t i = 0; i < sampleSize; i++)
+        {
+            assert(ySerial[i] == yParallel[i]);
+        }
+        std::string mode = useHistograms ? "HISTOGRAM" : "EXACT";
+        data.push_back({mode, std::to_string(serialSolver.getNodeCount()), std::to_string((tMid - tStart) / 1000.0), std::to_string((tEnd - tMid) / 1000.0)});
+    }
+    std::vector<std::string> headers = {"", "NODES", "SERIAL (ms)", std::to_string(numThreads) + " THREADS (ms)"};
+    std::cout << std::endl << "Parallel decision tree test" << std::endl << getTableText(data, headers) << std::endl;
+}
+
+// Data of the pattern used in testDecisionTreeRegression:
+// y = SUM(a[j] * x[j] * x[j] + c[j] * x[j]) + e + noise
+void getQuadraticRegressionData(size_t sampleSize, const Vector& constsA, const Vector& constsC, double constE, double noise, Matrix& X, Vector& y)
+{
+    size_t numFeatures = constsA.size();
+    X = getRandomMatrix(sampleSize, numFeatures, -3, 3);
+    vector<double> ydata = {};
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        double f = constE + getRandom(-noise, noise);
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            double xj = X.getData()[i][j];
+            f += (constsA[j] * xj * xj + constsC[j] * xj);
+        }
+        ydata.push_back(f);
+    }
+    y = Vector(ydata);
+}
+
+void testLevelWiseDecisionTree(size_t sampleSize=20000, size_t numFeatures=4, size_t maxNumLeaves=64)
+{
+    Vector constsA = getRandomVector(numFeatures, -1, 1);
+    Vector constsC = getRandomVector(numFeatures, -1, 1);
+    Matrix X, XTest;
+    Vector y, yTest;
+    getQuadraticRegressionData(sampleSize, constsA, constsC, 0, 0.1, X, y);
+    getQuadraticRegressionData(1000, constsA, constsC, 0, 0, XTest, yTest);
+    std::vector<std::vector<std::string> > data = {};
+    for(bool useHistograms: {false, true})
+    {
+        std::string mode = useHistograms ? "HISTOGRAM" : "EXACT";
+        DecisionTreeRegressionSolver depthFirstSolver(5);
+        DecisionTreeRegressionSolver levelWiseSolver(5);
+        DecisionTreeRegressionSolver budgetSolver(5);
+        depthFirstSolver.setHistogramMode(useHistograms);
+        levelWiseSolver.setHistogramMode(useHistograms);
+        budgetSolver.setHistogramMode(useHistograms);
+        levelWiseSolver.setLevelWiseGrowth(true);
+        budgetSolver.setLevelWiseGrowth(true, maxNumLeaves);
+        budgetSolver.setMaxDepth(8);
+        std::vector<std::pair<std::string, DecisionTreeRegressionSolver*> > solvers = {
+            {mode + " DEPTH-FIRST", &depthFirstSolver},
+            {mode + " LEVEL-WISE", &levelWiseSolver},
+            {mode + " LEVEL-WISE (" + std::to_string(maxNumLeaves) + " LEAVES)", &budgetSolver}};
+        for(auto& solver: solvers)
+        {
+            auto tStart = getMicroSeconds();
+            solver.second->solve(X, y);
+            auto tEnd = getMicroSeconds();
+            // The training predictions are those of the tree.
+            Vector yPred = solver.second->predict(X);
+            for(size_t i = 0; i < sampleSize; i++)
+            {
+                assert(yPred[i] == solver.second->getTrainingPredictions()[i]);
+            }
+            double testError = getMeanSquareError(yTest, solver.second->predict(XTest));
+            data.push_back({solver.first, std::to_string(solver.second->getNodeCount()), std::to_string(testError), std::to_string((tEnd - tStart) / 1000.0)});
+        }
+        // Both growth orders partition the rows the same way (up to rounding,
+        // which may resolve ties between columns differently).
+        assert(levelWiseSolver.getNodeCount() == depthFirstSolver.getNodeCount());
+        for(size_t i = 0; i < sampleSize; i++)
+        {
+            assert(std::abs(levelWiseSolver.getTrainingPredictions()[i] - depthFirstSolver.getTrainingPredictions()[i]) < 1e-6);
+        }
+        assert((budgetSolver.getNodeCount() + 1) / 2 <= maxNumLeaves);
+        assert(budgetSolver.getNodeCount() == budgetSolver.getTree().getNumNodes());
+    }
+    std::vector<std::string> headers = {"", "NODES", "TEST MSE", "TIME (ms)"};
+    std::cout << std::endl << "Level-wise decision tree test" << std::endl << getTableText(data, headers) << std::endl;
+}
+
+// Depth-first histogram trees, with the nodes below various sizes searching
+// their splits from their rows rather than from histograms; the fastest
+// setting gives the crossover point (HISTOGRAM_MIN_ROWS).
+void testHistogramSmallNodes(size_t sampleSize=10000, size_t numFeatures=6)
+{
+    Vector constsA = getRandomVector(numFeatures, -1, 1);
+    Vector constsC = getRandomVector(numFeatures, -1, 1);
+    Matrix X;
+    Vector y;
+    getQuadraticRegressionData(sampleSize, constsA, constsC, 0, 0.5, X, y);
+    std::vector<std::vector<std::string> > data = {};
+    DecisionTreeRegressionSolver exactSolver(5);
+    auto tStart = getMicroSeconds();
+    exactSolver.solve(X, y);
+    auto tEnd = getMicroSeconds();
+    data.push_back({"EXACT", std::to_string(exactSolver.getNodeCount()), std::to_string((tEnd - tStart) / 1000.0)});
+    DecisionTreeRegressionSolver referenceSolver(5);
+    referenceSolver.setHistogramMode(true);
+    referenceSolver.setHistogramMinRows(0);
+    referenceSolver.solve(X, y);
+    for(size_t histogramMinRows: {size_t(0), size_t(16), size_t(32), size_t(64), size_t(256), size_t(1024), sampleSize + 1})
+    {
+        DecisionTreeRegressionSolver solver(5);
+        solver.setHistogramMode(true);
+        solver.setHistogramMinRows(histogramMinRows);
+        tStart = getMicroSeconds();
+        solver.solve(X, y);
+        tEnd = getMicroSeconds();
+        // The same splits, up to rounding (which may resolve ties between
+        // columns differently).
+        assert(solver.getNodeCount() == referenceSolver.getNodeCount());
+        for(size_t i = 0; i < sampleSize; i++)
+        {
+            assert(std::abs(solver.getTrainingPredictions()[i] - referenceSolver.getTrainingPredictions()[i]) < 1e-6);
+        }
+        std::string name = (histogramMinRows > sampleSize) ? "HISTOGRAM (NO HISTOGRAMS)" : "HISTOGRAM (MIN ROWS " + std::to_string(histogramMinRows) + ")";
+        data.push_back({name, std::to_string(solver.getNodeCount()), std::to_string((tEnd - tStart) / 1000.0)});
+    }
+    std::vector<std::string> headers = {"", "NODES", "TIME (ms)"};
+    std::cout << std::endl << "Histogram trees: small nodes without histograms" << std::endl << getTableText(data, headers) << std::endl;
+}
+
+void testTreePredictionThroughput(size_t trainSize=20000, size_t sampleSize=200000, size_t numFeatures=8)
+{
+    Vector constsA = getRandomVector(numFeatures, -1, 1);
+    Vector constsC = getRandomVector(numFeatures, -1, 1);
+    Matrix X, XTest;
+    Vector y, yTest;
+    getQuadraticRegressionData(trainSize, constsA, constsC, 0, 0.1, X, y);
+    getQuadraticRegressionData(sampleSize, constsA, constsC, 0, 0, XTest, yTest);
+    DecisionTreeRegressionSolver DTSolver(1);
+    DTSolver.setHistogramMode(true);
+    DTSolver.solve(X, y);
+    const DecisionTree& tree = DTSolver.getTree();
+
+    // One row at a time, following the branches of the tree.
+    std::vector<double> yRowPred(sampleSize);
+    auto tStart = getMicroSeconds();
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        yRowPred[i] = tree.getValue(XTest.getData()[i].data());
+    }
+    auto tMid = getMicroSeconds();
+    // Batches of rows, advanced level by level.
+    Vector yBatchPred = DTSolver.predict(XTest);
+    auto tEnd = getMicroSeconds();
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        assert(yRowPred[i] == yBatchPred[i]);
+    }
+    auto getRowsPerSecond = [&](double microSeconds)
+    {
+        return std::to_string(size_t(sampleSize / (microSeconds / 1e6)));
+    };
+    std::vector<std::vector<std::string> > data = {
+        {"ROW BY ROW", getRowsPerSecond(tMid - tStart)},
+        {"BATCHED (" + std::to_string(DecisionTree::BATCH_SIZE) + " ROWS)", getRowsPerSecond(tEnd - tMid)}};
+    std::vector<std::string> headers = {"", "ROWS/SEC"};
+    std::cout << std::endl << "Tree prediction throughput test (" << DTSolver.getNodeCount() << " nodes)" << std::endl << getTableText(data, headers) << std::endl;
+}
+
+// Evaluates the source written by DecisionTree::getSource for the row x,
+// from the statement at lines[line]: either "return value;", or
+// "if(x[column] < value)" followed by the braced left branch, "else" and the
+// braced right branch. Any other statement fails an assertion.
+double evaluateTreeSource(const std::vector<std::string>& lines, size_t line, const std::vector<double>& x)
+{
+    std::string statement = lines[line].substr(lines[line].find_first_not_of(' '));
+    if(statement.compare(0, 7, "return ") == 0)
+    {
+        return strtod(statement.c_str() + 7, nullptr);
+    }
+    assert(statement.compare(0, 5, "if(x[") == 0);
+    size_t separator = statement.find("] < ");
+    assert(separator != std::string::npos);
+    size_t column = strtoul(statement.c_str() + 5, nullptr, 10);
+    double splitValue = strtod(statement.c_str() + separator + 4, nullptr);
+    assert(lines[line + 1].find('{') != std::string::npos);
+    if(x[column] < splitValue)
+    {
+        return evaluateTreeSource(lines, line + 2, x);
+    }
+    // Skips the left branch, up to its closing brace.
+    size_t depth = 1;
+    size_t end = line + 2;
+    for(; depth > 0; end++)
+    {
+        depth += (lines[end].find('{') != std::string::npos);
+        depth -= (lines[end].find('}') != std::string::npos);
+    }
+    assert(lines[end].find("else") != std::string::npos);
+    assert(lines[end + 1].find('{') != std::string::npos);
+    return evaluateTreeSource(lines, end + 2, x);
+}
+
+void testTreeSourceExport(size_t sampleSize=500, size_t numFeatures=3)
+{
+    Vector constsA = getRandomVector(numFeatures, -1, 1);
+    Vector constsC = getRandomVector(numFeatures, -1, 1);
+    Matrix X;
+    Vector y;
+    getQuadraticRegressionData(sampleSize, constsA, constsC, 0, 0.1, X, y);
+    DecisionTreeRegressionSolver DTSolver(10);
+    DTSolver.solve(X, y);
+    // The exported file can be compiled with: make tree TREE_SOURCE=DTTree.cpp
+    assert(DTSolver.exportSource("DTTree.cpp", "predict_tree"));
+    std::ifstream inFile("DTTree.cpp");
+    std::stringstream ss;
+    ss << inFile.rdbuf();
+    std::string source = ss.str();
+    assert(source.find("extern \"C\" double predict_tree(const double* x)") != std::string::npos);
+    // One return statement per leaf.
+    size_t numLeaves = 0;
+    for(size_t node = 0; node < DTSolver.getTree().getNumNodes(); node++)
+    {
+        numLeaves += DTSolver.getTree().isLeaf(node);
+    }
+    size_t numReturns = 0;
+    for(size_t pos = source.find("return "); pos != std::string::npos; pos = source.find("return ", pos + 1))
+    {
+        numReturns++;
+    }
+    assert(numReturns == numLeaves);
+    // The exported function predicts the training rows as the tree does
+    // (the constants are read back exactly).
+    std::vector<std::string> lines = {};
+    std::string line;
+    for(std::istringstream lineStream(source); std::getline(lineStream, line);)
+    {
+        lines.push_back(line);
+    }
+    size_t firstLine = std::find(lines.begin(), lines.end(), "{") - lines.begin() + 1;
+    assert(firstLine < lines.size());
+    Vector predictions = DTSolver.predict(X);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        assert(evaluateTreeSource(lines, firstLine, X.getData()[i]) == predictions[i]);
+    }
+    std::remove("DTTree.cpp");
+    std::cout << std::endl << "Tree source export test: " << numLeaves << " leaves, " << source.size() << " bytes of source, which predicts as the tree" << std::endl;
+}
+
+void testMatrixView(size_t sampleSize=200, size_t numFeatures=4)
+{
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -1, 1);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    DenseMatrix denseX(X);
+    MatrixView XView = denseX.getView();
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            assert(XView(i, j) == X.getData()[i][j]);
+        }
+    }
+    // A strided view of the leading columns, and a view of some rows.
+    MatrixView leadingColumns(denseX.getRow(0), sampleSize, numFeatures - 1, numFeatures);
+    MatrixView lastRows = XView.getRows(sampleSize - 10, sampleSize);
+    assert(leadingColumns(sampleSize - 1, numFeatures - 2) == X.getData()[sampleSize - 1][numFeatures - 2]);
+    assert(lastRows.getNumRows() == 10);
+    assert(lastRows(9, numFeatures - 1) == X.getData()[sampleSize - 1][numFeatures - 1]);
+
+    // Solving from a Matrix or from a view of the same data gives the same
+    // model, provided the random initial weights are the same.
+    LinearRegressionGDSolver matrixSolver(0.1, 0, 500, 1e-12);
+    LinearRegressionGDSolver viewSolver(0.1, 0, 500, 1e-12);
+    srand(1);
+    matrixSolver.solve(X, y);
+    srand(1);
+    viewSolver.solve(XView, y);
+    for(size_t j = 0; j < numFeatures; j++)
+    {
+        assert(matrixSolver.getWeights()[j] == viewSolver.getWeights()[j]);
+    }
+    assert(matrixSolver.getBias() == viewSolver.getBias());
+    DecisionTreeRegressionSolver matrixTreeSolver(5);
+    DecisionTreeRegressionSolver viewTreeSolver(5);
+    matrixTreeSolver.solve(X, y);
+    viewTreeSolver.solve(XView, y);
+    assert(matrixTreeSolver.getNodeCount() == viewTreeSolver.getNodeCount());
+    std::cout << std::endl << "Matrix view test: bias " << viewSolver.getBias() << " (expected 0.5)" << std::endl;
+    srand(time(NULL));
+}
+
+void testGradientKernels(size_t sampleSize=20000, size_t numFeatures=37, size_t numRepeats=20)
+{
+    // An odd number of features exercises the partial SIMD blocks.
+    DenseMatrix X(getRandomMatrix(sampleSize, numFeatures, -1, 1));
+    std::vector<double> y(sampleSize);
+    std::vector<size_t> rows(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        y[i] = (getRandom() < 0.5) ? 0 : 1;
+        rows[i] = i;
+    }
+    std::vector<double> weights = getRandomVector(numFeatures, -0.1, 0.1).getData();
+    std::vector<std::vector<std::string> > data = {};
+    for(GradientLoss loss: {GradientLoss::SQUARED_ERROR, GradientLoss::LOGISTIC})
+    {
+        std::vector<double> scalarGradient(numFeatures);
+        double scalarErrSum = computeGradient(X.getView(), y.data(), rows.data(), sampleSize, weights.data(), 0.1, loss, scalarGradient.data(), GradientKernel::SCALAR);
+        for(GradientKernel kernel: {GradientKernel::SCALAR, GradientKernel::AVX2, GradientKernel::AVX512})
+        {
+            if(!isGradientKernelSupported(kernel))
+            {
+                continue;
+            }
+            std::vector<double> gradient(numFeatures);
+            double errSum = 0;
+            auto tStart = getMicroSeconds();
+            for(size_t k = 0; k < numRepeats; k++)
+            {
+                errSum = computeGradient(X.getView(), y.data(), rows.data(), sampleSize, weights.data(), 0.1, loss, gradient.data(), kernel);
+            }
+            auto tEnd = getMicroSeconds();
+            assert(std::abs(errSum - scalarErrSum) < 1e-9 * sampleSize);
+            for(size_t j = 0; j < numFeatures; j++)
+            {
+                assert(std::abs(gradient[j] - scalarGradient[j]) < 1e-9 * sampleSize);
+            }
+            std::string lossName = (loss == GradientLoss::LOGISTIC) ? "LOGISTIC" : "SQUARED ERROR";
+            double rowsPerSecond = numRepeats * sampleSize / ((tEnd - tStart) / 1e6);
+            data.push_back({lossName, getGradientKernelName(kernel), std::to_string(size_t(rowsPerSecond))});
+        }
+    }
+    std::vector<std::string> headers = {"LOSS", "KERNEL", "ROWS/SEC"};
+    std::cout << std::endl << "Gradient kernel test (best: " << getGradientKernelName(getBestGradientKernel()) << ")" << std::endl << getTableText(data, headers) << std::endl;
+}
+
+void testSinglePrecision(size_t sampleSize=20000, size_t numFeatures=37, size_t numIterations=200)
+{
+    // Kernels: single precision agrees with double precision up to the
+    // rounding of the features and of the dot products.
+    DenseMatrix X(getRandomMatrix(sampleSize, numFeatures, -1, 1));
+    FloatDenseMatrix floatX(X.getView());
+    std::vector<double> y(sampleSize);
+    std::vector<size_t> rows(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        y[i] = (getRandom() < 0.5) ? 0 : 1;
+        rows[i] = i;
+    }
+    std::vector<double> weights = getRandomVector(numFeatures, -0.1, 0.1).getData();
+    std::vector<float> floatWeights(weights.begin(), weights.end());
+    std::vector<std::vector<std::string> > data = {};
+    for(GradientKernel kernel: {GradientKernel::SCALAR, GradientKernel::AVX2, GradientKernel::AVX512})
+    {
+        if(!isGradientKernelSupported(kernel))
+        {
+            continue;
+        }
+        std::vector<double> gradient(numFeatures);
+        std::vector<double> floatGradient(numFeatures);
+        auto tStart = getMicroSeconds();
+        double errSum = computeGradient(X.getView(), y.data(), rows.data(), sampleSize, weights.data(), 0.1, GradientLoss::LOGISTIC, gradient.data(), kernel);
+        auto tMiddle = getMicroSeconds();
+        double floatErrSum = computeGradient(floatX.getView(), y.data(), rows.data(), sampleSize, floatWeights.data(), 0.1, GradientLoss::LOGISTIC, floatGradient.data(), kernel);
+        auto tEnd = getMicroSeconds();
+        assert(std::abs(floatErrSum - errSum) < 1e-5 * sampleSize);
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            assert(std::abs(floatGradient[j] - gradient[j]) < 1e-5 * sampleSize);
+        }
+        double doubleRowsPerSecond = sampleSize / ((tMiddle - tStart) / 1e6);
+        double floatRowsPerSecond = sampleSize / ((tEnd - tMiddle) / 1e6);
+        data.push_back({"KERNEL", getGradientKernelName(kernel), std::to_string(size_t(doubleRowsPerSecond)), std::to_string(size_t(floatRowsPerSecond)), "", ""});
+    }
+
+    // The workloads of testLinearRegression and testLogisticRegression, with
+    // more rows, trained in both precisions from the same initial weights.
+    size_t numWorkloadFeatures = 5;
+    Matrix XLinear = getRandomMatrix(sampleSize, numWorkloadFeatures, -3, 3);
+    Vector yLinear = ((XLinear * getRandomVector(numWorkloadFeatures, -2, 2)) + getRandom()) + getRandomVector(sampleSize, -0.2, 0.2);
+    // (Normal components away from 0, as testLogisticRegression requires.)
+    Vector planePerp = getRandomVector(numWorkloadFeatures, 1, 3);
+    std::vector<std::vector<double> > XLogisticData = {};
+    std::vector<bool> yBLogistic = {};
+    getLogisticRegressionData(sampleSize, numWorkloadFeatures, planePerp, getRandom(0, 5), yBLogistic, XLogisticData);
+    Matrix XLogistic(XLogisticData);
+    for(bool isLogistic: {false, true})
+    {
+        std::vector<double> times = {};
+        std::vector<double> losses = {};
+        for(bool isSinglePrecision: {false, true})
+        {
+            std::shared_ptr<GradientDescentSolver> solver;
+            std::shared_ptr<LogisticRegressionSolver> logisticSolver;
+            if(isLogistic)
+            {
+                logisticSolver = std::make_shared<LogisticRegressionSolver>(1e-3, 0, numIterations, 0);
+                logisticSolver->setSinglePrecision(isSinglePrecision);
+                solver = logisticSolver;
+            }
+            else
+            {
+                auto linearSolver = std::make_shared<LinearRegressionGDSolver>(0.05, 0, numIterations, 0);
+                linearSolver->setSinglePrecision(isSinglePrecision);
+                solver = linearSolver;
+            }
+            srand(1);
+            auto tStart = getMicroSeconds();
+            if(isLogistic)
+            {
+                // (The targets are converted into a temporary Vector, which
+                // the solver must not read after solve returns.)
+                logisticSolver->solve(XLogistic, yBLogistic);
+            }
+            else
+            {
+                solver->solve(XLinear, yLinear);
+            }
+            auto tEnd = getMicroSeconds();
+            times.push_back((tEnd - tStart) / 1000.0);
+            losses.push_back(solver->getTrainingLoss());
+        }
+        assert(std::abs(losses[1] - losses[0]) < 1e-3 * losses[0]);
+        data.push_back({isLogistic ? "LOGISTIC" : "LINEAR", std::to_string(numIterations) + " ITERATIONS", std::to_string(times[0]), std::to_string(times[1]), std::to_string(losses[0]), std::to_string(losses[1])});
+    }
+
+    // Predictions from single precision rows.
+    LogisticRegressionIRLSSolver irlsSolver(1e-3);
+    irlsSolver.solve(XLogistic, yBLogistic);
+    FloatDenseMatrix floatXLogistic(XLogistic);
+    std::vector<bool> predictions = irlsSolver.predictB(XLogistic);
+    std::vector<bool> floatPredictions = irlsSolver.predictB(floatXLogistic.getView());
+    size_t numDifferences = 0;
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        numDifferences += (predictions[i] != floatPredictions[i]);
+    }
+    assert(numDifferences < sampleSize / 1000);
+    // Trees compare the single precision rows with their (double)
+    // split-values; only rows that are rounded across a split differ. (The
+    // split-values of exact mode are values of the training rows, so new
+    // rows are predicted.)
+    DecisionTreeRegressionSolver treeSolver;
+    treeSolver.setMaxDepth(8);
+    treeSolver.solve(XLinear, yLinear);
+    GradientBoostedTreesSolver GBSolver(50);
+    GBSolver.solve(XLinear, yLinear);
+    Matrix XTest = getRandomMatrix(sampleSize, numWorkloadFeatures, -3, 3);
+    DenseMatrix denseXTest(XTest);
+    FloatDenseMatrix floatXTest(XTest);
+    Vector treePredictions = treeSolver.predict(XTest);
+    Vector GBPredictions = GBSolver.predict(XTest);
+    Vector viewTreePredictions = treeSolver.predict(denseXTest.getView());
+    Vector viewGBPredictions = GBSolver.predict(denseXTest.getView());
+    Vector floatTreePredictions = treeSolver.predict(floatXTest.getView());
+    Vector floatGBPredictions = GBSolver.predict(floatXTest.getView());
+    size_t numTreeDifferences = 0;
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        assert(viewTreePredictions[i] == treePredictions[i]);
+        assert(viewGBPredictions[i] == GBPredictions[i]);
+        numTreeDifferences += (floatTreePredictions[i] != treePredictions[i]) || (floatGBPredictions[i] != GBPredictions[i]);
+    }
+    assert(numTreeDifferences < sampleSize / 1000);
+
+    std::vector<std::string> headers = {"", "", "FP64 (rows/s, ms)", "FP32 (rows/s, ms)", "FP64 LOSS", "FP32 LOSS"};
+    std::cout << std::endl << "Single precision test" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+void testParallelGradientDescent(size_t sampleSize=50000, size_t numFeatures=16, size_t numIterations=100, size_t numThreads=4)
+{
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -1, 1);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    std::vector<double> yBdata(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        yBdata[i] = (y[i] > 0.5) ? 1 : 0;
+    }
+    Vector yB(yBdata);
+    std::vector<std::vector<std::string> > data = {};
+    for(bool isLogistic: {false, true})
+    {
+        std::vector<double> times = {};
+        std::vector<std::vector<double> > solverWeights = {};
+        std::vector<double> biases = {};
+        for(size_t n: {size_t(1), numThreads})
+        {
+            std::shared_ptr<GradientDescentSolver> solver;
+            if(isLogistic)
+            {
+                solver = std::make_shared<LogisticRegressionSolver>(0.5, 0, numIterations, 0, n);
+            }
+            else
+            {
+                solver = std::make_shared<LinearRegressionGDSolver>(0.5, 0, numIterations, 0, n);
+            }
+            srand(1);
+            auto tStart = getMicroSeconds();
+            solver->solve(X, isLogistic ? yB : y);
+            auto tEnd = getMicroSeconds();
+            times.push_back((tEnd - tStart) / 1000.0);
+            solverWeights.push_back(solver->getWeights().getData());
+            biases.push_back(solver->getBias());
+        }
+        // The same chunks and reduction order, whatever the number of threads.
+        assert(solverWeights[0] == solverWeights[1]);
+        assert(biases[0] == biases[1]);
+        data.push_back({isLogistic ? "LOGISTIC" : "LINEAR", std::to_string(times[0]), std::to_string(times[1])});
+    }
+    std::vector<std::string> headers = {"", "1 THREAD (ms)", std::to_string(numThreads) + " THREADS (ms)"};
+    std::cout << std::endl << "Parallel gradient descent test (" << numIterations << " iterations)" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+// Solving with twice as many iterations must make exactly as many
+// allocations: all the memory is allocated before the first iteration.
+void testAllocationFreeGradientDescent(size_t sampleSize=10000, size_t numFeatures=8, size_t numIterations=50)
+{
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -1, 1);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    std::vector<double> yBdata(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        yBdata[i] = (y[i] > 0.5) ? 1 : 0;
+    }
+    Vector yB(yBdata);
+    std::vector<std::vector<std::string> > data = {};
+    for(bool isLogistic: {false, true})
+    {
+        for(size_t numStochasticSamples: {size_t(0), size_t(256)})
+        {
+            std::vector<size_t> allocationCounts = {};
+            for(size_t n: {numIterations, 2 * numIterations})
+            {
+                std::shared_ptr<GradientDescentSolver> solver;
+                if(isLogistic)
+                {
+                    solver = std::make_shared<LogisticRegressionSolver>(0.5, numStochasticSamples, n, 0);
+                }
+                else
+                {
+                    solver = std::make_shared<LinearRegressionGDSolver>(0.5, numStochasticSamples, n, 0);
+                }
+                srand(1);
+                size_t countBefore = getAllocationCount();
+                solver->solve(X, isLogistic ? yB : y);
+                allocationCounts.push_back(getAllocationCount() - countBefore);
+                assert(solver->getIterationCount() == n);
+            }
+            assert(allocationCounts[0] == allocationCounts[1]);
+            std::string batch = (numStochasticSamples > 0) ? std::to_string(numStochasticSamples) : "FULL";
+            data.push_back({isLogistic ? "LOGISTIC" : "LINEAR", batch, std::to_string(allocationCounts[0]), std::to_string(allocationCounts[1])});
+        }
+    }
+    std::vector<std::string> headers = {"", "BATCH", std::to_string(numIterations) + " ITERATIONS", std::to_string(2 * numIterations) + " ITERATIONS"};
+    std::cout << std::endl << "Allocations per solve" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+// Iterations and time to reach a target loss, for every optimizer. The
+// columns of X have different scales, which slows down plain gradient descent.
+void testGradientOptimizers(size_t sampleSize=5000, size_t numFeatures=10, size_t maxNumIterations=20000)
+{
+    // Seeded data; every solver also starts from the same seeded weights.
+    srand(1);
+    std::vector<std::vector<double> > XData = getRandomMatrix(sampleSize, numFeatures, -1, 1).getData();
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            XData[i][j] *= 0.1 + 0.3 * j;
+        }
+    }
+    Matrix X(XData);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    std::vector<double> yBdata(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        yBdata[i] = (y[i] > 0.5) ? 1 : 0;
+    }
+    Vector yB(yBdata);
+
+    struct OptimizerSetup
+    {
+        std::string name;
+        std::shared_ptr<GradientOptimizer> optimizer;
+        std::shared_ptr<LearningRateSchedule> schedule;
+        double learningRate;
+    };
+    std::vector<OptimizerSetup> setups = {
+        {"SGD", nullptr, nullptr, 0.3},
+        {"MOMENTUM", std::make_shared<MomentumOptimizer>(0.9), nullptr, 0.3},
+        {"NESTEROV", std::make_shared<MomentumOptimizer>(0.9, true), nullptr, 0.3},
+        {"NESTEROV + INVERSE-TIME", std::make_shared<MomentumOptimizer>(0.9, true), std::make_shared<InverseTimeSchedule>(1e-3), 0.3},
+        {"ADAM", std::make_shared<AdamOptimizer>(), nullptr, 0.1},
+        {"ADAM + COSINE", std::make_shared<AdamOptimizer>(), std::make_shared<CosineSchedule>(2000, 0.01), 0.1},
+        {"ADAM + STEP", std::make_shared<AdamOptimizer>(), std::make_shared<StepDecaySchedule>(500, 0.5), 0.1},
+        {"ADAGRAD", std::make_shared<AdaGradOptimizer>(), nullptr, 0.3}
+    };
+    std::vector<std::vector<std::string> > data = {};
+    for(bool isLogistic: {false, true})
+    {
+        double targetLoss = isLogistic ? 0.12 : 1e-4;
+        std::map<std::string, size_t> iterationCounts = {};
+        for(const OptimizerSetup& setup: setups)
+        {
+            std::shared_ptr<GradientDescentSolver> solver;
+            std::shared_ptr<GradientDescentData> solverData;
+            if(isLogistic)
+            {
+                auto logisticSolver = std::make_shared<LogisticRegressionSolver>(setup.learningRate, 0, maxNumIterations, 0);
+                solver = logisticSolver;
+                solverData = logisticSolver;
+            }
+            else
+            {
+                auto linearSolver = std::make_shared<LinearRegressionGDSolver>(setup.learningRate, 0, maxNumIterations, 0);
+                solver = linearSolver;
+                solverData = linearSolver;
+            }
+            solverData->setOptimizer(setup.optimizer);
+            solverData->setLearningRateSchedule(setup.schedule);
+            solver->setTargetLoss(targetLoss);
+            srand(1);
+            auto tStart = getMicroSeconds();
+            solver->solve(X, isLogistic ? yB : y);
+            auto tEnd = getMicroSeconds();
+            double loss = solver->getTrainingLoss();
+            assert(loss <= targetLoss);
+            iterationCounts[setup.name] = solver->getIterationCount();
+            data.push_back({isLogistic ? "LOGISTIC" : "LINEAR", setup.name, std::to_string(setup.learningRate), std::to_string(solver->getIterationCount()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(loss)});
+        }
+        // Adam needs far fewer iterations than plain gradient descent here.
+        assert(iterationCounts.at("ADAM") < iterationCounts.at("SGD"));
+    }
+    std::vector<std::string> headers = {"", "OPTIMIZER", "RATE", "ITERATIONS", "TIME (ms)", "LOSS"};
+    std::cout << std::endl << "Gradient descent optimizers: time to target loss" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+// L-BFGS against gradient descent, on a logistic regression problem whose
+// labels are drawn from the model's probabilities (so that the classes
+// overlap and the cost has a minimum), and on a noise-free linear one.
+void testLBFGS(size_t sampleSize=5000, size_t numFeatures=10, size_t numGDIterations=2000)
+{
+    std::vector<std::vector<double> > XData = getRandomMatrix(sampleSize, numFeatures, -1, 1).getData();
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            XData[i][j] *= 0.2 + 0.2 * j;
+        }
+    }
+    Matrix X(XData);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    std::vector<double> yBdata(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        yBdata[i] = (getRandom(0, 1) < sigmoid(y[i])) ? 1 : 0;
+    }
+    Vector yB(yBdata);
+    std::vector<std::vector<std::string> > data = {};
+
+    LogisticRegressionSolver GDSolver(1.0, 0, numGDIterations, 0);
+    srand(1);
+    auto tStart = getMicroSeconds();
+    GDSolver.solve(X, yB);
+    auto tEnd = getMicroSeconds();
+    data.push_back({"LOGISTIC", "GD", std::to_string(GDSolver.getIterationCount()), std::to_string(GDSolver.getIterationCount()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(GDSolver.getTrainingLoss())});
+
+    LogisticRegressionLBFGSSolver logisticSolver(10, 1000, 1e-8);
+    tStart = getMicroSeconds();
+    logisticSolver.solve(X, yB);
+    tEnd = getMicroSeconds();
+    data.push_back({"LOGISTIC", "L-BFGS", std::to_string(logisticSolver.getIterationCount()), std::to_string(logisticSolver.getNumEvaluations()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(logisticSolver.getTrainingLoss())});
+    assert(logisticSolver.getIterationCount() < 200);
+    assert(logisticSolver.getTrainingLoss() <= GDSolver.getTrainingLoss() + 1e-9);
+
+    LinearRegressionLBFGSSolver linearSolver(10, 1000, 1e-10);
+    tStart = getMicroSeconds();
+    linearSolver.solve(X, y);
+    tEnd = getMicroSeconds();
+    data.push_back({"LINEAR", "L-BFGS", std::to_string(linearSolver.getIterationCount()), std::to_string(linearSolver.getNumEvaluations()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(linearSolver.getTrainingLoss())});
+    for(size_t j = 0; j < numFeatures; j++)
+    {
+        assert(fabs(linearSolver.getWeights()[j] - weights[j]) < 1e-6);
+    }
+    assert(fabs(linearSolver.getBias() - 0.5) < 1e-6);
+
+    std::vector<std::string> headers = {"", "SOLVER", "ITERATIONS", "EVALUATIONS", "TIME (ms)", "LOSS"};
+    std::cout << std::endl << "L-BFGS test" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+// Newton (IRLS) iterations for logistic regression: on overlapping classes,
+// the minimum must match the one found by L-BFGS; on linearly separable
+// classes, the ridge term must keep the weights finite.
+void testIRLS(size_t sampleSize=5000, size_t numFeatures=10, double ridge=1e-3)
+{
+    // Cholesky solve of a random symmetric positive definite system.
+    size_t n = 2 * numFeatures;
+    std::vector<double> A(n * n, 0);
+    Matrix B = getRandomMatrix(n, n, -1, 1);
+    for(size_t i = 0; i < n; i++)
+    {
+        for(size_t j = 0; j < n; j++)
+        {
+            for(size_t k = 0; k < n; k++)
+            {
+                A[i * n + j] += B.getData()[k][i] * B.getData()[k][j];
+            }
+        }
+        A[i * n + i] += 1;
+    }
+    std::vector<double> b = getRandomVector(n, -1, 1).getData();
+    std::vector<double> x = b;
+    std::vector<double> L = A;
+    assert(choleskyDecompose(L.data(), n));
+    choleskySolve(L.data(), n, x.data());
+    for(size_t i = 0; i < n; i++)
+    {
+        double Ax = 0;
+        for(size_t j = 0; j < n; j++)
+        {
+            Ax += A[i * n + j] * x[j];
+        }
+        assert(fabs(Ax - b[i]) < 1e-9);
+    }
+
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -1, 1);
+    Vector weights = getRandomVector(numFeatures, -3, 3);
+    Vector z = (X * weights) + 0.5;
+    std::vector<double> yNoisyData(sampleSize);
+    std::vector<double> ySeparableData(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        yNoisyData[i] = (getRandom(0, 1) < sigmoid(z[i])) ? 1 : 0;
+        ySeparableData[i] = (z[i] > 0) ? 1 : 0;
+    }
+    Vector yNoisy(yNoisyData);
+    Vector ySeparable(ySeparableData);
+    std::vector<std::vector<std::string> > data = {};
+
+    LogisticRegressionLBFGSSolver LBFGSSolver(10, 1000, 1e-10);
+    auto tStart = getMicroSeconds();
+    LBFGSSolver.solve(X, yNoisy);
+    auto tEnd = getMicroSeconds();
+    data.push_back({"OVERLAPPING", "L-BFGS", std::to_string(LBFGSSolver.getIterationCount()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(LBFGSSolver.getTrainingLoss())});
+
+    LogisticRegressionIRLSSolver IRLSSolver;
+    tStart = getMicroSeconds();
+    IRLSSolver.solve(X, yNoisy);
+    tEnd = getMicroSeconds();
+    data.push_back({"OVERLAPPING", "IRLS", std::to_string(IRLSSolver.getIterationCount()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(IRLSSolver.getTrainingLoss())});
+    assert(IRLSSolver.getIterationCount() < 15);
+    assert(fabs(IRLSSolver.getTrainingLoss() - LBFGSSolver.getTrainingLoss()) < 1e-9);
+
+    LogisticRegressionIRLSSolver ridgeSolver(ridge);
+    tStart = getMicroSeconds();
+    ridgeSolver.solve(X, ySeparable);
+    tEnd = getMicroSeconds();
+    data.push_back({"SEPARABLE", "IRLS (RIDGE " + std::to_string(ridge) + ")", std::to_string(ridgeSolver.getIterationCount()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(ridgeSolver.getTrainingLoss())});
+    assert(ridgeSolver.getIterationCount() < 15);
+    for(size_t j = 0; j < numFeatures; j++)
+    {
+        assert(std::isfinite(ridgeSolver.getWeights()[j]));
+    }
+    Vector yPredicted = ridgeSolver.predict(X);
+    size_t numCorrect = 0;
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        numCorrect += (yPredicted[i] == ySeparable[i]) ? 1 : 0;
+    }
+    assert(numCorrect > 0.95 * sampleSize);
+
+    std::vector<std::string> headers = {"CLASSES", "SOLVER", "ITERATIONS", "TIME (ms)", "LOSS"};
+    std::cout << std::endl << "IRLS test" << std::endl << getTableText(data, headers) << std::endl;
+}
+
+// Multi-class logistic regression (softmax, and one-vs-rest) in a single
+// pass over the rows per iteration, against one binary solver per class.
+void testMulticlassLogisticRegression(size_t sampleSize=5000, size_t numFeatures=20, size_t numClasses=10, size_t numIterations=50)
+{
+    // The kernel's gradient against finite differences of the loss, also
+    // with logits large enough to overflow a naive softmax.
+    Matrix XSmall = getRandomMatrix(200, 5, -1, 1);
+    DenseMatrix denseXSmall(XSmall);
+    std::vector<double> ySmall(200);
+    std::vector<size_t> rows(200);
+    for(size_t i = 0; i < 200; i++)
+    {
+        ySmall[i] = double(i % 4);
+        rows[i] = i;
+    }
+    for(MulticlassLoss loss: {MulticlassLoss::SOFTMAX, MulticlassLoss::ONE_VS_REST})
+    {
+        std::vector<double> parameters = getRandomVector(6 * 4, -1, 1).getData();
+        std::vector<double> gradient(6 * 4);
+        std::vector<double> logits(MULTICLASS_BLOCK_SIZE * 4);
+        double lossSum = computeMulticlassGradient(denseXSmall.getView(), ySmall.data(), rows.data(), 200, 4, parameters.data(), &parameters[20], loss, logits.data(), gradient.data(), &gradient[20]);
+        assert(fabs(lossSum / 200 - computeMulticlassLoss(denseXSmall.getView(), ySmall.data(), 4, parameters.data(), &parameters[20], loss)) < 1e-12);
+        for(size_t k = 0; k < parameters.size(); k++)
+        {
+            std::vector<double> shifted = parameters;
+            shifted[k] += 1e-6;
+            double lossPlus = computeMulticlassLoss(denseXSmall.getView(), ySmall.data(), 4, shifted.data(), &shifted[20], loss);
+            shifted[k] -= 2e-6;
+            double lossMinus = computeMulticlassLoss(denseXSmall.getView(), ySmall.data(), 4, shifted.data(), &shifted[20], loss);
+            assert(fabs((lossPlus - lossMinus) / 2e-6 - gradient[k] / 200) < 1e-6);
+        }
+        // The vectorized kernels (with tails of classes, rows and features).
+        std::vector<double> wideParameters = getRandomVector(8 * 13, -1, 1).getData();
+        Matrix XWide = getRandomMatrix(203, 7, -1, 1);
+        DenseMatrix denseXWide(XWide);
+        std::vector<double> yWide(203);
+        std::vector<size_t> wideRows(203);
+        for(size_t i = 0; i < 203; i++)
+        {
+            yWide[i] = double(i % 13);
+            wideRows[i] = 202 - i;
+        }
+        std::vector<double> scalarGradient(8 * 13);
+        std::vector<double> wideLogits(MULTICLASS_BLOCK_SIZE * 13);
+        double scalarLossSum = computeMulticlassGradient(denseXWide.getView(), yWide.data(), wideRows.data(), 203, 13, wideParameters.data(), &wideParameters[7 * 13], loss, wideLogits.data(), scalarGradient.data(), &scalarGradient[7 * 13], GradientKernel::SCALAR);
+        for(GradientKernel kernel: {GradientKernel::AVX2, GradientKernel::AVX512})
+        {
+            if(!isGradientKernelSupported(kernel))
+            {
+                continue;
+            }
+            std::vector<double> kernelGradient(8 * 13);
+            double kernelLossSum = computeMulticlassGradient(denseXWide.getView(), yWide.data(), wideRows.data(), 203, 13, wideParameters.data(), &wideParameters[7 * 13], loss, wideLogits.data(), kernelGradient.data(), &kernelGradient[7 * 13], kernel);
+            assert(fabs(kernelLossSum - scalarLossSum) < 1e-9);
+            for(size_t k = 0; k < kernelGradient.size(); k++)
+            {
+                assert(fabs(kernelGradient[k] - scalarGradient[k]) < 1e-9);
+            }
+        }
+        for(double& parameter: parameters)
+        {
+            parameter *= 1e4;
+        }
+        lossSum = computeMulticlassGradient(denseXSmall.getView(), ySmall.data(), rows.data(), 200, 4, parameters.data(), &parameters[20], loss, logits.data(), gradient.data(), &gradient[20]);
+        assert(std::isfinite(lossSum));
+        for(double g: gradient)
+        {
+            assert(std::isfinite(g));
+        }
+    }
+
+    // Classes around random centers.
+    Matrix centers = getRandomMatrix(numClasses, numFeatures, -1, 1);
+    std::vector<std::vector<double> > XData = getRandomMatrix(sampleSize, numFeatures, -0.5, 0.5).getData();
+    std::vector<double> yData(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        size_t label = size_t(getRandom(0, numClasses)) % numClasses;
+        yData[i] = double(label);
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            XData[i][j] += centers.getData()[label][j];
+        }
+    }
+    Matrix X(XData);
+    Vector y(yData);
+
+    // The same, bit for bit, whatever the number of threads.
+    MulticlassLogisticRegressionSolver oneThreadSolver(0.5, 0, 10, 0, 1);
+    MulticlassLogisticRegressionSolver fourThreadSolver(0.5, 0, 10, 0, 4);
+    oneThreadSolver.solve(X, y);
+    fourThreadSolver.solve(X, y);
+    assert(oneThreadSolver.getNumClasses() == numClasses);
+    assert(oneThreadSolver.getWeights() == fourThreadSolver.getWeights());
+    assert(oneThreadSolver.getBiases() == fourThreadSolver.getBiases());
+
+    std::vector<std::vector<std::string> > data = {};
+    for(MulticlassLoss loss: {MulticlassLoss::SOFTMAX, MulticlassLoss::ONE_VS_REST})
+    {
+        MulticlassLogisticRegressionSolver solver(0.5, 0, numIterations, 0);
+        solver.setMulticlassLoss(loss);
+        auto tStart = getMicroSeconds();
+        solver.solve(X, y);
+        auto tEnd = getMicroSeconds();
+        assert(solver.getIterationCount() == numIterations);
+        std::vector<size_t> predictions = solver.predictClass(X);
+        size_t numCorrect = 0;
+        for(size_t i = 0; i < sampleSize; i++)
+        {
+            numCorrect += (double(predictions[i]) == yData[i]);
+        }
+        double accuracy = double(numCorrect) / sampleSize;
+        assert(accuracy > 0.9);
+        // Probabilities and predicted classes agree.
+        DenseMatrix denseX(X);
+        std::vector<double> probabilities = solver.getProbabilities(denseX.getView().getRows(0, 10));
+        for(size_t i = 0; i < 10; i++)
+        {
+            const double* rowProbabilities = &probabilities[i * numClasses];
+            assert(size_t(std::max_element(rowProbabilities, rowProbabilities + numClasses) - rowProbabilities) == predictions[i]);
+        }
+        data.push_back({(loss == MulticlassLoss::SOFTMAX) ? "SOFTMAX" : "ONE-VS-REST", "1", std::to_string((tEnd - tStart) / 1000.0), std::to_string(accuracy)});
+    }
+
+    // One-vs-rest with a binary solver per class.
+    std::vector<std::vector<double> > probabilities(numClasses);
+    std::vector<Vector> classTargets(numClasses);
+    auto tStart = getMicroSeconds();
+    for(size_t k = 0; k < numClasses; k++)
+    {
+        std::vector<double> targets(sampleSize);
+        for(size_t i = 0; i < sampleSize; i++)
+        {
+            targets[i] = (yData[i] == double(k)) ? 1 : 0;
+        }
+        classTargets[k] = Vector(targets);
+        LogisticRegressionSolver solver(0.5, 0, numIterations, 0);
+        solver.solve(X, classTargets[k]);
+        probabilities[k] = solver.getProbability(X).getData();
+    }
+    auto tEnd = getMicroSeconds();
+    size_t numCorrect = 0;
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        size_t bestClass = 0;
+        for(size_t k = 1; k < numClasses; k++)
+        {
+            bestClass = (probabilities[k][i] > probabilities[bestClass][i]) ? k : bestClass;
+        }
+        numCorrect += (double(bestClass) == yData[i]);
+    }
+    data.push_back({"BINARY SOLVERS", std::to_string(numClasses), std::to_string((tEnd - tStart) / 1000.0), std::to_string(double(numCorrect) / sampleSize)});
+    std::vector<std::string> headers = {"", "PASSES PER ITERATION", "TIME (ms)", "ACCURACY"};
+    std::cout << std::endl << "Multi-class logistic regression (" << numClasses << " classes, " << numIterations << " iterations)" << std::endl << getTableText(data, headers) << std::endl;
+}
+
+// A sweep over learning rates and L2 penalties, against the same
+// configurations trained one at a time, then over tolerances.
+void testHyperparameterSweep(size_t sampleSize=1000, size_t numFeatures=8, size_t maxNumIterations=200)
+{
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -1, 1);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    std::vector<double> yBData(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        yBData[i] = (y[i] > 0.5) ? 1 : 0;
+    }
+    Vector yB(yBData);
+    // With a tolerance of 0, every model runs until it diverges or reaches
+    // the maximum number of iterations, so that its steps can be compared
+    // with the ones of its own solver.
+    std::vector<SweepConfiguration> configurations = {};
+    for(double learningRate: {0.1, 0.3, 1.0, 3.0, 30.0})
+    {
+        for(double l2Penalty: {0.0, 1e-3, 1e-2})
+        {
+            configurations.push_back({learningRate, 0, l2Penalty});
+        }
+    }
+    std::vector<std::vector<std::string> > data = {};
+    for(bool isLogistic: {false, true})
+    {
+        GradientLoss loss = isLogistic ? GradientLoss::LOGISTIC : GradientLoss::SQUARED_ERROR;
+        const Vector& yUsed = isLogistic ? yB : y;
+        GradientDescentSweepSolver sweepSolver(loss, configurations, 0, maxNumIterations);
+        srand(1);
+        auto tStart = getMicroSeconds();
+        sweepSolver.solve(X, yUsed);
+        auto tEnd = getMicroSeconds();
+        assert(sweepSolver.getNumModels() == configurations.size());
+
+        double separateTime = 0;
+        size_t numDiverged = 0;
+        for(size_t model = 0; model < configurations.size(); model++)
+        {
+            const SweepConfiguration& configuration = sweepSolver.getConfiguration(model);
+            std::shared_ptr<GradientDescentSolver> solver;
+            std::shared_ptr<GradientDescentData> solverData;
+            if(isLogistic)
+            {
+                auto logisticSolver = std::make_shared<LogisticRegressionSolver>(configuration.learningRate, 0, maxNumIterations, 0);
+                solver = logisticSolver;
+                solverData = logisticSolver;
+            }
+            else
+            {
+                auto linearSolver = std::make_shared<LinearRegressionGDSolver>(configuration.learningRate, 0, maxNumIterations, 0);
+                solver = linearSolver;
+                solverData = linearSolver;
+            }
+            solverData->setL2Penalty(configuration.l2Penalty);
+            srand(1);
+            auto tSeparateStart = getMicroSeconds();
+            solver->solve(X, yUsed);
+            separateTime += getMicroSeconds() - tSeparateStart;
+            SweepStatus status = sweepSolver.getStatus(model);
+            if(status == SweepStatus::DIVERGED)
+            {
+                // Dropped out long before the maximum number of iterations.
+                numDiverged++;
+                assert(sweepSolver.getIterationCount(model) < maxNumIterations / 2);
+                continue;
+            }
+            assert(status == SweepStatus::MAX_ITERATIONS);
+            assert(sweepSolver.getIterationCount(model) == maxNumIterations);
+            assert(solver->getIterationCount() == maxNumIterations);
+            std::vector<double> sweepWeights = sweepSolver.getWeights(model);
+            assert(fabs(sweepSolver.getBias(model) - solver->getBias()) < 1e-9);
+            for(size_t j = 0; j < numFeatures; j++)
+            {
+                assert(fabs(sweepWeights[j] - solver->getWeights()[j]) < 1e-9);
+            }
+            assert(fabs(sweepSolver.getTrainingLoss(model) - solver->getTrainingLoss()) < 1e-9);
+        }
+        // The linear models of the largest learning rates diverge.
+        assert(isLogistic || numDiverged >= 3);
+        data.push_back({isLogistic ? "LOGISTIC" : "LINEAR", std::to_string(configurations.size()), std::to_string(numDiverged), std::to_string((tEnd - tStart) / 1000.0), std::to_string(separateTime / 1000.0)});
+    }
+    std::vector<std::string> headers = {"", "MODELS", "DIVERGED", "SWEEP (ms)", "ONE AT A TIME (ms)"};
+    std::cout << std::endl << "Hyperparameter sweep (" << sampleSize << " rows, " << maxNumIterations << " iterations)" << std::endl << getTableText(data, headers) << std::endl;
+
+    // Converged models stop early, at the tolerance of their configuration,
+    // while the others keep iterating.
+    std::vector<SweepConfiguration> tolerances = {{0.3, 1e-2, 0}, {0.3, 1e-4, 0}, {0.3, 0, 0}};
+    GradientDescentSweepSolver toleranceSolver(GradientLoss::SQUARED_ERROR, tolerances, 0, maxNumIterations);
+    toleranceSolver.solve(X, y);
+    assert(toleranceSolver.getStatus(0) == SweepStatus::CONVERGED);
+    assert(toleranceSolver.getStatus(1) == SweepStatus::CONVERGED);
+    assert(toleranceSolver.getStatus(2) == SweepStatus::MAX_ITERATIONS);
+    assert(toleranceSolver.getIterationCount(0) < toleranceSolver.getIterationCount(1));
+    assert(toleranceSolver.getIterationCount(1) < toleranceSolver.getIterationCount(2));
+    assert(toleranceSolver.getTrainingLoss(2) <= toleranceSolver.getTrainingLoss(1));
+    assert(toleranceSolver.getTrainingLoss(1) <= toleranceSolver.getTrainingLoss(0));
+    srand(time(NULL));
+}
+
+// Streams a dataset, written as CSV and in the binary format, from disk in
+// chunks, and trains linear regression with mini-batches over a few epochs.
+void testStreamingGradientDescent(size_t sampleSize=20000, size_t numFeatures=5, size_t chunkSize=3000, size_t numEpochs=3)
+{
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -1, 1);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    DenseMatrix denseX(X);
+    writeXYData(X, y, "StreamTest.csv");
+    assert(writeBinaryData(denseX.getView(), y, "StreamTest.bin"));
+
+    CsvDataSource csvSource("StreamTest.csv");
+    BinaryDataSource binarySource("StreamTest.bin");
+    assert(csvSource.isOpen() && binarySource.isOpen());
+    assert(csvSource.getNumColumns() == numFeatures);
+    assert(binarySource.getNumColumns() == numFeatures);
+
+    // A pass of the prefetcher yields every row once, in order.
+    ChunkPrefetcher prefetcher(binarySource, chunkSize);
+    for(size_t pass = 0; pass < 2; pass++)
+    {
+        prefetcher.start();
+        size_t numRows = 0;
+        const DataChunk* chunk = prefetcher.next();
+        while(chunk != nullptr)
+        {
+            assert(chunk->numRows <= chunkSize);
+            for(size_t r = 0; r < chunk->numRows; r++)
+            {
+                assert(chunk->getView()(r, 0) == denseX.getView()(numRows + r, 0));
+                assert(chunk->targets[r] == y[numRows + r]);
+            }
+            numRows += chunk->numRows;
+            chunk = prefetcher.next();
+        }
+        assert(numRows == sampleSize);
+    }
+    // A chunk of as many rows as the previous one reuses its memory.
+    for(DataSource* source: std::vector<DataSource*>{&csvSource, &binarySource})
+    {
+        DataChunk chunk;
+        source->rewind();
+        assert(source->readChunk(chunkSize, chunk) && chunk.numRows == chunkSize);
+        size_t countBefore = getAllocationCount();
+        assert(source->readChunk(chunkSize, chunk) && chunk.numRows == chunkSize);
+        assert(getAllocationCount() == countBefore);
+    }
+
+    std::vector<std::vector<std::string> > data = {};
+    for(DataSource* source: std::vector<DataSource*>{&csvSource, &binarySource})
+    {
+        LinearRegressionGDSolver solver(0.1, 64, sampleSize * numEpochs, 0);
+        solver.setSeed(1);
+        srand(1);
+        auto tStart = getMicroSeconds();
+        solver.solve(*source, numEpochs, chunkSize);
+        auto tEnd = getMicroSeconds();
+        double maxError = fabs(solver.getBias() - 0.5);
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            maxError = std::max(maxError, fabs(solver.getWeights()[j] - weights[j]));
+        }
+        assert(maxError < 1e-3);
+        // (The training loss is recorded before the chunks are released.)
+        assert(solver.getTrainingLoss() < 1e-6);
+        data.push_back({(source == &csvSource) ? "CSV" : "BINARY", std::to_string(solver.getIterationCount()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(maxError), std::to_string(solver.getTrainingLoss())});
+    }
+    std::remove("StreamTest.csv");
+    std::remove("StreamTest.bin");
+    std::vector<std::string> headers = {"SOURCE", "ITERATIONS", "TIME (ms)", "MAX WEIGHT ERROR", "LOSS"};
+    std::cout << std::endl << "Streaming gradient descent (" << numEpochs << " epochs, chunks of " << chunkSize << " rows)" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+// Online training: partial fits over successive blocks of rows, against
+// streaming them, and against retraining from scratch as new rows arrive
+// (from weights that drift a little with every arrival).
+void testOnlineGradientDescent(size_t sampleSize=20000, size_t numFeatures=5, size_t chunkSize=3000, size_t numArrivals=5)
+{
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -1, 1);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    DenseMatrix denseX(X);
+    assert(writeBinaryData(denseX.getView(), y, "OnlineTest.bin"));
+
+    // Partial fits over the chunks of a stream take the same steps as a
+    // pass over the stream.
+    LinearRegressionGDSolver streamSolver(0.1, 64, sampleSize, 0);
+    streamSolver.setSeed(1);
+    srand(1);
+    BinaryDataSource source("OnlineTest.bin");
+    assert(source.isOpen());
+    streamSolver.solve(source, 1, chunkSize);
+    std::remove("OnlineTest.bin");
+    LinearRegressionGDSolver onlineSolver(0.1, 64, sampleSize, 0);
+    onlineSolver.setSeed(1);
+    srand(1);
+    std::vector<Vector> chunkTargets;
+    for(size_t beginRow = 0; beginRow < sampleSize; beginRow += chunkSize)
+    {
+        size_t endRow = std::min(beginRow + chunkSize, sampleSize);
+        std::vector<double> targets(y.getData().begin() + beginRow, y.getData().begin() + endRow);
+        chunkTargets.push_back(Vector(targets));
+    }
+    for(size_t chunk = 0; chunk < chunkTargets.size(); chunk++)
+    {
+        size_t beginRow = chunk * chunkSize;
+        size_t endRow = std::min(beginRow + chunkSize, sampleSize);
+        onlineSolver.partialFit(denseX.getView().getRows(beginRow, endRow), chunkTargets[chunk]);
+    }
+    assert(onlineSolver.getIterationCount() == streamSolver.getIterationCount());
+    assert(onlineSolver.getBias() == streamSolver.getBias());
+    for(size_t j = 0; j < numFeatures; j++)
+    {
+        assert(onlineSolver.getWeights()[j] == streamSolver.getWeights()[j]);
+    }
+
+    // A warm start from converged weights stops almost at once.
+    for(bool isWarmStart: {false, true})
+    {
+        LinearRegressionGDSolver solver(0.5, 0, 100000, 1e-8);
+        solver.solve(X, y);
+        size_t numColdIterations = solver.getIterationCount();
+        double loss = solver.getTrainingLoss();
+        solver.setWarmStart(isWarmStart);
+        solver.solve(X, y);
+        if(isWarmStart)
+        {
+            assert(solver.getIterationCount() < numColdIterations / 10);
+            assert(solver.getTrainingLoss() <= 2 * loss);
+        }
+        else
+        {
+            assert(solver.getIterationCount() > numColdIterations / 10);
+        }
+    }
+    // Partial fits continue the optimizer state and iteration count of a
+    // solve. A restarted optimizer counts its iterations from the restart:
+    // Adam's moving averages are then corrected for starting from 0, and
+    // its first step is the learning rate on every weight (away from the
+    // minimum, where the gradient is much larger than Adam's epsilon).
+    LinearRegressionGDSolver restartSolver(0.01, 64, 20, 0);
+    restartSolver.setSeed(1);
+    restartSolver.setOptimizer(std::make_shared<AdamOptimizer>());
+    srand(1);
+    restartSolver.solve(X, y);
+    restartSolver.setOptimizer(std::make_shared<AdamOptimizer>());
+    std::vector<double> solveWeights = restartSolver.getWeights().getData();
+    restartSolver.partialFit(denseX.getView().getRows(0, 64), y);
+    assert(restartSolver.getIterationCount() == 21);
+    for(size_t j = 0; j < numFeatures; j++)
+    {
+        assert(fabs(fabs(restartSolver.getWeights()[j] - solveWeights[j]) - 0.01) < 1e-4);
+    }
+    // Near the minimum, the restarted Adam does worse than the continued one.
+    std::vector<double> adamLosses = {};
+    for(bool isOptimizerReset: {false, true})
+    {
+        LinearRegressionGDSolver adamSolver(0.01, 64, 2000, 0);
+        adamSolver.setSeed(1);
+        adamSolver.setOptimizer(std::make_shared<AdamOptimizer>());
+        srand(1);
+        adamSolver.solve(X, y);
+        if(isOptimizerReset)
+        {
+            adamSolver.setOptimizer(std::make_shared<AdamOptimizer>());
+        }
+        adamSolver.partialFit(denseX.getView().getRows(0, 640), y);
+        assert(adamSolver.getIterationCount() == 2010);
+        adamLosses.push_back(adamSolver.getTrainingLoss());
+    }
+    assert(adamLosses[0] < adamLosses[1]);
+
+    // New rows arrive, from slowly drifting weights: partial fits on the
+    // new rows, against retraining on all the rows so far.
+    std::vector<std::vector<std::string> > data = {};
+    LinearRegressionGDSolver partialSolver(0.1, 64, sampleSize, 0);
+    partialSolver.setSeed(1);
+    std::vector<std::vector<double> > allRows = {};
+    std::vector<double> allTargets = {};
+    std::vector<Vector> arrivalTargets(numArrivals);
+    for(size_t arrival = 0; arrival < numArrivals; arrival++)
+    {
+        Matrix XNew = getRandomMatrix(chunkSize, numFeatures, -1, 1);
+        weights = weights + 0.02;
+        arrivalTargets[arrival] = (XNew * weights) + 0.5;
+        const Vector& yNew = arrivalTargets[arrival];
+        const std::vector<std::vector<double> >& newRows = XNew.getData();
+        allRows.insert(allRows.end(), newRows.begin(), newRows.end());
+        allTargets.insert(allTargets.end(), yNew.getData().begin(), yNew.getData().end());
+
+        auto tStart = getMicroSeconds();
+        for(size_t pass = 0; pass < 3; pass++)
+        {
+            partialSolver.partialFit(XNew, yNew);
+        }
+        auto tEnd = getMicroSeconds();
+
+        Matrix XAll(allRows);
+        Vector yAll(allTargets);
+        LinearRegressionGDSolver retrainSolver(0.1, 64, 10 * allRows.size() / 64, 0);
+        retrainSolver.setSeed(1);
+        auto tRetrainStart = getMicroSeconds();
+        retrainSolver.solve(XAll, yAll);
+        auto tRetrainEnd = getMicroSeconds();
+        // Mean squared errors on the new rows.
+        Vector partialErrors = partialSolver.predict(XNew) - yNew;
+        Vector retrainErrors = retrainSolver.predict(XNew) - yNew;
+        double partialError = partialErrors.dot(partialErrors) / chunkSize;
+        double retrainError = retrainErrors.dot(retrainErrors) / chunkSize;
+        assert(partialError < 1e-3);
+        data.push_back({std::to_string(arrival), std::to_string(allRows.size()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(partialError), std::to_string((tRetrainEnd - tRetrainStart) / 1000.0), std::to_string(retrainError)});
+    }
+    std::vector<std::string> headers = {"ARRIVAL", "ROWS SO FAR", "PARTIAL FITS (ms)", "MSE", "RETRAINING (ms)", "MSE"};
+    std::cout << std::endl << "Online gradient descent (" << chunkSize << " new rows per arrival, 3 partial fits)" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+void testHogwildGradientDescent(size_t sampleSize=20000, size_t numFeatures=10, size_t numUpdates=20000, size_t maxNumWorkers=4)
+{
+    Matrix X = getRandomMatrix(sampleSize, numFeatures, -1, 1);
+    Vector weights = getRandomVector(numFeatures, -1, 1);
+    Vector y = (X * weights) + 0.5;
+    auto getMaxError = [&](const LinearRegressionGDSolver& solver)
+    {
+        double maxError = fabs(solver.getBias() - 0.5);
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            maxError = std::max(maxError, fabs(solver.getWeights()[j] - weights[j]));
+        }
+        return maxError;
+    };
+
+    std::vector<std::vector<std::string> > data = {};
+    for(size_t numWorkers = 0; numWorkers <= maxNumWorkers; numWorkers = (numWorkers == 0) ? 1 : 2 * numWorkers)
+    {
+        LinearRegressionGDSolver solver(0.05, 32, numUpdates, 0);
+        solver.setSeed(1);
+        solver.setAsyncWorkers(numWorkers);
+        srand(1);
+        auto tStart = getMicroSeconds();
+        solver.solve(X, y);
+        auto tEnd = getMicroSeconds();
+        // Without tolerance, all the updates are made.
+        assert(solver.getIterationCount() == numUpdates);
+        double maxError = getMaxError(solver);
+        assert(maxError < 1e-3);
+        data.push_back({(numWorkers == 0) ? "SYNCHRONOUS" : std::to_string(numWorkers), std::to_string(solver.getIterationCount()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(maxError)});
+    }
+
+    // The monitor stops the workers on the sampled increments, or on the
+    // training loss.
+    LinearRegressionGDSolver toleranceSolver(0.05, 32, numUpdates, 1e-2);
+    toleranceSolver.setAsyncWorkers(maxNumWorkers);
+    toleranceSolver.solve(X, y);
+    assert(toleranceSolver.getIterationCount() < numUpdates);
+    LinearRegressionGDSolver targetLossSolver(0.05, 32, numUpdates, 0);
+    targetLossSolver.setAsyncWorkers(maxNumWorkers);
+    targetLossSolver.setTargetLoss(1e-4);
+    targetLossSolver.solve(X, y);
+    assert(targetLossSolver.getIterationCount() < numUpdates);
+    assert(targetLossSolver.getTrainingLoss() <= 1e-4);
+
+    // Asynchronous logistic regression.
+    std::vector<bool> yB(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        yB[i] = (y[i] > 0.5);
+    }
+    LogisticRegressionSolver logisticSolver(0.5, 32, numUpdates, 0);
+    logisticSolver.setAsyncWorkers(maxNumWorkers);
+    logisticSolver.solve(X, yB);
+    std::vector<bool> predictions = logisticSolver.predictB(X);
+    size_t numCorrect = 0;
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        numCorrect += (predictions[i] == yB[i]);
+    }
+    assert(numCorrect > 0.97 * sampleSize);
+
+    std::vector<std::string> headers = {"WORKERS", "UPDATES", "TIME (ms)", "MAX WEIGHT ERROR"};
+    std::cout << std::endl << "Hogwild gradient descent (mini-batches of 32 rows)" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+void testSparseGradientDescent(size_t sampleSize=2000, size_t numFeatures=40, size_t numOneHotRows=20000, size_t numSteps=20000)
+{
+    // Mostly zeros: the sparse path gives the dense results, up to rounding.
+    std::vector<std::vector<double> > Xdata(sampleSize, std::vector<double>(numFeatures, 0));
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            Xdata[i][j] = (getRandom() < 0.1) ? getRandom(-1, 1) : 0;
+        }
+    }
+    Matrix X(Xdata);
+    CsrMatrix csrX(X);
+    DenseMatrix denseX(X);
+    assert(csrX.getNumRows() == sampleSize && csrX.getNumColumns() == numFeatures);
+    assert(csrX.getNumNonZeros() < sampleSize * numFeatures / 5);
+    Vector y = (X * getRandomVector(numFeatures, -1, 1)) + 0.5;
+    std::vector<size_t> rows(sampleSize);
+    for(size_t i = 0; i < sampleSize; i++)
+    {
+        rows[i] = i;
+    }
+    std::vector<double> weights = getRandomVector(numFeatures, -1, 1).getData();
+    std::vector<double> gradient(numFeatures);
+    std::vector<double> sparseGradient(numFeatures);
+    double errSum = computeGradient(denseX.getView(), y.getData().data(), rows.data(), sampleSize, weights.data(), 0.5, GradientLoss::LOGISTIC, gradient.data(), GradientKernel::SCALAR);
+    double sparseErrSum = computeGradient(csrX, y.getData().data(), rows.data(), sampleSize, weights.data(), 0.5, GradientLoss::LOGISTIC, sparseGradient.data());
+    assert(std::abs(errSum - sparseErrSum) < 1e-9 * sampleSize);
+    for(size_t j = 0; j < numFeatures; j++)
+    {
+        assert(std::abs(gradient[j] - sparseGradient[j]) < 1e-9 * sampleSize);
+    }
+    // Full batches and mini-batches (the same, from the same seed), with
+    // the L2 decay applied lazily on the sparse path.
+    for(size_t batchSize: {size_t(0), size_t(32)})
+    {
+        LinearRegressionGDSolver denseSolver(0.1, batchSize, 300, 0);
+        LinearRegressionGDSolver sparseSolver(0.1, batchSize, 300, 0);
+        for(LinearRegressionGDSolver* solver: {&denseSolver, &sparseSolver})
+        {
+            solver->setSeed(1);
+            solver->setL2Penalty(1e-2);
+        }
+        srand(1);
+        denseSolver.solve(X, y);
+        srand(1);
+        sparseSolver.solve(csrX, y);
+        assert(std::abs(denseSolver.getBias() - sparseSolver.getBias()) < 1e-9);
+        for(size_t j = 0; j < numFeatures; j++)
+        {
+            assert(std::abs(denseSolver.getWeights()[j] - sparseSolver.getWeights()[j]) < 1e-9);
+        }
+        assert(std::abs(denseSolver.getTrainingLoss() - sparseSolver.getTrainingLoss()) < 1e-9);
+        Vector predictions = denseSolver.predict(X);
+        Vector sparsePredictions = sparseSolver.predict(csrX);
+        for(size_t i = 0; i < sampleSize; i++)
+        {
+            assert(std::abs(predictions[i] - sparsePredictions[i]) < 1e-9);
+        }
+    }
+
+    // One-hot data: every row has 5 informative categories (out of 1000) and
+    // 5 uninformative ones (out of all the others). A step costs the same
+    // whatever the number of columns.
+    std::vector<std::vector<std::string> > data = {};
+    size_t numInformativeColumns = 1000;
+    Vector informativeWeights = getRandomVector(numInformativeColumns, -1, 1);
+    for(size_t numColumns: {size_t(10000), size_t(1000000)})
+    {
+        CsrMatrix oneHotX(numColumns);
+        std::vector<double> yOneHot(numOneHotRows);
+        std::vector<double> values(10, 1);
+        for(size_t i = 0; i < numOneHotRows; i++)
+        {
+            std::vector<uint32_t> columns = {};
+            double z = 0;
+            while(columns.size() < 5)
+            {
+                uint32_t column = uint32_t(getRandom(0, numInformativeColumns));
+                if(std::find(columns.begin(), columns.end(), column) == columns.end())
+                {
+                    columns.push_back(column);
+                    z += informativeWeights[column];
+                }
+            }
+            while(columns.size() < 10)
+            {
+                uint32_t column = uint32_t(getRandom(numInformativeColumns, numColumns));
+                if(std::find(columns.begin(), columns.end(), column) == columns.end())
+                {
+                    columns.push_back(column);
+                }
+            }
+            std::sort(columns.begin(), columns.end());
+            oneHotX.addRow(columns.data(), values.data(), columns.size());
+            yOneHot[i] = (z > 0) ? 1 : 0;
+        }
+        Vector yOneHotVector(yOneHot);
+        LogisticRegressionSolver solver(0.5, 64, numSteps, 0);
+        solver.setL2Penalty(1e-3);
+        auto tStart = getMicroSeconds();
+        solver.solve(oneHotX, yOneHotVector);
+        auto tEnd = getMicroSeconds();
+        std::vector<bool> predictions = solver.predictB(oneHotX);
+        size_t numCorrect = 0;
+        for(size_t i = 0; i < numOneHotRows; i++)
+        {
+            numCorrect += (predictions[i] == (yOneHot[i] == 1));
+        }
+        double accuracy = double(numCorrect) / numOneHotRows;
+        assert(accuracy > 0.9);
+        data.push_back({std::to_string(numColumns), std::to_string(oneHotX.getNumNonZeros()), std::to_string(solver.getIterationCount()), std::to_string((tEnd - tStart) / 1000.0), std::to_string(accuracy)});
+    }
+    std::vector<std::string> headers = {"COLUMNS", "NONZEROS", "STEPS", "TIME (ms)", "ACCURACY"};
+    std::cout << std::endl << "Sparse gradient descent (one-hot rows, mini-batches of 64 rows)" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
+void testIndexShuffler(size_t size=1000, size_t batchSize=64)
+{
+    // Within an epoch, batches never repeat a row.
+    IndexShuffler shuffler(size, batchSize, 7);
+    size_t batchesPerEpoch = size / batchSize;
+    std::vector<size_t> counts(size, 0);
+    for(size_t b = 0; b < batchesPerEpoch; b++)
+    {
+        shuffler.update();
+        assert(shuffler.getEpoch() == 1);
+        for(size_t k = 0; k < batchSize; k++)
+        {
+            assert(shuffler.getIndices()[k] < size);
+            counts[shuffler.getIndices()[k]]++;
+        }
+    }
+    assert(*std::max_element(counts.begin(), counts.end()) == 1);
+    shuffler.update();
+    assert(shuffler.getEpoch() == 2);
+    // Same seed, same batches.
+    IndexShuffler shuffler1(size, batchSize, 11);
+    IndexShuffler shuffler2(size, batchSize, 11);
+    for(size_t b = 0; b < 3 * batchesPerEpoch; b++)
+    {
+        shuffler1.update();
+        shuffler2.update();
+        assert(std::equal(shuffler1.getIndices(), shuffler1.getIndices() + batchSize, shuffler2.getIndices()));
+    }
+    // Without a batch size, all the rows in order.
+    IndexShuffler fullShuffler(size, 0, 7);
+    fullShuffler.update();
+    for(size_t i = 0; i < size; i++)
+    {
+        assert(fullShuffler.getIndex(i) == i);
+    }
+
+    // Bounded draws are (roughly) uniform, and jumped streams differ.
+    RandomGenerator generator(3);
+    std::vector<size_t> binCounts(10, 0);
+    size_t numDraws = 100000;
+    for(size_t k = 0; k < numDraws; k++)
+    {
+        binCounts[generator.getBounded(10)]++;
+    }
+    for(const auto& count: binCounts)
+    {
+        assert(std::abs(double(count) - numDraws / 10.0) < 0.05 * numDraws / 10.0);
+    }
+    RandomGenerator stream0 = generator.getStream(0);
+    RandomGenerator stream1 = generator.getStream(1);
+    assert(stream0.next() != stream1.next());
+
+    // Cost of drawing a batch from a large dataset.
+    size_t largeSize = 5000000;
+    size_t numUpdates = 1000;
+    IndexShuffler largeShuffler(largeSize, batchSize, 1);
+    auto tStart = getMicroSeconds();
+    for(size_t k = 0; k < numUpdates; k++)
+    {
+        largeShuffler.update();
+    }
+    auto tEnd = getMicroSeconds();
+    std::cout << std::endl << "Index shuffler test: " << (tEnd - tStart) / double(numUpdates) << " us per batch of " << batchSize << " rows out of " << largeSize << std::endl;
+}
+
+void testRandomForestRegression(size_t sampleSize=2000, size_t numFeatures=6, size_t numTrees=50)
+{
+    Vector constsA = getRandomVector(numFeatures, -1, 1);
+    Vector constsC = getRandomVector(numFeatures, -1, 1);
+    double constE = getRandom();
+    Matrix X, XTest;
+    Vector y, yTest;
+    getQuadraticRegressionData(sampleSize, constsA, constsC, constE, 0.5, X, y);
+    getQuadraticRegressionData(500, constsA, constsC, constE, 0, XTest, yTest);
+
+    std::vector<std::vector<std::string> > data = {};
+    DecisionTreeRegressionSolver DTSolver(5);
+    auto tStart = getMicroSeconds();
+    DTSolver.solve(X, y);
+    auto tEnd = getMicroSeconds();
+    double treeMSE = getMeanSquareError(yTest, DTSolver.predict(XTest));
+    data.push_back({"SINGLE TREE", std::to_string(treeMSE), std::to_string((tEnd - tStart) / 1000.0)});
+    for(bool useHistograms: {false, true})
+    {
+        RandomForestRegressionSolver RFSolver(numTrees, 5);
+        RFSolver.setHistogramMode(useHistograms);
+        tStart = getMicroSeconds();
+        RFSolver.solve(X, y);
+        tEnd = getMicroSeconds();
+        assert(RFSolver.getNumTrees() == numTrees);
+        Vector yTestPred = RFSolver.predict(XTest);
+        assert(fabs(yTestPred[0] - RFSolver.predict(Vector(XTest.getData()[0]))) < 1.0e-12);
+        double forestMSE = getMeanSquareError(yTest, yTestPred);
+        // Averaging many trees must reduce the variance of a single tree.
+        assert(forestMSE < treeMSE);
+        std::string name = std::string("FOREST ") + (useHistograms ? "(HISTOGRAM)" : "(EXACT)");
+        data.push_back({name, std::to_string(forestMSE), std::to_string((tEnd - tStart) / 1000.0)});
+    }
+    std::vector<std::string> headers = {"", "TEST MSE", "TIME (ms)"};
+    std::cout << std::endl << "Random forest regression test" << std::endl << getTableText(data, headers) << std::endl;
+}
+
+void testGradientBoostedTrees(size_t sampleSize=2000, size_t numFeatures=6)
+{
+    // Noisy data, on which the held-out error turns upward well before the
+    // maximum number of rounds.
+    srand(1);
+    Vector constsA = getRandomVector(numFeatures, -1, 1);
+    Vector constsC = getRandomVector(numFeatures, -1, 1);
+    double constE = getRandom();
+    Matrix X, XValid, XTest;
+    Vector y, yValid, yTest;
+    getQuadraticRegressionData(sampleSize, constsA, constsC, constE, 2, X, y);
+    getQuadraticRegressionData(500, constsA, constsC, constE, 2, XValid, yValid);
+    getQuadraticRegressionData(500, constsA, constsC, constE, 0, XTest, yTest);
+
+    DecisionTreeRegressionSolver DTSolver(5);
+    DTSolver.solve(X, y);
+    double treeMSE = getMeanSquareError(yTest, DTSolver.predict(XTest));
+
+    std::vector<std::vector<std::string> > data = {};
+    data.push_back({"SINGLE TREE", "1", std::to_string(treeMSE), "N/A"});
+    for(double subsampleRatio: {1.0, 0.5})
+    {
+        GradientBoostedTreesSolver GBSolver(1000, 0.1, 3, subsampleRatio, 20);
+        auto tStart = getMicroSeconds();
+        GBSolver.solve(X, y, XValid, yValid);
+        auto tEnd = getMicroSeconds();
+        // Early stopping keeps the round with the lowest held-out error.
+        const std::vector<double>& validErrors = GBSolver.getValidationErrors();
+        assert(validErrors.size() < 1000);
+        assert(GBSolver.getNumTrees() < validErrors.size());
+        assert(validErrors[GBSolver.getNumTrees() - 1] == *std::min_element(validErrors.begin(), validErrors.end()));
+        double boostedMSE = getMeanSquareError(yTest, GBSolver.predict(XTest));
+        assert(boostedMSE < treeMSE);
+        std::string name = "BOOSTED (SUBSAMPLE " + std::to_string(subsampleRatio) + ")";
+        data.push_back({name, std::to_string(GBSolver.getNumTrees()), std::to_string(boostedMSE), std::to_string((tEnd - tStart) / 1000.0)});
+    }
+    std::vector<std::string> headers = {"", "TREES", "TEST MSE", "TIME (ms)"};
+    std::cout << std::endl << "Gradient boosted trees test" << std::endl << getTableText(data, headers) << std::endl;
+    srand(time(NULL));
+}
+
 int main(int argc, char *argv[])
 {
     srand(time(NULL));
     //testLinearRegression(1000, 5);
     //testLogisticRegression(1000, 5);
     testDecisionTreeRegression(1000);
+    testDecisionTreeRegression(1000, 3, true);
+    testParallelDecisionTreeRegression();
+    testLevelWiseDecisionTree();
+    testHistogramSmallNodes();
+    testTreePredictionThroughput();
+    testTreeSourceExport();
+    testMatrixView();
+    testGradientKernels();
+    testSinglePrecision();
+    testParallelGradientDescent();
+    testAllocationFreeGradientDescent();
+    testGradientOptimizers();
+    testLBFGS();
+    testIRLS();
+    testMulticlassLogisticRegression();
+    testHyperparameterSweep();
+    testStreamingGradientDescent();
+    testOnlineGradientDescent();
+    testHogwildGradientDescent();
+    testSparseGradientDescent();
+    testIndexShuffler();
+    testRandomForestRegression();
+    testGradientBoostedTrees();
     return 0;
 }
\ No newline at end of file
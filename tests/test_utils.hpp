@@ -4,6 +4,7 @@
 #include <cassert>
 #include <sstream>
 #include <fstream>
+#include <cstdlib>
 #include "matrix.hpp"
 #include "vectr.hpp"
 
@@ -17,6 +18,11 @@ std::cout << MSG << std::endl; \
 std::cout << "Time elapsed: " << double(tDiff) / 1000.0 << " milliseconds" << std::endl; \
 }
 
+// Number of allocations made through the global operator new so far, so
+// that tests can check that a piece of code does not allocate memory (see
+// allocation_counter.cpp).
+size_t getAllocationCount();
+
 long long getMicroSeconds()
 {
     auto now = std::chrono::high_resolution_clock::now();